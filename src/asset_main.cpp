@@ -0,0 +1,261 @@
+// Skeleton asset tool (no GPU, no window, no OpenGL)
+// ------------------------------------------------------------
+// Writes, inspects and load-tests skeleton asset files (skeleton_asset.h).
+//
+// Commands:
+//   write FILE           makeHuman() and its walk cycle as a clip; with
+//                        --characters N, N variants with their own proportions
+//   info FILE            header, skeletons and clips
+//   load FILE...         map and validate each file --repeat times and pose
+//                        every clip once from the mapping; reports the time
+//   import BVH FILE      convert a BVH capture into a skeleton and one clip,
+//                        streaming (bvh_import.h); reports parse throughput.
+//                        A capture cut off between frames keeps the frames
+//                        present (with a warning); any parse error writes nothing
+//
+// Options:
+//   --characters N       write: skeletons (default 1)
+//   --fps F              write: clip sample rate (default 30)
+//   --seconds S          write: clip length (default one walk cycle, 0.625)
+//   --repeat N           load: times each file is mapped (default 20)
+//   --no-verify          load: skip the checksum (structure is still checked)
+//   --limit N            info: skeletons and clips listed (default 20)
+//   --scale S            import: factor from file units to meters (default 1;
+//                        0.01 for captures in centimeters)
+//   --name NAME          import: skeleton name, the clip is NAME/take
+//                        (default the BVH file name without extension)
+//   --check              import: compare every converted rotation against the
+//                        file's own axis order and report the worst difference
+// ------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bvh_import.h"
+#include "skeleton.h"
+#include "skeleton_asset.h"
+
+struct AssetToolOptions {
+    const char* command = nullptr;
+    std::vector<const char*> files;
+    int characters = 1;
+    float fps = 30.0f;
+    float seconds = 1.0f / 1.6f;
+    int repeat = 20;
+    bool verify = true;
+    int limit = 20;
+    float scale = 1.0f;
+    const char* name = nullptr;
+    bool check = false;
+};
+
+static const char* const kUsage = "Usage: skeleton_asset write FILE [--characters N] [--fps F] [--seconds S]\n"
+                                  "       skeleton_asset info FILE [--limit N]\n"
+                                  "       skeleton_asset load FILE... [--repeat N] [--no-verify]\n"
+                                  "       skeleton_asset import BVH FILE [--scale S] [--name NAME] [--check]\n";
+
+static bool parseArgs(int argc, char** argv, AssetToolOptions& o){
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        const char* next = (i+1 < argc) ? argv[i+1] : nullptr;
+        if(std::strcmp(a, "--characters") == 0 && next){ o.characters = std::max(1, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--fps") == 0 && next){ o.fps = std::max(1.0f, (float)std::atof(next)); ++i; }
+        else if(std::strcmp(a, "--seconds") == 0 && next){ o.seconds = std::max(0.0f, (float)std::atof(next)); ++i; }
+        else if(std::strcmp(a, "--repeat") == 0 && next){ o.repeat = std::max(1, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--no-verify") == 0){ o.verify = false; }
+        else if(std::strcmp(a, "--limit") == 0 && next){ o.limit = std::max(0, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--scale") == 0 && next){ o.scale = (float)std::atof(next); ++i; }
+        else if(std::strcmp(a, "--name") == 0 && next){ o.name = next; ++i; }
+        else if(std::strcmp(a, "--check") == 0){ o.check = true; }
+        else if(a[0] != '-' && !o.command){ o.command = a; }
+        else if(a[0] != '-'){ o.files.push_back(a); }
+        else { std::fprintf(stderr, "Unknown argument '%s'\n", a); return false; }
+    }
+    const bool known = o.command && (std::strcmp(o.command, "write") == 0 || std::strcmp(o.command, "info") == 0 ||
+                                     std::strcmp(o.command, "load") == 0 || std::strcmp(o.command, "import") == 0);
+    const size_t files = o.command && std::strcmp(o.command, "import") == 0 ? 2 : 1;
+    if(!known || o.files.empty() || (std::strcmp(o.command, "load") != 0 && o.files.size() != files)){
+        std::fputs(kUsage, stderr); return false; }
+    return true;
+}
+
+static double nowSeconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ------------------------------------------------------------
+// Commands
+// ------------------------------------------------------------
+static const char* const kHumanBones[] = {
+    "pelvis", "spine", "neck", "head", "hipL", "kneeL", "ankleL", "hipR", "kneeR", "ankleR",
+    "shoulderL", "elbowL", "wristL", "shoulderR", "elbowR", "wristR",
+};
+
+static int cmdWrite(const AssetToolOptions& o){
+    AssetWriter w;
+    if(!w.init(o.files[0])) return 1;
+    const Skeleton human = makeHuman();
+    std::vector<std::string> names(std::begin(kHumanBones), std::end(kHumanBones));
+    names.resize(human.bones.size());
+    const uint32_t frames = std::max(1u, (uint32_t)std::lround(o.seconds * o.fps));
+    std::vector<float> euler(human.bones.size() * 3);
+    const double start = nowSeconds();
+    for(int c=0;c<o.characters;++c){
+        // Variant c: overall scale and limb proportions from a fixed sequence
+        Skeleton s = human;
+        const float scale = 0.85f + 0.3f * (float)((c * 7919) % 101) / 100.0f;
+        const float limbs = 0.9f + 0.2f * (float)((c * 104729) % 97) / 96.0f;
+        for(size_t b=0;b<s.bones.size();++b){
+            const float k = b >= 4 ? scale * limbs : scale;
+            s.bones[b].bindOffset *= k; s.bones[b].length *= k;
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), o.characters > 1 ? "human%04d" : "human", c);
+        const uint32_t skel = w.addSkeleton(name, s, &names);
+        std::snprintf(name + std::strlen(name), sizeof(name) - std::strlen(name), "/walk");
+        w.beginClip(name, skel, o.fps, true);
+        for(uint32_t f=0;f<frames;++f){
+            poseWalk(s, (float)f / o.fps);
+            for(size_t b=0;b<s.bones.size();++b) std::memcpy(&euler[3*b], &s.bones[b].eulerDeg[0], 3 * sizeof(float));
+            w.addFrame(euler.data(), &s.bones[0].bindOffset[0]);
+        }
+        w.endClip();
+    }
+    if(!w.finish()) return 1;
+    std::printf("Wrote %s: %d skeleton(s), %d clip(s) of %u frames, %.1f KB in %.2f ms\n", o.files[0], o.characters,
+                o.characters, frames, (double)w.bytesWritten() / 1024.0, (nowSeconds() - start) * 1000.0);
+    return 0;
+}
+
+static int cmdInfo(const AssetToolOptions& o){
+    AssetFile a;
+    if(!a.init(o.files[0])) return 1;
+    const AssetHeader& h = a.header();
+    std::printf("%s: version %u, %.1f KB, %u skeleton(s), %u clip(s), %.1f KB of names, checksum %016llx\n",
+                o.files[0], h.version, (double)h.fileSize / 1024.0, h.skeletonCount, h.clipCount,
+                (double)h.stringsSize / 1024.0, (unsigned long long)h.checksum);
+    for(uint32_t i=0;i<a.skeletonCount() && (int)i<o.limit;++i){
+        const SkeletonView s = a.skeleton(i);
+        std::printf("  skeleton %-24s %3u bones:", s.name, s.boneCount);
+        for(uint32_t b=0;b<std::min(s.boneCount, 6u);++b) std::printf(" %s", s.boneName(b));
+        std::printf("%s\n", s.boneCount > 6 ? " ..." : "");
+    }
+    if((int)a.skeletonCount() > o.limit) std::printf("  ... %u more skeleton(s)\n", a.skeletonCount() - (uint32_t)o.limit);
+    for(uint32_t i=0;i<a.clipCount() && (int)i<o.limit;++i){
+        const ClipView c = a.clip(i);
+        std::printf("  clip     %-24s %6u frames at %g fps (%.2f s), skeleton %s%s\n", c.name, c.frameCount,
+                    (double)c.frameRate, (double)c.duration(), a.skeleton(c.skeleton).name,
+                    c.rootPositions ? ", root motion" : "");
+    }
+    if((int)a.clipCount() > o.limit) std::printf("  ... %u more clip(s)\n", a.clipCount() - (uint32_t)o.limit);
+    a.destroy();
+    return 0;
+}
+
+static volatile float g_sink;         // keeps the posing from being optimized away
+
+static int cmdLoad(const AssetToolOptions& o){
+    for(const char* file : o.files){
+        double best = 1e30, sum = 0, poseSum = 0;
+        size_t bytes = 0;
+        uint32_t skeletons = 0, clips = 0;
+        for(int r=0;r<o.repeat;++r){
+            const double t0 = nowSeconds();
+            AssetFile a;
+            if(!a.init(file, o.verify)) return 1;
+            const double t1 = nowSeconds();
+            // Use in place: instantiate each clip's skeleton and pose it from the mapping
+            for(uint32_t i=0;i<a.clipCount();++i){
+                const ClipView c = a.clip(i);
+                Skeleton s = a.skeleton(c.skeleton).toSkeleton();
+                c.apply(s, 0.5f * c.duration());
+                g_sink = s.bones.back().eulerDeg.x;
+            }
+            const double t2 = nowSeconds();
+            bytes = a.size; skeletons = a.skeletonCount(); clips = a.clipCount();
+            a.destroy();
+            best = std::min(best, (t1 - t0) * 1000.0);
+            sum += (t1 - t0) * 1000.0;
+            poseSum += (t2 - t1) * 1000.0;
+        }
+        std::printf("%s: %.1f KB, %u skeleton(s), %u clip(s): map + validate%s %.3f ms (best %.3f, %.0f MB/s), "
+                    "first pose of every clip %.3f ms\n",
+                    file, (double)bytes / 1024.0, skeletons, clips, o.verify ? " + checksum" : "", sum / o.repeat, best,
+                    (double)bytes / (best * 1e-3) / (1024.0 * 1024.0), poseSum / o.repeat);
+    }
+    return 0;
+}
+
+// Angle in degrees between two rotations, from |A - B| = 2 sqrt(2) sin(angle / 2),
+// which stays accurate for the tiny angles a correct conversion leaves
+static double rotationAngleDeg(const glm::mat4& a, const glm::mat4& b){
+    double sq = 0;
+    for(int c=0;c<3;++c) for(int r=0;r<3;++r){ const double d = (double)a[c][r] - (double)b[c][r]; sq += d * d; }
+    return glm::degrees(2.0 * std::asin(std::min(1.0, std::sqrt(sq) / (2.0 * std::sqrt(2.0)))));
+}
+
+static int cmdImport(const AssetToolOptions& o){
+    const double start = nowSeconds();
+    BvhReader r;
+    if(!r.init(o.files[0], o.scale)) return 1;
+    std::string name = o.name ? o.name : o.files[0];
+    if(!o.name){
+        const size_t slash = name.find_last_of("/\\");
+        if(slash != std::string::npos) name.erase(0, slash + 1);
+        const size_t dot = name.rfind('.');
+        if(dot != std::string::npos && dot > 0) name.erase(dot);
+    }
+    AssetWriter w;
+    if(!w.init(o.files[1])) return 1;
+    const uint32_t skel = w.addSkeleton(name.c_str(), r.skeleton, &r.boneNames);
+    std::vector<float> euler(r.skeleton.bones.size() * 3);
+    float root[3] = {};
+    uint32_t frames = 0;
+    double worstDeg = 0;
+    if(r.frameCount > 0){
+        w.beginClip((name + "/take").c_str(), skel, 1.0f / r.frameTime, r.hasRootPosition);
+        while(r.nextFrame(euler.data(), root)){
+            w.addFrame(euler.data(), root);
+            ++frames;
+            if(!o.check) continue;
+            for(size_t b=0;b<r.skeleton.bones.size();++b){
+                const glm::vec3 e(euler[3*b], euler[3*b + 1], euler[3*b + 2]);
+                worstDeg = std::max(worstDeg, rotationAngleDeg(Skeleton::rotXYZ(e), r.fileRotation(b)));
+            }
+        }
+        w.endClip();
+    }
+    if(r.failed()){ w.abandon(); std::fprintf(stderr, "%s not written\n", o.files[1]); return 1; }
+    if(frames < r.frameCount)
+        std::fprintf(stderr, "%s: %u of %u declared frames present\n", o.files[0], frames, r.frameCount);
+    if(!w.finish()) return 1;
+    const double seconds = nowSeconds() - start;
+    std::printf("Imported %s: %zu joints, %u frames at %g fps (%.1f s of capture)%s -> %s, %.1f KB\n",
+                o.files[0], r.skeleton.bones.size(), frames, 1.0 / r.frameTime, frames * r.frameTime,
+                r.hasRootPosition ? ", root motion" : "", o.files[1], (double)w.bytesWritten() / 1024.0);
+    std::printf("  %.2f MB in %.3f s: %.1f MB/s%s\n", (double)r.bytesRead / (1024.0 * 1024.0), seconds,
+                (double)r.bytesRead / (1024.0 * 1024.0) / seconds, o.check ? " (with --check)" : "");
+    if(o.check) std::printf("  worst rotation difference from the file's axis order: %.3g degrees\n", worstDeg);
+    r.destroy();
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Main
+// ------------------------------------------------------------
+int main(int argc, char** argv){
+    AssetToolOptions opts;
+    if(!parseArgs(argc, argv, opts)) return 2;
+    if(std::strcmp(opts.command, "write") == 0) return cmdWrite(opts);
+    if(std::strcmp(opts.command, "info") == 0) return cmdInfo(opts);
+    if(std::strcmp(opts.command, "import") == 0) return cmdImport(opts);
+    return cmdLoad(opts);
+}
@@ -0,0 +1,188 @@
+// CPU kernel microbenchmarks (no GPU, no window, no OpenGL)
+// ------------------------------------------------------------
+// Times the skeleton hot paths in isolation: Skeleton::rotXYZ,
+// Skeleton::updateGlobals, animateWalk, buildSkeletonLines and
+// buildHeadSphereTris over a range of tessellations. Each benchmark is warmed
+// up, then measured as a set of samples; a sample runs enough iterations to
+// last --min-time so clock resolution does not matter. Results are reported
+// per call and per bone or vertex; --json also writes every raw sample.
+//
+// Options:
+//   --reps N             samples per benchmark (default 30)
+//   --warmup N           unmeasured samples first (default 5)
+//   --min-time MS        minimum duration of one sample (default 2)
+//   --filter TEXT        only benchmarks whose name contains TEXT
+//   --json FILE          write results and raw samples as JSON
+// ------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "skeleton.h"
+
+struct BenchOptions {
+    int reps = 30;
+    int warmup = 5;
+    double minTimeMs = 2.0;
+    const char* filter = nullptr;
+    const char* json = nullptr;
+};
+
+static bool parseArgs(int argc, char** argv, BenchOptions& o){
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        const char* next = (i+1 < argc) ? argv[i+1] : nullptr;
+        if(std::strcmp(a, "--reps") == 0 && next){ o.reps = std::max(1, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--warmup") == 0 && next){ o.warmup = std::max(0, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--min-time") == 0 && next){ o.minTimeMs = std::atof(next); ++i; }
+        else if(std::strcmp(a, "--filter") == 0 && next){ o.filter = next; ++i; }
+        else if(std::strcmp(a, "--json") == 0 && next){ o.json = next; ++i; }
+        else { std::fprintf(stderr, "Unknown argument '%s'\n", a); return false; }
+    }
+    return true;
+}
+
+// Keeps a result alive without a store the compiler can see through
+template<class T>
+static void doNotOptimize(const T& v){
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&v) : "memory");
+#else
+    static volatile const void* sink; sink = &v;
+#endif
+}
+
+// ------------------------------------------------------------
+// Measurement
+// ------------------------------------------------------------
+struct BenchResult {
+    std::string name;
+    const char* unit;                   // "bone", "vertex", "call"
+    double unitsPerOp;
+    int64_t itersPerSample;
+    std::vector<double> samples;        // ns per op
+    double min, median, mean, stddev, max;
+};
+
+static double nowNs(){
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// op(n) runs the kernel n times
+static BenchResult run(const BenchOptions& o, std::string name, const char* unit, double unitsPerOp,
+                       const std::function<void(int64_t)>& op){
+    // Calibrate: double the iteration count until one sample lasts minTime
+    int64_t iters = 1;
+    for(;;){
+        const double t0 = nowNs();
+        op(iters);
+        if(nowNs() - t0 >= o.minTimeMs * 1e6 || iters >= ((int64_t)1 << 40)) break;
+        iters *= 2;
+    }
+    for(int i=0;i<o.warmup;++i) op(iters);
+
+    BenchResult r{std::move(name), unit, unitsPerOp, iters, {}, 0, 0, 0, 0, 0};
+    r.samples.reserve((size_t)o.reps);
+    for(int i=0;i<o.reps;++i){
+        const double t0 = nowNs();
+        op(iters);
+        r.samples.push_back((nowNs() - t0) / (double)iters);
+    }
+    std::vector<double> sorted = r.samples;
+    std::sort(sorted.begin(), sorted.end());
+    const size_t n = sorted.size();
+    r.min = sorted.front(); r.max = sorted.back();
+    r.median = n % 2 ? sorted[n/2] : 0.5 * (sorted[n/2 - 1] + sorted[n/2]);
+    double sum = 0; for(double s : sorted) sum += s;
+    r.mean = sum / (double)n;
+    double var = 0; for(double s : sorted) var += (s - r.mean) * (s - r.mean);
+    r.stddev = n > 1 ? std::sqrt(var / (double)(n - 1)) : 0.0;
+    return r;
+}
+
+static void printResult(const BenchResult& r){
+    std::printf("%-32s %10.1f %10.1f %10.1f %7.2f%% %10.2f ns/%s\n", r.name.c_str(), r.median, r.min, r.max,
+                r.mean > 0 ? 100.0 * r.stddev / r.mean : 0.0, r.median / r.unitsPerOp, r.unit);
+}
+
+static bool writeJson(const char* path, const BenchOptions& o, const std::vector<BenchResult>& results){
+    std::FILE* f = std::fopen(path, "w");
+    if(!f){ std::fprintf(stderr, "Failed to open %s for writing\n", path); return false; }
+    std::fprintf(f, "{\n  \"tool\": \"skeleton_bench\",\n  \"reps\": %d,\n  \"warmup\": %d,\n  \"min_time_ms\": %g,\n  \"benchmarks\": [\n",
+                 o.reps, o.warmup, o.minTimeMs);
+    for(size_t i=0;i<results.size();++i){
+        const BenchResult& r = results[i];
+        std::fprintf(f, "    {\"name\": \"%s\", \"unit\": \"%s\", \"units_per_op\": %g, \"iterations_per_sample\": %lld,\n"
+                        "     \"median_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f,\n"
+                        "     \"ns_per_unit\": %.4f,\n     \"samples_ns\": [",
+                     r.name.c_str(), r.unit, r.unitsPerOp, (long long)r.itersPerSample,
+                     r.median, r.mean, r.stddev, r.min, r.max, r.median / r.unitsPerOp);
+        for(size_t k=0;k<r.samples.size();++k) std::fprintf(f, "%s%.3f", k ? ", " : "", r.samples[k]);
+        std::fprintf(f, "]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    const bool ok = std::fclose(f) == 0;
+    if(!ok) std::fprintf(stderr, "Failed to write %s\n", path);
+    return ok;
+}
+
+// ------------------------------------------------------------
+// Main
+// ------------------------------------------------------------
+int main(int argc, char** argv){
+    BenchOptions opts;
+    if(!parseArgs(argc, argv, opts)) return 1;
+
+    Skeleton skel = makeHuman();
+    const double bones = (double)skel.bones.size();
+    animateWalk(skel, 0.3f);
+    std::vector<BenchResult> results;
+    auto bench = [&](std::string name, const char* unit, double units, const std::function<void(int64_t)>& op){
+        if(opts.filter && name.find(opts.filter) == std::string::npos) return;
+        results.push_back(run(opts, std::move(name), unit, units, op));
+        printResult(results.back());
+    };
+
+    std::printf("%-32s %10s %10s %10s %8s %10s\n", "benchmark (ns per call)", "median", "min", "max", "cv", "per unit");
+
+    bench("rotXYZ", "call", 1, [&](int64_t n){
+        glm::vec3 deg(10.0f, 20.0f, 30.0f);
+        for(int64_t i=0;i<n;++i){
+            glm::mat4 m = Skeleton::rotXYZ(deg);
+            doNotOptimize(m);
+            deg.x += 0.01f;
+        }
+    });
+    bench("updateGlobals", "bone", bones, [&](int64_t n){
+        for(int64_t i=0;i<n;++i){ skel.updateGlobals(); doNotOptimize(skel.bones.back().global); }
+    });
+    bench("animateWalk", "bone", bones, [&](int64_t n){
+        float t = 0.0f;
+        for(int64_t i=0;i<n;++i){ animateWalk(skel, t); t += 1.0f / 60.0f; doNotOptimize(skel.bones.back().global); }
+    });
+    const double lineVerts = (double)buildSkeletonLines(skel).size();
+    bench("buildSkeletonLines", "vertex", lineVerts, [&](int64_t n){
+        for(int64_t i=0;i<n;++i){ std::vector<LineVertex> v = buildSkeletonLines(skel); doNotOptimize(v.data()); }
+    });
+    const int tess[][2] = { {8, 12}, {16, 24}, {32, 48}, {64, 96} };
+    for(const auto& st : tess){
+        const double verts = (double)buildHeadSphereTris(skel, st[0], st[1]).size();
+        char name[64]; std::snprintf(name, sizeof(name), "buildHeadSphereTris/%dx%d", st[0], st[1]);
+        bench(name, "vertex", verts, [&](int64_t n){
+            for(int64_t i=0;i<n;++i){ std::vector<TriVertex> v = buildHeadSphereTris(skel, st[0], st[1]); doNotOptimize(v.data()); }
+        });
+    }
+
+    if(opts.json && !writeJson(opts.json, opts, results)) return 1;
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "bone_palette.h"
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/packing.hpp>
+
+const char* paletteFormatName(PaletteFormat f){
+    switch(f){
+        case PaletteFormat::Mat4:          return "mat4";
+        case PaletteFormat::QuatTrans:     return "quat";
+        case PaletteFormat::QuatTransHalf: return "half";
+    }
+    return "?";
+}
+
+bool parsePaletteFormat(const char* s, PaletteFormat& out){
+    if(std::strcmp(s, "mat4") == 0){ out = PaletteFormat::Mat4; return true; }
+    if(std::strcmp(s, "quat") == 0){ out = PaletteFormat::QuatTrans; return true; }
+    if(std::strcmp(s, "half") == 0){ out = PaletteFormat::QuatTransHalf; return true; }
+    return false;
+}
+
+size_t paletteBytesPerBone(PaletteFormat f){
+    switch(f){
+        case PaletteFormat::Mat4:          return 64;
+        case PaletteFormat::QuatTrans:     return 32;
+        case PaletteFormat::QuatTransHalf: return 16;
+    }
+    return 64;
+}
+
+int paletteTexelsPerBone(PaletteFormat f){
+    return f == PaletteFormat::Mat4 ? 4 : 2;
+}
+
+bool isRigid(const glm::mat4& m, float eps){
+    glm::vec3 x(m[0]), y(m[1]), z(m[2]);
+    if(std::abs(glm::dot(x,x) - 1.0f) > eps) return false;
+    if(std::abs(glm::dot(y,y) - 1.0f) > eps) return false;
+    if(std::abs(glm::dot(z,z) - 1.0f) > eps) return false;
+    if(std::abs(glm::dot(x,y)) > eps || std::abs(glm::dot(y,z)) > eps || std::abs(glm::dot(z,x)) > eps) return false;
+    if(m[0][3] != 0.0f || m[1][3] != 0.0f || m[2][3] != 0.0f || m[3][3] != 1.0f) return false;
+    return glm::dot(glm::cross(x, y), z) > 0.0f;
+}
+
+// Rotation part as a unit quaternion with w >= 0 (q and -q are the same rotation)
+static glm::quat rigidRotation(const glm::mat4& m){
+    glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(m)));
+    return q.w < 0.0f ? -q : q;
+}
+
+bool encodePalette(PaletteFormat f, const glm::mat4* src, size_t count, void* dst){
+    if(f == PaletteFormat::Mat4){
+        std::memcpy(dst, src, count * sizeof(glm::mat4));
+        return true;
+    }
+    if(f == PaletteFormat::QuatTrans){
+        float* out = static_cast<float*>(dst);
+        for(size_t i=0;i<count;++i, out+=8){
+            const glm::mat4& m = src[i];
+            if(!isRigid(m)) return false;
+            glm::quat q = rigidRotation(m);
+            out[0] = q.x; out[1] = q.y; out[2] = q.z; out[3] = q.w;
+            out[4] = m[3].x; out[5] = m[3].y; out[6] = m[3].z; out[7] = 1.0f;
+        }
+        return true;
+    }
+    uint64_t* out = static_cast<uint64_t*>(dst);
+    for(size_t i=0;i<count;++i, out+=2){
+        const glm::mat4& m = src[i];
+        if(!isRigid(m)) return false;
+        glm::quat q = rigidRotation(m);
+        out[0] = glm::packHalf4x16(glm::vec4(q.x, q.y, q.z, q.w));
+        out[1] = glm::packHalf4x16(glm::vec4(m[3].x, m[3].y, m[3].z, 1.0f));
+    }
+    return true;
+}
+
+// Both compact formats decode the same way; the texture buffer's internal
+// format (RGBA32F vs RGBA16F) takes care of the half-float expansion.
+const char* kPaletteDecodeGLSL = R"GLSL(
+mat4 paletteFetch(samplerBuffer pal, int format, int bone){
+    if(format == 0){
+        int b = bone * 4;
+        return mat4(texelFetch(pal, b), texelFetch(pal, b+1), texelFetch(pal, b+2), texelFetch(pal, b+3));
+    }
+    vec4 q = normalize(texelFetch(pal, bone * 2));
+    vec3 t = texelFetch(pal, bone * 2 + 1).xyz;
+    float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+    float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+    float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+    return mat4(
+        vec4(1.0 - 2.0*(yy+zz), 2.0*(xy+wz),       2.0*(xz-wy),       0.0),
+        vec4(2.0*(xy-wz),       1.0 - 2.0*(xx+zz), 2.0*(yz+wx),       0.0),
+        vec4(2.0*(xz+wy),       2.0*(yz-wx),       1.0 - 2.0*(xx+yy), 0.0),
+        vec4(t, 1.0));
+}
+)GLSL";
@@ -0,0 +1,33 @@
+// Bone palette encodings for uploading joint transforms to the GPU.
+//
+//   Mat4          64 bytes/bone  lossless, handles scale/shear
+//   QuatTrans     32 bytes/bone  fp32 unit quaternion + translation
+//   QuatTransHalf 16 bytes/bone  same, packed as half floats
+//
+// The compact formats only represent rigid transforms; encodePalette()
+// reports when it meets anything else so the caller can fall back to Mat4.
+// All formats are read in the vertex shader through a texture buffer with
+// paletteFetch() from kPaletteDecodeGLSL.
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+enum class PaletteFormat { Mat4 = 0, QuatTrans = 1, QuatTransHalf = 2 };
+
+const char* paletteFormatName(PaletteFormat f);
+bool parsePaletteFormat(const char* s, PaletteFormat& out);
+
+size_t paletteBytesPerBone(PaletteFormat f);
+int paletteTexelsPerBone(PaletteFormat f);   // RGBA texels in the texture buffer
+
+// True if m is rotation + translation only (orthonormal basis, det > 0).
+bool isRigid(const glm::mat4& m, float eps = 1e-3f);
+
+// Encode count transforms into dst (count * paletteBytesPerBone(f) bytes).
+// Returns false if f is a compact format and a non-rigid transform was found;
+// dst is then partially written and the caller should re-encode as Mat4.
+bool encodePalette(PaletteFormat f, const glm::mat4* src, size_t count, void* dst);
+
+// GLSL (330) helper: mat4 paletteFetch(samplerBuffer pal, int format, int bone)
+extern const char* kPaletteDecodeGLSL;
@@ -0,0 +1,263 @@
+#include "bvh_import.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// ------------------------------------------------------------
+// Input
+// ------------------------------------------------------------
+static bool isSpace(char c){ return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+
+bool BvhReader::fail(const char* what){
+    if(!error) std::fprintf(stderr, "%s: %s (near byte %llu)\n", path.c_str(), what,
+                            (unsigned long long)(bytesRead - (end - pos)));
+    error = true;
+    return false;
+}
+
+// Moves the unread tail to the front and reads after it; false once nothing more arrives
+bool BvhReader::refill(){
+    if(eof) return false;
+    std::memmove(buf.data(), buf.data() + pos, end - pos);
+    end -= pos; pos = 0;
+    const size_t n = std::fread(buf.data() + end, 1, buf.size() - end, f);
+    if(n == 0){ eof = true; return false; }
+    end += n; bytesRead += n;
+    return true;
+}
+
+bool BvhReader::skipSpace(){
+    for(;;){
+        while(pos < end && isSpace(buf[pos])) ++pos;
+        if(pos < end) return true;
+        if(!refill()) return false;
+    }
+}
+
+// Next whitespace-separated word, as a view into the buffer valid until the next read
+bool BvhReader::token(const char*& s, size_t& n){
+    if(!skipSpace()) return false;
+    size_t i = pos;
+    for(;;){
+        while(i < end && !isSpace(buf[i])) ++i;
+        if(i < end || eof) break;
+        if(pos == 0 && end == buf.size()) return fail("token longer than the read buffer");
+        const size_t scanned = i - pos;
+        if(!refill()) { i = end; break; }
+        i = pos + scanned;
+    }
+    s = buf.data() + pos; n = i - pos;
+    pos = i;
+    return true;
+}
+
+bool BvhReader::expect(const char* word){
+    const char* s; size_t n;
+    if(!token(s, n) || n != std::strlen(word) || std::memcmp(s, word, n) != 0){
+        std::string what = std::string("expected '") + word + "'";
+        return fail(what.c_str());
+    }
+    return true;
+}
+
+// Decimal with optional sign, fraction and exponent, parsed where it lies:
+// up to 19 significant digits in an integer, then one exact power-of-ten
+// scale (correctly rounded up to 1e22, like the values BVH files hold)
+bool BvhReader::number(float& out){
+    if(!skipSpace()) return fail("unexpected end of file");
+    if(end - pos < 64 && !eof) refill();
+    static const double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* p = buf.data() + pos;
+    const char* e = buf.data() + end;
+    bool neg = false;
+    if(p < e && (*p == '-' || *p == '+')){ neg = *p == '-'; ++p; }
+    uint64_t m = 0;
+    int digits = 0, exp10 = 0;
+    bool any = false;
+    for(; p < e && (unsigned)(*p - '0') < 10; ++p){
+        any = true;
+        if(digits < 19){ m = m * 10 + (uint64_t)(*p - '0'); if(m) ++digits; }
+        else ++exp10;
+    }
+    if(p < e && *p == '.'){
+        for(++p; p < e && (unsigned)(*p - '0') < 10; ++p){
+            any = true;
+            if(digits < 19){ m = m * 10 + (uint64_t)(*p - '0'); if(m) ++digits; --exp10; }
+        }
+    }
+    if(!any) return fail("expected a number");
+    if(p < e && (*p == 'e' || *p == 'E')){
+        ++p;
+        bool eneg = false;
+        if(p < e && (*p == '-' || *p == '+')){ eneg = *p == '-'; ++p; }
+        int x = 0;
+        bool xdigits = false;
+        for(; p < e && (unsigned)(*p - '0') < 10; ++p){ if(x < 10000) x = x * 10 + (*p - '0'); xdigits = true; }
+        if(!xdigits) return fail("malformed number");
+        exp10 += eneg ? -x : x;
+    }
+    if(p < e && !isSpace(*p)) return fail("malformed number");
+    double v = (double)m;
+    if(exp10 >= -22 && exp10 <= 22) v = exp10 < 0 ? v / kPow10[-exp10] : v * kPow10[exp10];
+    else v *= std::pow(10.0, (double)exp10);
+    out = (float)(neg ? -v : v);
+    pos = (size_t)(p - buf.data());
+    return true;
+}
+
+// ------------------------------------------------------------
+// HIERARCHY
+// ------------------------------------------------------------
+static bool is(const char* s, size_t n, const char* word){ return n == std::strlen(word) && std::memcmp(s, word, n) == 0; }
+
+int BvhReader::joint(int parent, int depth){
+    if(depth > 256){ fail("hierarchy nested too deeply"); return -1; }
+    const char* s; size_t n;
+    if(!token(s, n)){ fail("expected a joint name"); return -1; }
+    const int bone = skeleton.addBone(parent, glm::vec3(0), 0.0f);
+    boneNames.emplace_back(s, n);
+    channels.emplace_back();
+    if(!expect("{")) return -1;
+    for(;;){
+        if(!token(s, n)){ fail("unexpected end of file in HIERARCHY"); return -1; }
+        if(is(s, n, "}")) return bone;
+        if(is(s, n, "OFFSET")){
+            glm::vec3 o;
+            if(!number(o.x) || !number(o.y) || !number(o.z)) return -1;
+            skeleton.bones[(size_t)bone].bindOffset = o * scale;
+        } else if(is(s, n, "CHANNELS")){
+            float count;
+            if(!number(count)) return -1;
+            if(count < 0 || count > 6 || count != std::floor(count)){ fail("bad channel count"); return -1; }
+            Channels& c = channels[(size_t)bone];
+            c.first = channelCount; c.count = (int)count;
+            channelCount += c.count;
+            int rotations = 0;
+            for(int i=0;i<c.count;++i){
+                if(!token(s, n) || n != 9 || s[0] < 'X' || s[0] > 'Z'){ fail("unknown channel"); return -1; }
+                const int axis = s[0] - 'X';
+                if(std::memcmp(s + 1, "rotation", 8) == 0 && rotations < 3){
+                    c.rotAxis[rotations] = (int8_t)axis; c.rotSlot[rotations] = (int8_t)i; ++rotations;
+                } else if(std::memcmp(s + 1, "position", 8) == 0){
+                    c.posSlot[axis] = (int8_t)i;
+                } else { fail("unknown channel"); return -1; }
+            }
+            c.zyx = rotations == 3 && c.rotAxis[0] == 2 && c.rotAxis[1] == 1 && c.rotAxis[2] == 0;
+            if(bone == 0 && (c.posSlot[0] >= 0 || c.posSlot[1] >= 0 || c.posSlot[2] >= 0)) hasRootPosition = true;
+        } else if(is(s, n, "JOINT")){
+            const int child = joint(bone, depth + 1);
+            if(child < 0) return -1;
+            // Engine bones have a length rather than an end point: reach the first child
+            Bone& b = skeleton.bones[(size_t)bone];
+            if(b.length == 0.0f) b.length = glm::length(skeleton.bones[(size_t)child].bindOffset);
+        } else if(is(s, n, "End")){
+            glm::vec3 o;
+            if(!expect("Site") || !expect("{") || !expect("OFFSET") || !number(o.x) || !number(o.y) || !number(o.z) ||
+               !expect("}"))
+                return -1;
+            Bone& b = skeleton.bones[(size_t)bone];
+            if(b.length == 0.0f) b.length = glm::length(o) * scale;
+        } else { fail("unexpected word in HIERARCHY"); return -1; }
+    }
+}
+
+bool BvhReader::init(const char* p, float s){
+    destroy();
+    path = p; scale = s;
+    f = std::fopen(p, "rb");
+    if(!f){ std::fprintf(stderr, "Failed to open %s\n", p); return false; }
+    buf.resize(kBufferSize);
+    if(!expect("HIERARCHY")) return false;
+    const char* t; size_t n;
+    for(;;){
+        if(!token(t, n)) return fail("missing MOTION");
+        if(is(t, n, "MOTION")) break;
+        if(!is(t, n, "ROOT")) return fail("expected ROOT or MOTION");
+        if(joint(-1, 0) < 0) return false;
+    }
+    if(skeleton.bones.empty()) return fail("no joints");
+    float frames, dt;
+    if(!expect("Frames:") || !number(frames) || !expect("Frame") || !expect("Time:") || !number(dt)) return false;
+    if(frames < 0 || frames > 4294967295.0f || !(dt > 0)) return fail("bad MOTION header");
+    frameCount = (uint32_t)frames;
+    frameTime = dt;
+    raw.assign((size_t)channelCount, 0.0f);
+    return true;
+}
+
+void BvhReader::destroy(){
+    if(f) std::fclose(f);
+    f = nullptr;
+    skeleton.bones.clear(); boneNames.clear(); channels.clear();
+    buf.clear(); raw.clear();
+    pos = end = 0; eof = error = false;
+    channelCount = 0; frameCount = 0; framesRead = 0; frameTime = 0;
+    hasRootPosition = false; bytesRead = 0;
+}
+
+// ------------------------------------------------------------
+// MOTION
+// ------------------------------------------------------------
+// R = Rz * Ry * Rx, the order of Skeleton::rotXYZ, from a unit quaternion
+static glm::vec3 eulerXYZFromQuat(float w, float x, float y, float z){
+    const float r00 = 1 - 2*(y*y + z*z), r01 = 2*(x*y - w*z);
+    const float r10 = 2*(x*y + w*z),     r11 = 1 - 2*(x*x + z*z);
+    const float r20 = 2*(x*z - w*y),     r21 = 2*(y*z + w*x), r22 = 1 - 2*(x*x + y*y);
+    glm::vec3 e;
+    if(std::fabs(r20) < 0.999999f){
+        e.y = std::asin(-r20);
+        e.x = std::atan2(r21, r22);
+        e.z = std::atan2(r10, r00);
+    } else {                                            // gimbal lock: all twist goes to X
+        e.y = r20 < 0 ? 1.5707963f : -1.5707963f;
+        e.x = r20 < 0 ? std::atan2(r01, r11) : std::atan2(-r01, r11);
+        e.z = 0;
+    }
+    return glm::degrees(e);
+}
+
+bool BvhReader::nextFrame(float* eulerDeg, float* rootPosition){
+    if(error || framesRead >= frameCount) return false;
+    // A file that stops between frames ends the clip early; one that stops inside a frame is malformed
+    if(channelCount > 0 && !skipSpace()) return false;
+    for(int i=0;i<channelCount;++i) if(!number(raw[(size_t)i])) return false;
+    ++framesRead;
+    for(size_t b=0;b<channels.size();++b){
+        const Channels& c = channels[b];
+        const float* v = raw.data() + c.first;
+        float* e = eulerDeg + 3*b;
+        if(c.zyx){ e[0] = v[c.rotSlot[2]]; e[1] = v[c.rotSlot[1]]; e[2] = v[c.rotSlot[0]]; continue; }
+        // Compose the file's order as quaternions, then read the XYZ angles back off
+        float qw = 1, qx = 0, qy = 0, qz = 0;
+        for(int k=0;k<3 && c.rotAxis[k] >= 0;++k){
+            const float h = glm::radians(v[c.rotSlot[k]]) * 0.5f;
+            const float cs = std::cos(h), sn = std::sin(h);
+            const float ax = c.rotAxis[k] == 0 ? sn : 0, ay = c.rotAxis[k] == 1 ? sn : 0, az = c.rotAxis[k] == 2 ? sn : 0;
+            const float w = qw*cs - qx*ax - qy*ay - qz*az;
+            const float x = qw*ax + qx*cs + qy*az - qz*ay;
+            const float y = qw*ay - qx*az + qy*cs + qz*ax;
+            const float z = qw*az + qx*ay - qy*ax + qz*cs;
+            qw = w; qx = x; qy = y; qz = z;
+        }
+        const glm::vec3 a = eulerXYZFromQuat(qw, qx, qy, qz);
+        e[0] = a.x; e[1] = a.y; e[2] = a.z;
+    }
+    if(hasRootPosition && rootPosition){
+        const Channels& c = channels[0];
+        for(int k=0;k<3;++k)
+            rootPosition[k] = c.posSlot[k] >= 0 ? raw[(size_t)(c.first + c.posSlot[k])] * scale : skeleton.bones[0].bindOffset[k];
+    }
+    return true;
+}
+
+glm::mat4 BvhReader::fileRotation(size_t b) const {
+    const Channels& c = channels[b];
+    const glm::vec3 axes[3] = {{1,0,0}, {0,1,0}, {0,0,1}};
+    glm::mat4 m(1);
+    for(int k=0;k<3 && c.rotAxis[k] >= 0;++k)
+        m = m * glm::rotate(glm::mat4(1), glm::radians(raw[(size_t)(c.first + c.rotSlot[k])]), axes[c.rotAxis[k]]);
+    return m;
+}
@@ -0,0 +1,74 @@
+// Streaming BVH motion-capture reader.
+//
+// init() reads the HIERARCHY block into a Skeleton (ROOT/JOINT become bones
+// with their OFFSET as bind offset; an End Site only sets its parent's
+// length) and the MOTION header; nextFrame() then parses one frame at a time.
+// The file goes through a fixed 64 KB buffer and numbers are parsed in place
+// without iostream or per-token strings, so memory stays the same for a
+// minute or an hour of capture.
+//
+// Each joint's rotation channels, in whatever order the file lists them, are
+// composed as quaternions and turned straight into Bone::eulerDeg, the angles
+// Skeleton::rotXYZ expects (R = Rz * Ry * Rx); files already in Z Y X order
+// are copied. Root position channels become the clip's root positions;
+// position channels on other joints are ignored.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "skeleton.h"
+
+struct BvhReader {
+    static constexpr size_t kBufferSize = 64 * 1024;
+
+    Skeleton skeleton;                  // bind pose, globals not computed
+    std::vector<std::string> boneNames;
+    uint32_t frameCount = 0;            // as declared in the MOTION header
+    float frameTime = 0;                // seconds
+    bool hasRootPosition = false;
+    uint64_t bytesRead = 0;
+
+    // Parses up to the first frame; false (with a message) on a malformed file
+    bool init(const char* path, float scale = 1.0f);
+    // Fills bones * 3 Euler degrees and 3 root position floats (if any);
+    // false at the end of the frames, also when the file ends between frames
+    // before frameCount, or on error (see failed())
+    bool nextFrame(float* eulerDeg, float* rootPosition);
+    bool failed() const { return error; }
+    // Bone b's rotation in the last frame composed literally in the file's
+    // axis order with glm::rotate: the reference for the converted angles
+    glm::mat4 fileRotation(size_t b) const;
+    void destroy();
+
+private:
+    struct Channels {
+        int first = 0;                  // index of the joint's first value in a frame
+        int count = 0;
+        int8_t rotAxis[3] = {-1, -1, -1};
+        int8_t rotSlot[3] = {-1, -1, -1};       // offset of each rotation within the joint's values
+        int8_t posSlot[3] = {-1, -1, -1};       // X, Y, Z position
+        bool zyx = false;               // already the engine's order
+    };
+
+    std::FILE* f = nullptr;
+    std::string path;
+    std::vector<char> buf;
+    size_t pos = 0, end = 0;
+    bool eof = false, error = false;
+    float scale = 1.0f;
+    std::vector<Channels> channels;
+    int channelCount = 0;
+    uint32_t framesRead = 0;
+    std::vector<float> raw;
+
+    bool fail(const char* what);
+    bool refill();
+    bool skipSpace();
+    bool token(const char*& s, size_t& n);
+    bool expect(const char* word);
+    bool number(float& out);
+    int joint(int parent, int depth);       // the new bone, -1 on error
+};
@@ -0,0 +1,73 @@
+#include "camera_block.h"
+#include "upload_stats.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+CameraBlock makeCameraBlock(const glm::mat4& view, float fovYDeg, float aspect, float zNear, float zFar,
+                            bool stereo, float ipd){
+    CameraBlock b{};
+    b.eyeCount = stereo ? 2 : 1;
+    if(!stereo){
+        glm::mat4 P = glm::perspective(glm::radians(fovYDeg), aspect, zNear, zFar);
+        b.viewProj[0] = P * view;
+        b.viewProj[1] = b.viewProj[0];
+        return b;
+    }
+    // Parallel eyes: each view is the mono view shifted by half the IPD
+    glm::mat4 P = glm::perspective(glm::radians(fovYDeg), aspect * 0.5f, zNear, zFar);
+    b.viewProj[0] = P * glm::translate(glm::mat4(1), {+ipd * 0.5f, 0, 0}) * view;
+    b.viewProj[1] = P * glm::translate(glm::mat4(1), {-ipd * 0.5f, 0, 0}) * view;
+    return b;
+}
+
+void CameraUniforms::init(){
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kCameraBlockBinding, ubo);
+}
+
+void CameraUniforms::update(const CameraBlock& b){
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &b);
+    countUpload(UploadCategory::Uniform, sizeof(CameraBlock));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if(b.eyeCount != eyeCount){
+        if(b.eyeCount == 2) glEnable(GL_CLIP_DISTANCE0); else glDisable(GL_CLIP_DISTANCE0);
+    }
+    eyeCount = b.eyeCount;
+}
+
+void CameraUniforms::destroy(){
+    glDeleteBuffers(1, &ubo);
+}
+
+void bindCameraBlock(GLuint prog){
+    GLuint idx = glGetUniformBlockIndex(prog, "CameraBlock");
+    if(idx != GL_INVALID_INDEX) glUniformBlockBinding(prog, idx, kCameraBlockBinding);
+}
+
+// Eye x range [-w, w] is mapped to [-w, 0] (left) or [0, w] (right); the
+// clip distance removes what would otherwise spill into the other eye.
+const char* kCameraBlockGLSL = R"GLSL(
+layout(std140) uniform CameraBlock {
+    mat4 uViewProj[2];
+    int uEyeCount;
+};
+out float gl_ClipDistance[1];
+
+int eyeIndex(){ return gl_InstanceID % uEyeCount; }
+int instanceIndex(){ return gl_InstanceID / uEyeCount; }
+
+vec4 eyeClip(vec3 world, int eye){
+    vec4 c = uViewProj[eye] * vec4(world, 1.0);
+    if(uEyeCount == 2){
+        gl_ClipDistance[0] = eye == 0 ? c.w - c.x : c.w + c.x;
+        c.x = 0.5 * c.x + (eye == 0 ? -0.5 : 0.5) * c.w;
+    } else {
+        gl_ClipDistance[0] = 1.0;
+    }
+    return c;
+}
+)GLSL";
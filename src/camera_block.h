@@ -0,0 +1,40 @@
+// Camera uniform block shared by every program, with optional single-pass stereo.
+//
+// In stereo each draw is issued with twice the instances. The vertex shader
+// takes the eye from gl_InstanceID parity, picks that eye's viewProj and
+// squeezes the result into the left or right half of the target, so the
+// side-by-side image costs no extra draw calls. Per-instance attributes must
+// use a divisor of eyeCount so both eyes see the same instance data.
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+constexpr GLuint kCameraBlockBinding = 0;
+
+// std140 mirror of CameraBlock in kCameraBlockGLSL
+struct CameraBlock {
+    glm::mat4 viewProj[2];
+    GLint eyeCount;
+    GLint pad[3];
+};
+
+// mono: eye 0 only. stereo: eyes offset by ipd along the view's x axis,
+// each with half the horizontal aspect.
+CameraBlock makeCameraBlock(const glm::mat4& view, float fovYDeg, float aspect, float zNear, float zFar,
+                            bool stereo, float ipd = 0.064f);
+
+struct CameraUniforms {
+    GLuint ubo = 0;
+    int eyeCount = 1;
+
+    void init();
+    void update(const CameraBlock& b);   // also toggles GL_CLIP_DISTANCE0
+    void destroy();
+};
+
+// Attach prog's CameraBlock to kCameraBlockBinding
+void bindCameraBlock(GLuint prog);
+
+// GLSL (330): the block plus eyeIndex(), instanceIndex() and eyeClip(world, eye)
+extern const char* kCameraBlockGLSL;
@@ -0,0 +1,334 @@
+#include "crowd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <glm/gtc/constants.hpp>
+
+#include "gl_util.h"
+#include "camera_block.h"
+#include "hw_counters.h"
+#include "pose_check.h"
+#include "profiler.h"
+#include "upload_stats.h"
+
+// ------------------------------------------------------------
+// Shader sources (palette skinned; no lighting)
+// ------------------------------------------------------------
+static const char* kCrowdVSHead = R"GLSL(
+#version 330 core
+layout (location = 0) in vec3 aPos;         // bone-local
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in int  aBone;
+layout (location = 3) in vec3 aInstOffset;  // per instance
+layout (location = 4) in ivec2 aMorph;      // first sparse delta, count
+
+uniform samplerBuffer uPalette;
+uniform int uPaletteFormat;
+uniform int uBoneCount;
+uniform samplerBuffer uMorphDeltas;         // xyz delta, w shape index
+uniform samplerBuffer uMorphWeights;        // instances * uShapeCount
+uniform int uShapeCount;
+
+out vec3 vColor;
+)GLSL";
+
+static const char* kCrowdVSMain = R"GLSL(
+void main(){
+    int inst = instanceIndex();
+    vec3 p = aPos;
+    int wBase = inst * uShapeCount;
+    for(int i = 0; i < aMorph.y; ++i){
+        vec4 d = texelFetch(uMorphDeltas, aMorph.x + i);
+        p += d.xyz * texelFetch(uMorphWeights, wBase + int(d.w)).r;
+    }
+    mat4 M = paletteFetch(uPalette, uPaletteFormat, inst * uBoneCount + aBone);
+    vec3 world = (M * vec4(p, 1.0)).xyz + aInstOffset;
+    vColor = aColor;
+    gl_Position = eyeClip(world, eyeIndex());
+}
+)GLSL";
+
+static const char* kCrowdFS = R"GLSL(
+#version 330 core
+in vec3 vColor;
+out vec4 FragColor;
+void main(){
+    FragColor = vec4(vColor, 1.0);
+}
+)GLSL";
+
+static double msSince(std::chrono::steady_clock::time_point t0){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ------------------------------------------------------------
+// Template geometry
+// ------------------------------------------------------------
+void appendSkinnedBoneLines(const Skeleton& s, const glm::vec3& color, std::vector<SkinnedVertex>& v){
+    // Same selection as buildSkeletonLines: bone runs from its joint to (0,-length,0)
+    for(size_t i = 1; i < s.bones.size(); ++i){
+        const Bone& b = s.bones[i];
+        if(b.length <= 0.001f || (int)i == kHeadBone) continue;
+        v.push_back({glm::vec3(0), color, (GLint)i, {0, 0}});
+        v.push_back({glm::vec3(0, -b.length, 0), color, (GLint)i, {0, 0}});
+    }
+}
+
+std::vector<SkinnedVertex> buildSkinnedTemplate(const Skeleton& s, const HeadMesh& head, GLint& lineCount){
+    std::vector<SkinnedVertex> v;
+    const glm::vec3 headColor(0.95f, 0.75f, 0.25f);
+
+    appendSkinnedBoneLines(s, glm::vec3(1.0f, 0.9f, 0.4f), v);
+    lineCount = (GLint)v.size();
+
+    for(size_t i = 0; i < head.positions.size(); ++i)
+        v.push_back({head.positions[i], headColor, kHeadBone, {(GLint)head.morphFirst[i], (GLint)head.morphCount[i]}});
+    return v;
+}
+
+// ------------------------------------------------------------
+// Crowd
+// ------------------------------------------------------------
+bool Crowd::init(const Skeleton& proto, int count, PaletteFormat fmt, const HeadMesh* prebuiltHead){
+    skel = proto;
+    boneCount = (int)proto.bones.size();
+    requested = fmt;
+
+    // The texture buffer has to address every texel of the worst-case (mat4) palette
+    GLint maxTexels = 0; glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    const int perInstance = boneCount * paletteTexelsPerBone(PaletteFormat::Mat4);
+    if((int64_t)count * perInstance > maxTexels){
+        int fit = maxTexels / perInstance;
+        std::fprintf(stderr, "Crowd of %d exceeds GL_MAX_TEXTURE_BUFFER_SIZE (%d texels), using %d\n", count, maxTexels, fit);
+        count = fit;
+    }
+    if(count <= 0) return false;
+    instances = count;
+
+    // Square grid around the origin; phases spread by the golden ratio so
+    // neighbours never step in sync
+    const int side = (int)std::ceil(std::sqrt((double)count));
+    const float spacing = 1.2f;
+    const float period = 1.0f / 1.6f;   // one walk cycle in animateWalk
+    phaseOffset.resize((size_t)count);
+    offsets.resize((size_t)count);
+    for(int i=0;i<count;++i){
+        int gx = i % side, gz = i / side;
+        offsets[(size_t)i] = glm::vec3((gx - (side-1)*0.5f) * spacing, 0.0f, (gz - (side-1)*0.5f) * spacing);
+        float f = (float)i * 0.6180339887f;
+        phaseOffset[(size_t)i] = (f - std::floor(f)) * period;
+    }
+    globals.resize((size_t)count * (size_t)boneCount);
+
+    // Head mesh replaces the procedural sphere; same size as buildHeadSphereTris
+    head = prebuiltHead ? *prebuiltHead : buildHeadMesh(skel.bones[(size_t)kHeadBone].length * 0.6f);
+    shapeWeights.resize((size_t)count * (size_t)head.shapeCount());
+    std::printf("head: %zu verts, %d shapes, %zu sparse deltas (%.1f KB, dense would be %.1f KB)\n",
+                head.positions.size(), head.shapeCount(), head.morphEntries.size(),
+                head.sparseBytes() / 1024.0, head.denseBytes() / 1024.0);
+
+    std::string vs = std::string(kCrowdVSHead) + kCameraBlockGLSL + kPaletteDecodeGLSL + kCrowdVSMain;
+    prog = makeProgram(vs.c_str(), kCrowdFS);
+    bindCameraBlock(prog);
+    uPalette = glGetUniformLocation(prog, "uPalette");
+    uPaletteFormat = glGetUniformLocation(prog, "uPaletteFormat");
+    uBoneCount = glGetUniformLocation(prog, "uBoneCount");
+    uMorphDeltas = glGetUniformLocation(prog, "uMorphDeltas");
+    uMorphWeights = glGetUniformLocation(prog, "uMorphWeights");
+    uShapeCount = glGetUniformLocation(prog, "uShapeCount");
+
+    std::vector<SkinnedVertex> tmpl = buildSkinnedTemplate(skel, head, lineCount);
+    headIndexCount = (GLint)head.indices.size();
+
+    glGenVertexArrays(1, &vao); glGenBuffers(1, &vboTemplate); glGenBuffers(1, &vboInstances);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vboTemplate);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(tmpl.size()*sizeof(SkinnedVertex)), tmpl.data(), GL_STATIC_DRAW);
+    countUpload(UploadCategory::Vertex, tmpl.size()*sizeof(SkinnedVertex));
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)0);
+    glEnableVertexAttribArray(1); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)(sizeof(glm::vec3)));
+    glEnableVertexAttribArray(2); glVertexAttribIPointer(2, 1, GL_INT, sizeof(SkinnedVertex), (void*)(2*sizeof(glm::vec3)));
+    glEnableVertexAttribArray(4); glVertexAttribIPointer(4, 2, GL_INT, sizeof(SkinnedVertex), (void*)(2*sizeof(glm::vec3) + sizeof(GLint)));
+    glBindBuffer(GL_ARRAY_BUFFER, vboInstances);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(offsets.size()*sizeof(glm::vec3)), offsets.data(), GL_STATIC_DRAW);
+    countUpload(UploadCategory::Vertex, offsets.size()*sizeof(glm::vec3));
+    glEnableVertexAttribArray(3); glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glVertexAttribDivisor(3, 1);
+    glGenBuffers(1, &eboHead);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboHead);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(head.indices.size()*sizeof(uint32_t)), head.indices.data(), GL_STATIC_DRAW);
+    countUpload(UploadCategory::Vertex, head.indices.size()*sizeof(uint32_t));
+    glBindVertexArray(0);
+
+    // Palette storage is sized for the lossless fallback so switching formats never reallocates
+    paletteCapacity = globals.size() * paletteBytesPerBone(PaletteFormat::Mat4);
+    palette.resize(paletteCapacity);
+    glGenBuffers(1, &paletteBuf);
+    glBindBuffer(GL_TEXTURE_BUFFER, paletteBuf);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)paletteCapacity, nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &paletteTex);
+    glBindTexture(GL_TEXTURE_BUFFER, paletteTex);
+    texFormat = PaletteFormat::Mat4;
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, paletteBuf);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    // Sparse deltas are static; weights are rewritten every frame
+    glGenBuffers(1, &morphDeltaBuf);
+    glBindBuffer(GL_TEXTURE_BUFFER, morphDeltaBuf);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)std::max<size_t>(head.sparseBytes(), sizeof(glm::vec4)), head.morphEntries.data(), GL_STATIC_DRAW);
+    countUpload(UploadCategory::Texture, std::max<size_t>(head.sparseBytes(), sizeof(glm::vec4)));
+    staticGpuBytes = tmpl.size()*sizeof(SkinnedVertex) + offsets.size()*sizeof(glm::vec3)
+                   + head.indices.size()*sizeof(uint32_t) + std::max<size_t>(head.sparseBytes(), sizeof(glm::vec4));
+    glGenTextures(1, &morphDeltaTex);
+    glBindTexture(GL_TEXTURE_BUFFER, morphDeltaTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, morphDeltaBuf);
+
+    glGenBuffers(1, &morphWeightBuf);
+    glBindBuffer(GL_TEXTURE_BUFFER, morphWeightBuf);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(shapeWeights.size()*sizeof(float)), nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &morphWeightTex);
+    glBindTexture(GL_TEXTURE_BUFFER, morphWeightTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, morphWeightBuf);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenQueries(2, timeQuery);
+    return true;
+}
+
+size_t Crowd::cpuBytes() const {
+    return globals.size()*sizeof(glm::mat4) + palette.size() + shapeWeights.size()*sizeof(float)
+         + offsets.size()*sizeof(glm::vec3) + phaseOffset.size()*sizeof(float);
+}
+
+size_t Crowd::gpuBytes() const {
+    return staticGpuBytes + paletteCapacity + shapeWeights.size()*sizeof(float);
+}
+
+void Crowd::setLayout(const std::vector<glm::vec3>& worldOffsets, const std::vector<float>& phases){
+    const size_t n = std::min({(size_t)instances, worldOffsets.size(), phases.size()});
+    std::copy(worldOffsets.begin(), worldOffsets.begin() + (std::ptrdiff_t)n, offsets.begin());
+    std::copy(phases.begin(), phases.begin() + (std::ptrdiff_t)n, phaseOffset.begin());
+    glBindBuffer(GL_ARRAY_BUFFER, vboInstances);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(offsets.size()*sizeof(glm::vec3)), offsets.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    countUpload(UploadCategory::Vertex, offsets.size()*sizeof(glm::vec3));
+}
+
+void Crowd::update(float t){
+    auto t0 = std::chrono::steady_clock::now();
+    const double bones = (double)instances * (double)boneCount;
+    {
+        // One zone for all walkers: a zone per skeleton would overrun the trace ring
+        PROFILE_ZONE("crowd animate");
+        {
+            // Pose and hierarchy interleave per walker through the one skeleton,
+            // so their counters are merged: a scope per walker would cost more
+            // than the work it measures
+            hwc::Scope hw("crowd pose+hier", bones, "bone");
+            for(int i=0;i<instances;++i){
+                animateWalk(skel, t + phaseOffset[(size_t)i]);
+                glm::mat4* dst = &globals[(size_t)i * (size_t)boneCount];
+                for(int b=0;b<boneCount;++b) dst[b] = skel.bones[(size_t)b].global;
+            }
+            POSE_SHADOW(skel);          // the last walker, once per update
+        }
+        const int shapes = head.shapeCount();
+        hwc::Scope hw("crowd weights", (double)instances * (double)shapes, "weight");
+        for(int i=0;i<instances;++i)
+            headShapeWeights(t, phaseOffset[(size_t)i] * 7.31f, &shapeWeights[(size_t)i * (size_t)shapes], shapes);
+    }
+    stats.animMs = msSince(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    PROFILE_ZONE("crowd encode");
+    hwc::Scope hw("crowd encode", bones, "bone");
+    PaletteFormat fmt = requested;
+    if(!encodePalette(fmt, globals.data(), globals.size(), palette.data())){
+        // Scale or shear somewhere: keep the frame exact with full matrices
+        fmt = PaletteFormat::Mat4;
+        encodePalette(fmt, globals.data(), globals.size(), palette.data());
+    }
+    stats.format = fmt;
+    stats.paletteBytes = globals.size() * paletteBytesPerBone(fmt);
+    stats.encodeMs = msSince(t0);
+}
+
+void Crowd::upload(){
+    PROFILE_ZONE("crowd upload");
+    hwc::Scope hw("crowd upload", (double)instances * (double)boneCount, "bone");
+    auto t0 = std::chrono::steady_clock::now();
+    if(stats.format != texFormat){
+        texFormat = stats.format;
+        glBindTexture(GL_TEXTURE_BUFFER, paletteTex);
+        glTexBuffer(GL_TEXTURE_BUFFER, texFormat == PaletteFormat::QuatTransHalf ? GL_RGBA16F : GL_RGBA32F, paletteBuf);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, paletteBuf);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)stats.paletteBytes, palette.data());
+    stats.morphBytes = shapeWeights.size() * sizeof(float);
+    glBindBuffer(GL_TEXTURE_BUFFER, morphWeightBuf);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)stats.morphBytes, shapeWeights.data());
+    countUpload(UploadCategory::Texture, stats.paletteBytes + stats.morphBytes);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    stats.uploadMs = msSince(t0);
+}
+
+void Crowd::draw(int eyeCount){
+    // Read the query issued two frames ago only if it is done, never stall
+    GLuint pending = timeQuery[frame & 1];
+    if(frame >= 2){
+        GLint ready = 0; glGetQueryObjectiv(pending, GL_QUERY_RESULT_AVAILABLE, &ready);
+        if(ready){
+            GLuint64 ns = 0; glGetQueryObjectui64v(pending, GL_QUERY_RESULT, &ns);
+            stats.gpuMs = (double)ns * 1e-6;
+        }
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, pending);
+    glUseProgram(prog);
+    glUniform1i(uPaletteFormat, (GLint)texFormat);
+    glUniform1i(uBoneCount, boneCount);
+    glUniform1i(uShapeCount, head.shapeCount());
+    glUniform1i(uPalette, 0);
+    glUniform1i(uMorphDeltas, 1);
+    glUniform1i(uMorphWeights, 2);
+    countUpload(UploadCategory::Uniform, 6*sizeof(GLint));
+    glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_BUFFER, paletteTex);
+    glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_BUFFER, morphDeltaTex);
+    glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_BUFFER, morphWeightTex);
+
+    // Instances are interleaved per eye, so the offsets advance every eyeCount
+    glBindVertexArray(vao);
+    if(eyeCount != instanceDivisor){ glVertexAttribDivisor(3, (GLuint)eyeCount); instanceDivisor = eyeCount; }
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, headIndexCount, GL_UNSIGNED_INT, (void*)0, instances * eyeCount, lineCount);
+    glDrawArraysInstanced(GL_LINES, 0, lineCount, instances * eyeCount);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glEndQuery(GL_TIME_ELAPSED);
+    ++frame;
+}
+
+void Crowd::destroy(){
+    glDeleteQueries(2, timeQuery);
+    glDeleteTextures(1, &morphWeightTex);
+    glDeleteBuffers(1, &morphWeightBuf);
+    glDeleteTextures(1, &morphDeltaTex);
+    glDeleteBuffers(1, &morphDeltaBuf);
+    glDeleteBuffers(1, &eboHead);
+    glDeleteTextures(1, &paletteTex);
+    glDeleteBuffers(1, &paletteBuf);
+    glDeleteBuffers(1, &vboInstances);
+    glDeleteBuffers(1, &vboTemplate);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(prog);
+    instances = 0;
+}
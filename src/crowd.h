@@ -0,0 +1,84 @@
+// GPU-skinned crowd: many walkers sharing one bone/head template mesh.
+//
+// Each frame every instance is animated on the CPU, its joint transforms are
+// encoded into a bone palette (see bone_palette.h) and uploaded into a texture
+// buffer; the skinned vertex shader rebuilds the matrices and all instances
+// are drawn with one instanced call per primitive type. The head is the
+// blendshape mesh from head_mesh.h, driven by a per-instance weight vector.
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "skeleton.h"
+#include "bone_palette.h"
+#include "head_mesh.h"
+
+// Vertex of the shared template, expressed in the space of its bone.
+// morph = (first entry, count) into the sparse blendshape deltas.
+struct SkinnedVertex { glm::vec3 pos; glm::vec3 col; GLint bone; GLint morph[2]; };
+
+// Per-frame measurements, all CPU times in milliseconds
+struct CrowdStats {
+    double animMs = 0, encodeMs = 0, uploadMs = 0;
+    double gpuMs = -1;          // last resolved GL_TIME_ELAPSED, -1 until available
+    size_t paletteBytes = 0;    // bytes uploaded this frame
+    size_t morphBytes = 0;      // blendshape weights uploaded this frame
+    PaletteFormat format = PaletteFormat::Mat4;   // format actually used
+};
+
+struct Crowd {
+    int instances = 0;
+    int boneCount = 0;
+    PaletteFormat requested = PaletteFormat::QuatTrans;
+
+    Skeleton skel;                          // scratch skeleton animated per instance
+    std::vector<float> phaseOffset;         // seconds, per instance
+    std::vector<glm::vec3> offsets;         // world placement, per instance
+    std::vector<glm::mat4> globals;         // instances * boneCount, lossless
+    std::vector<unsigned char> palette;     // encoded upload payload
+    HeadMesh head;
+    std::vector<float> shapeWeights;        // instances * head.shapeCount()
+
+    GLuint prog = 0;
+    GLint uPalette = -1, uPaletteFormat = -1, uBoneCount = -1;
+    GLint uMorphDeltas = -1, uMorphWeights = -1, uShapeCount = -1;
+    GLuint vao = 0, vboTemplate = 0, vboInstances = 0, eboHead = 0;
+    GLuint paletteBuf = 0, paletteTex = 0;
+    size_t paletteCapacity = 0;
+    PaletteFormat texFormat = PaletteFormat::Mat4;
+    GLuint morphDeltaBuf = 0, morphDeltaTex = 0;
+    GLuint morphWeightBuf = 0, morphWeightTex = 0;
+    GLint lineCount = 0;                    // template vertices before the head
+    GLint headIndexCount = 0;
+    size_t staticGpuBytes = 0;              // template, instance offsets, indices, morph deltas
+    int instanceDivisor = 1;
+
+    GLuint timeQuery[2] = {0, 0};
+    unsigned frame = 0;
+
+    CrowdStats stats;
+
+    // prebuiltHead: head mesh built ahead of time (e.g. on a loader thread), else built here
+    bool init(const Skeleton& proto, int count, PaletteFormat fmt, const HeadMesh* prebuiltHead = nullptr);
+    // Replace the default grid placement and golden-ratio phases (one entry per instance)
+    void setLayout(const std::vector<glm::vec3>& worldOffsets, const std::vector<float>& phases);
+    void update(float t);      // animate all instances, encode the palette, set face weights
+    void upload();             // send palette and weights to their texture buffers
+    void draw(int eyeCount);   // camera comes from the CameraBlock binding
+    void destroy();
+
+    // Memory held for the crowd, in bytes
+    size_t cpuBytes() const;
+    size_t gpuBytes() const;
+};
+
+// Bone lines of s in bone-local coordinates (two vertices per visible bone)
+void appendSkinnedBoneLines(const Skeleton& s, const glm::vec3& color, std::vector<SkinnedVertex>& v);
+
+// Bone lines of s in bone-local coordinates (rigid skinning) followed by the
+// vertices of the head mesh, which the head index list addresses with a
+// base vertex of lineCount.
+std::vector<SkinnedVertex> buildSkinnedTemplate(const Skeleton& s, const HeadMesh& head, GLint& lineCount);
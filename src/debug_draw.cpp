@@ -0,0 +1,330 @@
+#include "debug_draw.h"
+
+#if SKEL_DEBUG_DRAW
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+
+#include "gl_util.h"
+#include "camera_block.h"
+#include "frame_arena.h"
+#include "skeleton.h"
+#include "text_renderer.h"
+#include "upload_stats.h"
+
+namespace dbg {
+
+// ------------------------------------------------------------
+// Per-thread append buffers
+// ------------------------------------------------------------
+enum Stream { kLinesDepth, kLinesOverlay, kGlyphs, kTimedLines, kTimedGlyphs, kStreamCount };
+
+struct TimedLine  { LineVertex a, b; float expires; bool depthTest; };
+struct TimedGlyph { GlyphInstance g; float expires; };
+
+// Header of a block of same-typed elements carved from the arena
+struct Chunk {
+    Chunk* next;
+    uint32_t count, capacity;
+    unsigned char* data() { return reinterpret_cast<unsigned char*>(this) + kHeader; }
+    static constexpr size_t kHeader = 16;
+};
+static_assert(sizeof(Chunk) <= Chunk::kHeader, "chunk header must fit its reserved space");
+
+struct ThreadBuffer {
+    Chunk* head[kStreamCount] = {};
+    Chunk* tail[kStreamCount] = {};
+};
+
+static constexpr size_t kChunkBytes = 16u << 10;
+static constexpr float kTextScale = 2.0f;
+
+static std::unique_ptr<FrameArena> g_arena;
+static std::atomic<float> g_now{0.0f};
+static std::mutex g_registryMutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> g_registry;
+static thread_local ThreadBuffer* t_buffer = nullptr;
+
+static ThreadBuffer& threadBuffer(){
+    if(!t_buffer){
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        g_registry.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = g_registry.back().get();
+    }
+    return *t_buffer;
+}
+
+// Contiguous room for n elements of T in this thread's stream, or nullptr
+// if the arena is exhausted (the primitive is then dropped).
+template<class T>
+static T* reserve(Stream s, size_t n){
+    if(!g_arena) return nullptr;
+    ThreadBuffer& tb = threadBuffer();
+    Chunk* c = tb.tail[s];
+    if(!c || c->count + n > c->capacity){
+        size_t cap = std::max(n, (kChunkBytes - Chunk::kHeader) / sizeof(T));
+        c = static_cast<Chunk*>(g_arena->allocate(Chunk::kHeader + cap * sizeof(T)));
+        if(!c) return nullptr;
+        c->next = nullptr; c->count = 0; c->capacity = (uint32_t)cap;
+        if(tb.tail[s]) tb.tail[s]->next = c; else tb.head[s] = c;
+        tb.tail[s] = c;
+    }
+    T* p = reinterpret_cast<T*>(c->data()) + c->count;
+    c->count += (uint32_t)n;
+    return p;
+}
+
+// Line segments go to the frame stream, or the timed stream when they outlive the frame
+struct LineSink {
+    LineVertex* frame = nullptr;
+    TimedLine* timed = nullptr;
+    float expires = 0; bool depth = true;
+
+    LineSink(size_t segments, float duration, bool depthTest) : depth(depthTest) {
+        if(duration > 0.0f){ timed = reserve<TimedLine>(kTimedLines, segments); expires = g_now.load(std::memory_order_relaxed) + duration; }
+        else frame = reserve<LineVertex>(depthTest ? kLinesDepth : kLinesOverlay, segments * 2);
+    }
+    bool ok() const { return frame || timed; }
+    void add(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c){
+        if(frame){ *frame++ = {a, c}; *frame++ = {b, c}; }
+        else *timed++ = {{a, c}, {b, c}, expires, depth};
+    }
+};
+
+// ------------------------------------------------------------
+// Primitives
+// ------------------------------------------------------------
+void line(const glm::vec3& a, const glm::vec3& b, const glm::vec3& color, float duration, bool depthTest){
+    LineSink out(1, duration, depthTest);
+    if(out.ok()) out.add(a, b, color);
+}
+
+static void basis(const glm::vec3& n, glm::vec3& u, glm::vec3& v){
+    u = glm::normalize(glm::cross(n, std::abs(n.y) < 0.9f ? glm::vec3(0,1,0) : glm::vec3(1,0,0)));
+    v = glm::cross(n, u);
+}
+
+void arrow(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color, float headSize, float duration, bool depthTest){
+    glm::vec3 d = to - from;
+    float len = glm::length(d);
+    if(len <= 1e-6f) return;
+    LineSink out(5, duration, depthTest);
+    if(!out.ok()) return;
+    glm::vec3 n = d / len, u, v; basis(n, u, v);
+    glm::vec3 base = to - n * std::min(headSize, len);
+    float r = headSize * 0.5f;
+    out.add(from, to, color);
+    out.add(to, base + u*r, color); out.add(to, base - u*r, color);
+    out.add(to, base + v*r, color); out.add(to, base - v*r, color);
+}
+
+static void boxCorners(const glm::mat4& xf, const glm::vec3& h, const glm::vec3& color, float duration, bool depthTest){
+    glm::vec3 c[8];
+    for(int i=0;i<8;++i)
+        c[i] = glm::vec3(xf * glm::vec4((i&1)? h.x:-h.x, (i&2)? h.y:-h.y, (i&4)? h.z:-h.z, 1.0f));
+    static const int kEdges[12][2] = {{0,1},{2,3},{4,5},{6,7},{0,2},{1,3},{4,6},{5,7},{0,4},{1,5},{2,6},{3,7}};
+    LineSink out(12, duration, depthTest);
+    if(!out.ok()) return;
+    for(const auto& e : kEdges) out.add(c[e[0]], c[e[1]], color);
+}
+
+void box(const glm::vec3& center, const glm::vec3& halfExtents, const glm::vec3& color, float duration, bool depthTest){
+    glm::mat4 xf(1.0f); xf[3] = glm::vec4(center, 1.0f);
+    boxCorners(xf, halfExtents, color, duration, depthTest);
+}
+
+void box(const glm::mat4& xf, const glm::vec3& halfExtents, const glm::vec3& color, float duration, bool depthTest){
+    boxCorners(xf, halfExtents, color, duration, depthTest);
+}
+
+void sphere(const glm::vec3& center, float radius, const glm::vec3& color, float duration, bool depthTest){
+    constexpr int kSeg = 24;
+    LineSink out(3 * kSeg, duration, depthTest);
+    if(!out.ok()) return;
+    auto ring = [&](int axis, float a){
+        glm::vec3 p(0);
+        p[(axis+1)%3] = std::cos(a) * radius; p[(axis+2)%3] = std::sin(a) * radius;
+        return center + p;
+    };
+    for(int axis=0;axis<3;++axis)
+        for(int i=0;i<kSeg;++i)
+            out.add(ring(axis, glm::two_pi<float>() * i / kSeg), ring(axis, glm::two_pi<float>() * (i+1) / kSeg), color);
+}
+
+void axes(const glm::mat4& xf, float size, float duration, bool depthTest){
+    LineSink out(3, duration, depthTest);
+    if(!out.ok()) return;
+    glm::vec3 o(xf[3]);
+    out.add(o, o + glm::vec3(xf[0]) * size, {1.0f, 0.2f, 0.2f});
+    out.add(o, o + glm::vec3(xf[1]) * size, {0.2f, 1.0f, 0.2f});
+    out.add(o, o + glm::vec3(xf[2]) * size, {0.3f, 0.4f, 1.0f});
+}
+
+static void emitText(const glm::vec4& anchor, glm::vec2 offset, const char* s, const glm::vec3& color, float duration){
+    GlyphInstance tmp[256];             // longer labels are truncated
+    const int n = layoutText(s, anchor, offset, packRGBA(color), kTextScale, tmp, 256);
+    if(n == 0) return;
+    if(duration > 0.0f){
+        TimedGlyph* out = reserve<TimedGlyph>(kTimedGlyphs, (size_t)n);
+        if(!out) return;
+        const float expires = g_now.load(std::memory_order_relaxed) + duration;
+        for(int i=0;i<n;++i) out[i] = {tmp[i], expires};
+    } else if(GlyphInstance* out = reserve<GlyphInstance>(kGlyphs, (size_t)n)){
+        std::memcpy(out, tmp, (size_t)n * sizeof(GlyphInstance));
+    }
+}
+
+void text(const glm::vec3& pos, const char* s, const glm::vec3& color, float duration){
+    emitText(glm::vec4(pos, 1.0f), glm::vec2(4.0f, -8.0f), s, color, duration);
+}
+
+void screenText(const glm::vec2& px, const char* s, const glm::vec3& color, float duration){
+    emitText(glm::vec4(px, 0.0f, 0.0f), glm::vec2(0.0f), s, color, duration);
+}
+
+// ------------------------------------------------------------
+// Render thread
+// ------------------------------------------------------------
+static const char* kLineVSHead = R"GLSL(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+)GLSL";
+
+static const char* kLineVSMain = R"GLSL(
+out vec3 vColor;
+void main(){
+    vColor = aColor;
+    gl_Position = eyeClip(aPos, eyeIndex());
+}
+)GLSL";
+
+static const char* kLineFS = R"GLSL(
+#version 330 core
+in vec3 vColor;
+out vec4 FragColor;
+void main(){
+    FragColor = vec4(vColor, 1.0);
+}
+)GLSL";
+
+struct Renderer {
+    GLuint prog = 0, vao = 0, vbo = 0;
+    size_t capacity = 0;            // line vertices
+    TextRenderer text;
+    std::vector<LineVertex> lines[2];           // depth, overlay
+    std::vector<GlyphInstance> glyphs;
+    std::vector<TimedLine> timedLines;
+    std::vector<TimedGlyph> timedGlyphs;
+    Stats stats;
+};
+static std::unique_ptr<Renderer> g_r;
+
+void init(size_t arenaBytes){
+    g_arena = std::make_unique<FrameArena>(arenaBytes);
+    g_r = std::make_unique<Renderer>();
+    std::string vs = std::string(kLineVSHead) + kCameraBlockGLSL + kLineVSMain;
+    g_r->prog = makeProgram(vs.c_str(), kLineFS);
+    bindCameraBlock(g_r->prog);
+
+    g_r->capacity = 16384;
+    glGenVertexArrays(1, &g_r->vao); glGenBuffers(1, &g_r->vbo);
+    glBindVertexArray(g_r->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, g_r->vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(g_r->capacity*sizeof(LineVertex)), nullptr, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)0);
+    glEnableVertexAttribArray(1); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)(sizeof(glm::vec3)));
+    glBindVertexArray(0);
+    g_r->text.scale = kTextScale;
+    g_r->text.init();
+}
+
+template<class T, class F>
+static void drain(Stream s, F&& f){
+    for(auto& tb : g_registry)
+        for(Chunk* c = tb->head[s]; c; c = c->next){
+            const T* p = reinterpret_cast<const T*>(c->data());
+            for(uint32_t i=0;i<c->count;++i) f(p[i]);
+        }
+}
+
+void flush(float now, int eyeCount, int viewportW, int viewportH){
+    if(!g_r) return;
+    Renderer& r = *g_r;
+    r.lines[0].clear(); r.lines[1].clear(); r.glyphs.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        drain<LineVertex>(kLinesDepth,   [&](const LineVertex& v){ r.lines[0].push_back(v); });
+        drain<LineVertex>(kLinesOverlay, [&](const LineVertex& v){ r.lines[1].push_back(v); });
+        drain<GlyphInstance>(kGlyphs,    [&](const GlyphInstance& g){ r.glyphs.push_back(g); });
+        drain<TimedLine>(kTimedLines,    [&](const TimedLine& l){ r.timedLines.push_back(l); });
+        drain<TimedGlyph>(kTimedGlyphs,  [&](const TimedGlyph& g){ r.timedGlyphs.push_back(g); });
+        for(auto& tb : g_registry) *tb = ThreadBuffer{};
+    }
+    r.stats.dropped = g_arena->failures();
+    g_arena->reset();
+    r.stats.arenaPeak = g_arena->peak();
+
+    // Retained primitives live until their expiry time
+    r.timedLines.erase(std::remove_if(r.timedLines.begin(), r.timedLines.end(),
+                       [&](const TimedLine& l){ return l.expires < now; }), r.timedLines.end());
+    r.timedGlyphs.erase(std::remove_if(r.timedGlyphs.begin(), r.timedGlyphs.end(),
+                        [&](const TimedGlyph& g){ return g.expires < now; }), r.timedGlyphs.end());
+    for(const TimedLine& l : r.timedLines){ auto& v = r.lines[l.depthTest ? 0 : 1]; v.push_back(l.a); v.push_back(l.b); }
+    for(const TimedGlyph& g : r.timedGlyphs) r.glyphs.push_back(g.g);
+    g_now.store(now, std::memory_order_relaxed);
+
+    // One upload, then one draw per primitive type
+    const size_t total = r.lines[0].size() + r.lines[1].size();
+    if(total > 0){
+        glBindBuffer(GL_ARRAY_BUFFER, r.vbo);
+        if(total > r.capacity){
+            while(r.capacity < total) r.capacity *= 2;
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(r.capacity*sizeof(LineVertex)), nullptr, GL_STREAM_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(r.lines[0].size()*sizeof(LineVertex)), r.lines[0].data());
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(r.lines[0].size()*sizeof(LineVertex)),
+                        (GLsizeiptr)(r.lines[1].size()*sizeof(LineVertex)), r.lines[1].data());
+        countUpload(UploadCategory::Vertex, total*sizeof(LineVertex));
+
+        glUseProgram(r.prog);
+        glBindVertexArray(r.vao);
+        if(!r.lines[0].empty()) glDrawArraysInstanced(GL_LINES, 0, (GLsizei)r.lines[0].size(), eyeCount);
+        if(!r.lines[1].empty()){
+            glDisable(GL_DEPTH_TEST);
+            glDrawArraysInstanced(GL_LINES, (GLint)r.lines[0].size(), (GLsizei)r.lines[1].size(), eyeCount);
+            glEnable(GL_DEPTH_TEST);
+        }
+        glBindVertexArray(0);
+    }
+    r.text.draw(r.glyphs.data(), r.glyphs.size(), eyeCount, viewportW, viewportH);
+
+    r.stats.draws = (r.lines[0].empty() ? 0 : 1) + (r.lines[1].empty() ? 0 : 1) + (r.glyphs.empty() ? 0 : 1);
+    r.stats.lines = total / 2;
+    r.stats.glyphs = r.glyphs.size();
+}
+
+void shutdown(){
+    if(!g_r) return;
+    g_r->text.destroy();
+    glDeleteBuffers(1, &g_r->vbo);
+    glDeleteVertexArrays(1, &g_r->vao);
+    glDeleteProgram(g_r->prog);
+    g_r.reset();
+    g_arena.reset();
+}
+
+Stats stats(){ return g_r ? g_r->stats : Stats{}; }
+
+} // namespace dbg
+
+#endif // SKEL_DEBUG_DRAW
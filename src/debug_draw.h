@@ -0,0 +1,78 @@
+// Immediate-mode debug drawing: lines, arrows, boxes, spheres, axes and text.
+//
+// Call the DEBUG_* macros from any thread during a frame. Each thread appends
+// into its own chunks carved from a per-frame arena (no locks on the append
+// path; a mutex is taken once per thread to register it). The render thread
+// calls DEBUG_DRAW_FLUSH after producers for that frame have finished; it
+// issues one draw per primitive type (depth-tested lines, overlay lines,
+// glyphs) and recycles the arena. A duration > 0 keeps a primitive alive for
+// that many seconds; depthTest = false draws it on top of the scene.
+//
+// Building with SKEL_DEBUG_DRAW=0 turns every macro into ((void)0): arguments
+// are not evaluated and nothing is linked.
+#pragma once
+
+#ifndef SKEL_DEBUG_DRAW
+#define SKEL_DEBUG_DRAW 0
+#endif
+
+#if SKEL_DEBUG_DRAW
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+namespace dbg {
+
+void line(const glm::vec3& a, const glm::vec3& b, const glm::vec3& color, float duration = 0.0f, bool depthTest = true);
+void arrow(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color, float headSize = 0.05f,
+           float duration = 0.0f, bool depthTest = true);
+void box(const glm::vec3& center, const glm::vec3& halfExtents, const glm::vec3& color, float duration = 0.0f, bool depthTest = true);
+void box(const glm::mat4& xf, const glm::vec3& halfExtents, const glm::vec3& color, float duration = 0.0f, bool depthTest = true);
+void sphere(const glm::vec3& center, float radius, const glm::vec3& color, float duration = 0.0f, bool depthTest = true);
+void axes(const glm::mat4& xf, float size, float duration = 0.0f, bool depthTest = true);
+// World-anchored label (always drawn on top)
+void text(const glm::vec3& pos, const char* s, const glm::vec3& color, float duration = 0.0f);
+// Label at pixel position from the top-left of the viewport
+void screenText(const glm::vec2& px, const char* s, const glm::vec3& color, float duration = 0.0f);
+
+// Render thread only (needs the GL context)
+void init(size_t arenaBytes = 4u << 20);
+void flush(float now, int eyeCount, int viewportW, int viewportH);
+void shutdown();
+
+struct Stats {
+    size_t lines = 0, glyphs = 0;       // drawn by the last flush
+    size_t arenaPeak = 0;               // bytes
+    unsigned dropped = 0;               // allocations refused by the arena last frame
+    int draws = 0;                      // GL draw calls issued by the last flush
+};
+Stats stats();
+
+} // namespace dbg
+
+#define DEBUG_LINE(...)         ::dbg::line(__VA_ARGS__)
+#define DEBUG_ARROW(...)        ::dbg::arrow(__VA_ARGS__)
+#define DEBUG_BOX(...)          ::dbg::box(__VA_ARGS__)
+#define DEBUG_SPHERE(...)       ::dbg::sphere(__VA_ARGS__)
+#define DEBUG_AXES(...)         ::dbg::axes(__VA_ARGS__)
+#define DEBUG_TEXT(...)         ::dbg::text(__VA_ARGS__)
+#define DEBUG_SCREEN_TEXT(...)  ::dbg::screenText(__VA_ARGS__)
+#define DEBUG_DRAW_INIT()       ::dbg::init()
+#define DEBUG_DRAW_FLUSH(...)   ::dbg::flush(__VA_ARGS__)
+#define DEBUG_DRAW_SHUTDOWN()   ::dbg::shutdown()
+
+#else
+
+#define DEBUG_LINE(...)         ((void)0)
+#define DEBUG_ARROW(...)        ((void)0)
+#define DEBUG_BOX(...)          ((void)0)
+#define DEBUG_SPHERE(...)       ((void)0)
+#define DEBUG_AXES(...)         ((void)0)
+#define DEBUG_TEXT(...)         ((void)0)
+#define DEBUG_SCREEN_TEXT(...)  ((void)0)
+#define DEBUG_DRAW_INIT()       ((void)0)
+#define DEBUG_DRAW_FLUSH(...)   ((void)0)
+#define DEBUG_DRAW_SHUTDOWN()   ((void)0)
+
+#endif
@@ -0,0 +1,23 @@
+// Built-in 5x7 bitmap font (ASCII 32..127) and its baked atlas.
+// Lowercase letters reuse the uppercase glyphs.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+constexpr int kGlyphW = 5, kGlyphH = 7;     // glyph pixels
+constexpr int kCellW = 6, kCellH = 8;       // atlas cell incl. 1 px spacing
+constexpr int kAtlasCols = 16, kAtlasRows = 6;
+constexpr int kFirstGlyph = 32, kGlyphCount = 96;
+
+// Row bitmaps, bit 4 = leftmost pixel
+extern const uint8_t kFont5x7[kGlyphCount][kGlyphH];
+
+// Atlas slot for c; characters outside the table map to '?'
+inline int glyphIndex(char c){
+    int i = (unsigned char)c - kFirstGlyph;
+    return (i >= 0 && i < kGlyphCount) ? i : '?' - kFirstGlyph;
+}
+
+// One byte per texel (0/255), kAtlasCols*kCellW x kAtlasRows*kCellH, top row first
+std::vector<uint8_t> bakeFontAtlas(int& w, int& h);
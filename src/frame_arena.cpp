@@ -0,0 +1,24 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t bytes) : base(new unsigned char[bytes]), size(bytes) {}
+
+void* FrameArena::allocate(size_t bytes, size_t align){
+    // Over-reserve by align-1 so the aligned block always fits inside the grab
+    size_t start = head.fetch_add(bytes + align - 1, std::memory_order_relaxed);
+    uintptr_t p = reinterpret_cast<uintptr_t>(base.get()) + start;
+    p = (p + align - 1) & ~(uintptr_t)(align - 1);
+    if(p + bytes > reinterpret_cast<uintptr_t>(base.get()) + size){
+        failed.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return reinterpret_cast<void*>(p);
+}
+
+void FrameArena::reset(){
+    peakUsed = std::max(peakUsed, used());
+    head.store(0, std::memory_order_relaxed);
+    failed.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+// Per-frame bump allocator.
+//
+// allocate() is lock-free (one atomic add) and may be called from any thread;
+// memory stays valid until reset(), which the owner calls once per frame when
+// no other thread is allocating. Exhaustion returns nullptr rather than
+// growing, so a runaway producer cannot blow up the frame.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+struct FrameArena {
+    explicit FrameArena(size_t bytes);
+
+    void* allocate(size_t bytes, size_t align = 16);
+    void reset();
+
+    size_t capacity() const { return size; }
+    size_t used() const { return std::min(head.load(std::memory_order_relaxed), size); }
+    size_t peak() const { return peakUsed; }
+    unsigned failures() const { return failed.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<unsigned char[]> base;
+    size_t size;
+    std::atomic<size_t> head{0};
+    std::atomic<unsigned> failed{0};
+    size_t peakUsed = 0;
+};
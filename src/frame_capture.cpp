@@ -0,0 +1,92 @@
+#include "frame_capture.h"
+
+#include <chrono>
+#include <cstdio>
+
+static double nowSeconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool FrameCapture::init(int ringSize, FrameConsumer onFrame){
+    if(ringSize < 2){ std::fprintf(stderr, "Frame capture needs at least 2 buffers\n"); return false; }
+    consumer = std::move(onFrame);
+    slots.resize((size_t)ringSize);
+    for(Slot& s : slots) glGenBuffers(1, &s.pbo);
+    return true;
+}
+
+void FrameCapture::resize(int w, int h){
+    flush();
+    width = w; height = h;
+    for(Slot& s : slots){
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)w * h * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::deliver(Slot& s){
+    glDeleteSync(s.fence); s.fence = nullptr;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    const void* p = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)width * height * 4, GL_MAP_READ_BIT);
+    if(p){
+        if(consumer) consumer(static_cast<const uint8_t*>(p), width, height, s.frame);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        ++stats.captured;
+        stats.latencyFrames += (double)(issues - s.issued);
+        stats.latencyMs += (nowSeconds() - s.issuedAt) * 1000.0;
+    } else std::fprintf(stderr, "Frame capture: failed to map frame %ld\n", s.frame);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    --pending;
+}
+
+void FrameCapture::poll(){
+    while(pending > 0){
+        Slot& s = slots[(head + slots.size() - pending) % slots.size()];
+        GLenum r = glClientWaitSync(s.fence, 0, 0);
+        if(r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED) break;
+        deliver(s);
+    }
+}
+
+void FrameCapture::capture(int w, int h, long frame){
+    if(slots.empty() || w <= 0 || h <= 0) return;
+    if(w != width || h != height) resize(w, h);
+    ++issues;
+    poll();
+
+    Slot& s = slots[head];
+    if(pending == slots.size()){
+        // Ring full: the oldest readback (this slot) is still in flight
+        const double t0 = nowSeconds();
+        glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(5) * 1000000000u);
+        ++stats.waits;
+        stats.waitMs += (nowSeconds() - t0) * 1000.0;
+        deliver(s);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.frame = frame;
+    s.issued = issues;
+    s.issuedAt = nowSeconds();
+    head = (head + 1) % slots.size();
+    ++pending;
+}
+
+void FrameCapture::flush(){
+    while(pending > 0){
+        Slot& s = slots[(head + slots.size() - pending) % slots.size()];
+        glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(5) * 1000000000u);
+        deliver(s);
+    }
+}
+
+void FrameCapture::destroy(){
+    flush();
+    for(Slot& s : slots) glDeleteBuffers(1, &s.pbo);
+    slots.clear();
+}
@@ -0,0 +1,55 @@
+// Asynchronous frame readback through a ring of pixel pack buffers.
+//
+// capture() queues glReadPixels of the current read framebuffer into the
+// next PBO and drops a fence behind it; nothing waits for the GPU there.
+// poll() hands every slot whose fence has signaled, oldest first, to the
+// consumer while it is still mapped (zero-copy: the pointer is only valid
+// during the callback). The CPU only blocks when capture() needs a slot
+// whose readback is still in flight; those stalls are counted in stats.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+
+// rgba: w*h*4 bytes, bottom row first (GL order)
+using FrameConsumer = std::function<void(const uint8_t* rgba, int w, int h, long frame)>;
+
+struct FrameCaptureStats {
+    long captured = 0;          // frames handed to the consumer
+    double latencyFrames = 0;   // summed capture() calls between issue and delivery
+    double latencyMs = 0;       // summed wall time between issue and delivery
+    long waits = 0;             // capture() calls that had to block on a fence
+    double waitMs = 0;
+};
+
+struct FrameCapture {
+    int width = 0, height = 0;
+    FrameConsumer consumer;
+    FrameCaptureStats stats;
+
+    bool init(int ringSize, FrameConsumer onFrame);
+    void capture(int w, int h, long frame);
+    void poll();
+    void flush();               // deliver everything still in flight (blocking)
+    void destroy();
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        long frame = 0;
+        long issued = 0;        // value of `issues` when queued
+        double issuedAt = 0;    // seconds
+    };
+    std::vector<Slot> slots;
+    size_t head = 0;            // next slot to fill
+    size_t pending = 0;         // slots in flight, oldest at head - pending
+    long issues = 0;
+
+    void resize(int w, int h);
+    void deliver(Slot& s);
+};
@@ -0,0 +1,69 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+static constexpr size_t kTailWindow = 30;          // frames of sample-to-swap history
+static constexpr double kSpinSeconds = 0.0015;     // OS sleeps stop this far from the target
+
+double pacerNow(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FramePacer::sleepUntil(double t){
+    double now = pacerNow();
+    if(t <= now) return;
+    const double start = now;
+    while(t - now > kSpinSeconds){
+        std::this_thread::sleep_for(std::chrono::duration<double>(t - now - kSpinSeconds));
+        now = pacerNow();
+    }
+    while(now < t){ std::this_thread::yield(); now = pacerNow(); }
+    sleptSeconds += now - start;
+    overshootSeconds += now - t;
+    ++sleeps;
+}
+
+double FramePacer::deadline() const {
+    switch(mode){
+    case PaceMode::Vsync:  return lastPresent + refreshSeconds;
+    case PaceMode::Target: return nextTick;
+    default:               return 0.0;
+    }
+}
+
+double FramePacer::predictedTail() const {
+    double worst = 0;
+    for(double s : tail) worst = std::max(worst, s);
+    return worst + marginSeconds;
+}
+
+void FramePacer::beginFrame(){
+    if(mode != PaceMode::Target || targetFps <= 0) return;
+    const double period = 1.0 / targetFps, now = pacerNow();
+    // A missed tick resynchronises the grid instead of bursting to catch up
+    if(nextTick <= 0 || nextTick < now - period) nextTick = now;
+    if(!lowLatency) sleepUntil(nextTick);
+}
+
+void FramePacer::waitForInput(){
+    if(!lowLatency || mode == PaceMode::Uncapped || lastPresent <= 0) return;
+    sleepUntil(deadline() - predictedTail());
+}
+
+void FramePacer::inputSampled(){ sampleTime = pacerNow(); }
+
+void FramePacer::beforePresent(){
+    if(sampleTime <= 0) return;
+    const double work = pacerNow() - sampleTime;
+    if(tail.size() < kTailWindow) tail.push_back(work);
+    else tail[tailNext] = work;
+    tailNext = (tailNext + 1) % kTailWindow;
+}
+
+void FramePacer::presented(){
+    lastPresent = pacerNow();
+    if(mode == PaceMode::Target && targetFps > 0) nextTick += 1.0 / targetFps;
+    if(sampleTime > 0) inputToPresent = lastPresent - sampleTime;
+}
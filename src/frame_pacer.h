@@ -0,0 +1,57 @@
+// Frame pacing: vsync, uncapped or a target frame rate, optionally with late
+// input sampling to cut input-to-present latency.
+//
+// Each frame has a present deadline: the next refresh after the last swap
+// (vsync) or the next tick of a fixed 1/fps grid (target). Without low
+// latency the target mode sleeps at the top of the frame until its tick, and
+// input is polled right after. In low-latency mode the frame simulates first;
+// waitForInput() then sleeps until the deadline minus the predicted cost of
+// the rest of the frame (slowest of the recent sample-to-swap times plus a
+// margin), so input is polled and the view matrix built as late as possible.
+// The prediction stops at the swap call: time the swap spends blocked on the
+// display would otherwise feed back into ever earlier sampling.
+//
+// Sleeps are precise: the OS sleep covers all but the last ~1.5 ms, which
+// are spun out. All times are steady-clock seconds.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+enum class PaceMode { Vsync, Uncapped, Target };
+
+struct FramePacer {
+    PaceMode mode = PaceMode::Vsync;
+    double targetFps = 60.0;
+    bool lowLatency = false;
+    double refreshSeconds = 1.0 / 60.0;     // display period, vsync mode
+    double marginSeconds = 0.001;           // slack added to the predicted tail
+
+    int swapInterval() const { return mode == PaceMode::Vsync ? 1 : 0; }
+
+    void beginFrame();                  // target mode without low latency: wait for the tick
+    void waitForInput();                // low latency: wait until the late sampling point
+    void inputSampled();                // input has just been polled
+    void beforePresent();               // frame work done, about to swap
+    void presented();                   // swap returned
+    // Seconds from the last input poll to the present that followed it
+    double lastInputToPresent() const { return inputToPresent; }
+
+    // Time spent sleeping and how far the wake-ups overshot, for reports
+    double sleptSeconds = 0, overshootSeconds = 0;
+    long sleeps = 0;
+
+private:
+    double nextTick = 0;                // target mode grid
+    double lastPresent = 0;
+    double sampleTime = 0;
+    double inputToPresent = -1;
+    std::vector<double> tail;           // recent sample-to-swap-call times
+    size_t tailNext = 0;
+
+    double deadline() const;
+    double predictedTail() const;
+    void sleepUntil(double t);
+};
+
+double pacerNow();
@@ -0,0 +1,103 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ------------------------------------------------------------
+// Histogram
+// ------------------------------------------------------------
+static int bucketOf(uint64_t us){
+    if(us < (uint64_t)LatencyHistogram::kSub) return (int)us;
+    int msb = 63;
+    while(!(us >> msb)) --msb;
+    const int shift = msb - (LatencyHistogram::kSubBits - 1);         // us >> shift lies in [kHalf, kSub)
+    const int idx = (shift + 1) * LatencyHistogram::kHalf + (int)(us >> shift) - LatencyHistogram::kHalf;
+    return std::min(idx, LatencyHistogram::kBuckets - 1);
+}
+
+static uint64_t bucketUpperUs(int idx){
+    if(idx < LatencyHistogram::kSub) return (uint64_t)idx;
+    const int shift = idx / LatencyHistogram::kHalf - 1;
+    const uint64_t sub = (uint64_t)(idx % LatencyHistogram::kHalf + LatencyHistogram::kHalf);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(double ms){
+    if(!(ms >= 0.0)) return;
+    const uint64_t us = (uint64_t)std::llround(ms * 1000.0);
+    ++counts[bucketOf(us)];
+    ++total;
+    maxUs = std::max(maxUs, us);
+    sumUs += (double)us;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& o){
+    for(int i=0;i<kBuckets;++i) counts[i] += o.counts[i];
+    total += o.total;
+    maxUs = std::max(maxUs, o.maxUs);
+    sumUs += o.sumUs;
+}
+
+void LatencyHistogram::reset(){ *this = LatencyHistogram{}; }
+
+double LatencyHistogram::percentile(double p) const {
+    if(total == 0) return 0.0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(p * (double)total));
+    uint64_t seen = 0;
+    for(int i=0;i<kBuckets;++i){
+        seen += counts[i];
+        if(seen >= rank) return (double)std::min(bucketUpperUs(i), maxUs) * 1e-3;
+    }
+    return maxMs();
+}
+
+// ------------------------------------------------------------
+// Frame statistics
+// ------------------------------------------------------------
+static const char* const kMetricNames[FrameStats::kMetricCount] = { "frame", "cpu", "swap", "gpu", "input" };
+
+const char* FrameStats::metricName(int m){ return m >= 0 && m < kMetricCount ? kMetricNames[m] : "?"; }
+
+bool FrameStats::init(const char* csvPath){
+    if(!csvPath) return true;
+    csv = std::fopen(csvPath, "w");
+    if(!csv){ std::fprintf(stderr, "Failed to open %s for writing\n", csvPath); return false; }
+    std::fprintf(csv, "frame,time_s,frame_ms,cpu_ms,swap_ms,gpu_ms,input_ms\n");
+    return true;
+}
+
+void FrameStats::record(long frame, double timeSeconds, const Sample& s){
+    const double v[kMetricCount] = { s.frameMs, s.cpuMs, s.swapMs, s.gpuMs, s.inputMs };
+    for(int m=0;m<kMetricCount;++m){ window[m].record(v[m]); run[m].record(v[m]); }
+    ++windowFrames; ++totalFrames;
+    if(csv){
+        // Unmeasured values are left empty
+        std::fprintf(csv, "%ld,%.6f", frame, timeSeconds);
+        for(double x : v){
+            if(x >= 0.0) std::fprintf(csv, ",%.4f", x);
+            else std::fputc(',', csv);
+        }
+        std::fputc('\n', csv);
+    }
+}
+
+void FrameStats::summary(std::FILE* out, const char* label, bool wholeRun) const {
+    const LatencyHistogram* h = wholeRun ? run : window;
+    std::fprintf(out, "%s: %ld frames\n  %-6s %8s %8s %8s %8s %8s %8s\n", label, wholeRun ? totalFrames : windowFrames,
+                 "ms", "p50", "p90", "p99", "p99.9", "max", "mean");
+    for(int m=0;m<kMetricCount;++m){
+        if(h[m].total == 0) continue;
+        std::fprintf(out, "  %-6s %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n", kMetricNames[m],
+                     h[m].percentile(0.50), h[m].percentile(0.90), h[m].percentile(0.99),
+                     h[m].percentile(0.999), h[m].maxMs(), h[m].meanMs());
+    }
+}
+
+void FrameStats::restartWindow(){
+    for(LatencyHistogram& h : window) h.reset();
+    windowFrames = 0;
+}
+
+void FrameStats::destroy(){
+    if(csv){ std::fclose(csv); csv = nullptr; }
+}
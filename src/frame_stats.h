@@ -0,0 +1,57 @@
+// Frame-time statistics: log-linear histograms, percentiles and CSV export.
+//
+// LatencyHistogram buckets microsecond values HdrHistogram-style: exact below
+// 128 us, then 64 linear sub-buckets per power of two (under 1.6% relative
+// error) up to over a day, in a fixed 8 KB table. Recording is a couple
+// of shifts and an increment, and percentiles walk the table, so any number of
+// frames costs the same.
+//
+// FrameStats keeps one histogram per metric (frame interval, CPU, swap, GPU
+// time and input-to-present latency) for the current window and one for the
+// whole run. summary() prints p50/p90/p99/p99.9/max for the window; the
+// caller restarts it after a periodic print. With a CSV path every frame is
+// also streamed as one row.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+struct LatencyHistogram {
+    static constexpr int kSubBits = 7;
+    static constexpr int kSub = 1 << kSubBits;          // exact values below this
+    static constexpr int kHalf = kSub / 2;
+    static constexpr int kBuckets = 32 * kHalf;         // shifts up to 30
+
+    uint32_t counts[kBuckets] = {};
+    uint64_t total = 0;
+    uint64_t maxUs = 0;
+    double sumUs = 0;
+
+    void record(double ms);             // negative = not measured, ignored
+    void merge(const LatencyHistogram& o);
+    void reset();
+    // Upper bound (ms) of the bucket holding the p-quantile, capped at the max
+    double percentile(double p) const;
+    double maxMs() const { return (double)maxUs * 1e-3; }
+    double meanMs() const { return total ? sumUs * 1e-3 / (double)total : 0.0; }
+};
+
+struct FrameStats {
+    enum Metric { Frame, Cpu, Swap, Gpu, Input, kMetricCount };
+    struct Sample { double frameMs = -1, cpuMs = -1, swapMs = -1, gpuMs = -1, inputMs = -1; };
+    static const char* metricName(int m);
+
+    // csvPath may be null; returns false if the CSV cannot be opened
+    bool init(const char* csvPath);
+    void record(long frame, double timeSeconds, const Sample& s);
+    // Prints the window (or the whole run) to `out`; label heads the table
+    void summary(std::FILE* out, const char* label, bool wholeRun) const;
+    void restartWindow();
+    void destroy();
+
+    long windowFrames = 0, totalFrames = 0;
+    LatencyHistogram window[kMetricCount], run[kMetricCount];
+
+private:
+    std::FILE* csv = nullptr;
+};
@@ -0,0 +1,347 @@
+#include "gl_record.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace glrec {
+
+namespace {
+
+struct Recorder {
+    std::FILE* file = nullptr;
+    const char* path = nullptr;
+    std::vector<uint8_t> buf;
+    long fromFrame = 0, toFrame = 0;
+    uint32_t frames = 0;
+    uint64_t bytes = 0;
+    std::vector<std::function<void()>> restore;     // puts the original pointers back
+
+    // Driver state the payload sizes depend on
+    GLint unpackAlignment = 4;
+    GLuint packBuffer = 0;
+    struct Mapping { GLenum target; void* ptr; GLsizeiptr length; GLbitfield access; };
+    std::vector<Mapping> maps;
+};
+
+Recorder g;
+
+void flush(){
+    if(g.buf.empty()) return;
+    if(std::fwrite(g.buf.data(), 1, g.buf.size(), g.file) != g.buf.size())
+        std::fprintf(stderr, "Failed to write %s\n", g.path);
+    g.bytes += g.buf.size();
+    g.buf.clear();
+}
+
+template<class T> void put(const T& v){
+    static_assert(std::is_trivially_copyable<T>::value, "recorded arguments are raw bytes");
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+    g.buf.insert(g.buf.end(), p, p + sizeof(T));
+}
+
+void putOp(Op op){
+    if(g.buf.size() >= (1u << 20)) flush();
+    put((uint16_t)op);
+}
+
+void putBytes(const void* data, size_t n){
+    put((uint64_t)n);
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    if(n) g.buf.insert(g.buf.end(), p, p + n);
+}
+
+// ------------------------------------------------------------
+// Wrappers
+// ------------------------------------------------------------
+// Arguments that are plain values (pointer-typed offsets included) record as-is
+template<Op op, class R, class... A> struct Plain {
+    static R (APIENTRYP real)(A...);
+    static R APIENTRY call(A... a){
+        putOp(op);
+        (put(a), ...);
+        if constexpr(std::is_void<R>::value) real(a...);
+        else { R r = real(a...); put(r); return r; }
+    }
+};
+template<Op op, class R, class... A> R (APIENTRYP Plain<op, R, A...>::real)(A...) = nullptr;
+
+template<Op op, class R, class... A> void hook(R (APIENTRYP& slot)(A...)){
+    Plain<op, R, A...>::real = slot;
+    slot = &Plain<op, R, A...>::call;
+    g.restore.push_back([&slot]{ slot = Plain<op, R, A...>::real; });
+}
+
+// Hand-written wrappers keep their original pointer in `real`
+template<class F> void hookCustom(F& slot, F& real, F wrapper){
+    real = slot;
+    slot = wrapper;
+    g.restore.push_back([&slot, &real]{ slot = real; });
+}
+
+// Gen*/Delete*: the name arrays are the payload (every object type shares the signatures)
+template<Op op> struct GenNames {
+    static PFNGLGENBUFFERSPROC real;
+    static void APIENTRY call(GLsizei n, GLuint* names){
+        real(n, names);
+        putOp(op); putBytes(names, (size_t)n * sizeof(GLuint));
+    }
+};
+template<Op op> PFNGLGENBUFFERSPROC GenNames<op>::real = nullptr;
+
+template<Op op> struct DeleteNames {
+    static PFNGLDELETEBUFFERSPROC real;
+    static void APIENTRY call(GLsizei n, const GLuint* names){
+        putOp(op); putBytes(names, (size_t)n * sizeof(GLuint));
+        real(n, names);
+    }
+};
+template<Op op> PFNGLDELETEBUFFERSPROC DeleteNames<op>::real = nullptr;
+
+template<Op op> void hookGen(PFNGLGENBUFFERSPROC& slot){ hookCustom(slot, GenNames<op>::real, &GenNames<op>::call); }
+template<Op op> void hookDelete(PFNGLDELETEBUFFERSPROC& slot){ hookCustom(slot, DeleteNames<op>::real, &DeleteNames<op>::call); }
+
+PFNGLBUFFERDATAPROC rBufferData;
+void APIENTRY wBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage){
+    putOp(Op::BufferData); put(target); put(size); put(usage);
+    putBytes(data, data ? (size_t)size : 0);
+    rBufferData(target, size, data, usage);
+}
+
+PFNGLBUFFERSUBDATAPROC rBufferSubData;
+void APIENTRY wBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data){
+    putOp(Op::BufferSubData); put(target); put(offset);
+    putBytes(data, (size_t)size);
+    rBufferSubData(target, offset, size, data);
+}
+
+PFNGLSHADERSOURCEPROC rShaderSource;
+void APIENTRY wShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths){
+    std::vector<char> text;
+    for(GLsizei i=0;i<count;++i){
+        const size_t n = lengths && lengths[i] >= 0 ? (size_t)lengths[i] : std::strlen(strings[i]);
+        text.insert(text.end(), strings[i], strings[i] + n);
+    }
+    putOp(Op::ShaderSource); put(shader); putBytes(text.data(), text.size());
+    rShaderSource(shader, count, strings, lengths);
+}
+
+PFNGLGETUNIFORMLOCATIONPROC rGetUniformLocation;
+GLint APIENTRY wGetUniformLocation(GLuint program, const GLchar* name){
+    const GLint loc = rGetUniformLocation(program, name);
+    putOp(Op::GetUniformLocation); put(program); put(loc); putBytes(name, std::strlen(name));
+    return loc;
+}
+
+PFNGLGETUNIFORMBLOCKINDEXPROC rGetUniformBlockIndex;
+GLuint APIENTRY wGetUniformBlockIndex(GLuint program, const GLchar* name){
+    const GLuint index = rGetUniformBlockIndex(program, name);
+    putOp(Op::GetUniformBlockIndex); put(program); put(index); putBytes(name, std::strlen(name));
+    return index;
+}
+
+PFNGLPIXELSTOREIPROC rPixelStorei;
+void APIENTRY wPixelStorei(GLenum pname, GLint param){
+    if(pname == GL_UNPACK_ALIGNMENT) g.unpackAlignment = param;
+    putOp(Op::PixelStorei); put(pname); put(param);
+    rPixelStorei(pname, param);
+}
+
+PFNGLBINDBUFFERPROC rBindBuffer;
+void APIENTRY wBindBuffer(GLenum target, GLuint buffer){
+    if(target == GL_PIXEL_PACK_BUFFER) g.packBuffer = buffer;
+    putOp(Op::BindBuffer); put(target); put(buffer);
+    rBindBuffer(target, buffer);
+}
+
+// Bytes per pixel of the client formats we upload; 0 = unknown
+size_t pixelBytes(GLenum format, GLenum type){
+    size_t comps = 0;
+    switch(format){
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: comps = 1; break;
+        case GL_RG: comps = 2; break;
+        case GL_RGB: case GL_BGR: comps = 3; break;
+        case GL_RGBA: case GL_BGRA: comps = 4; break;
+        default: return 0;
+    }
+    switch(type){
+        case GL_UNSIGNED_BYTE: case GL_BYTE: return comps;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return comps * 2;
+        case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return comps * 4;
+        default: return 0;
+    }
+}
+
+PFNGLTEXIMAGE2DPROC rTexImage2D;
+void APIENTRY wTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei w, GLsizei h, GLint border,
+                          GLenum format, GLenum type, const void* pixels){
+    size_t size = 0;
+    if(pixels){
+        const size_t bpp = pixelBytes(format, type);
+        const size_t align = (size_t)(g.unpackAlignment > 0 ? g.unpackAlignment : 1);
+        const size_t row = ((size_t)w * bpp + align - 1) / align * align;
+        size = (size_t)(h > 0 ? h - 1 : 0) * row + (size_t)w * bpp;
+        if(bpp == 0) std::fprintf(stderr, "gl record: glTexImage2D format 0x%x/0x%x not recorded\n", format, type);
+    }
+    putOp(Op::TexImage2D); put(target); put(level); put(internalFormat); put(w); put(h); put(border);
+    put(format); put(type);
+    putBytes(pixels, size);
+    rTexImage2D(target, level, internalFormat, w, h, border, format, type, pixels);
+}
+
+PFNGLREADPIXELSPROC rReadPixels;
+void APIENTRY wReadPixels(GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, void* pixels){
+    // Into a pack buffer `pixels` is an offset; into client memory the replay uses scratch
+    const uint8_t toBuffer = g.packBuffer != 0;
+    putOp(Op::ReadPixels); put(x); put(y); put(w); put(h); put(format); put(type); put(toBuffer);
+    put(toBuffer ? pixels : nullptr);
+    rReadPixels(x, y, w, h, format, type, pixels);
+}
+
+PFNGLMAPBUFFERRANGEPROC rMapBufferRange;
+void* APIENTRY wMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access){
+    void* p = rMapBufferRange(target, offset, length, access);
+    putOp(Op::MapBufferRange); put(target); put(offset); put(length); put(access);
+    if(p) g.maps.push_back({target, p, length, access});
+    return p;
+}
+
+PFNGLUNMAPBUFFERPROC rUnmapBuffer;
+GLboolean APIENTRY wUnmapBuffer(GLenum target){
+    // Whatever the app wrote through the mapping is the payload
+    const void* data = nullptr; size_t size = 0;
+    for(size_t i=0;i<g.maps.size();++i){
+        if(g.maps[i].target != target) continue;
+        if(g.maps[i].access & GL_MAP_WRITE_BIT){ data = g.maps[i].ptr; size = (size_t)g.maps[i].length; }
+        g.maps.erase(g.maps.begin() + (std::ptrdiff_t)i);
+        break;
+    }
+    putOp(Op::UnmapBuffer); put(target); putBytes(data, size);
+    return rUnmapBuffer(target);
+}
+
+void installHooks(){
+    hook<Op::Enable>(glad_glEnable);
+    hook<Op::Disable>(glad_glDisable);
+    hook<Op::BlendFunc>(glad_glBlendFunc);
+    hook<Op::DepthMask>(glad_glDepthMask);
+    hook<Op::CullFace>(glad_glCullFace);
+    hook<Op::Viewport>(glad_glViewport);
+    hook<Op::ClearColor>(glad_glClearColor);
+    hook<Op::Clear>(glad_glClear);
+    hookCustom(glad_glPixelStorei, rPixelStorei, &wPixelStorei);
+    hook<Op::ActiveTexture>(glad_glActiveTexture);
+    hook<Op::TexParameteri>(glad_glTexParameteri);
+    hook<Op::VertexAttribDivisor>(glad_glVertexAttribDivisor);
+    hook<Op::EnableVertexAttribArray>(glad_glEnableVertexAttribArray);
+    hook<Op::VertexAttribPointer>(glad_glVertexAttribPointer);
+    hook<Op::VertexAttribIPointer>(glad_glVertexAttribIPointer);
+    hook<Op::DrawArraysInstanced>(glad_glDrawArraysInstanced);
+    hook<Op::DrawElementsInstancedBaseVertex>(glad_glDrawElementsInstancedBaseVertex);
+    hook<Op::Finish>(glad_glFinish);
+
+    hookCustom(glad_glBindBuffer, rBindBuffer, &wBindBuffer);
+    hook<Op::BindVertexArray>(glad_glBindVertexArray);
+    hook<Op::BindTexture>(glad_glBindTexture);
+    hook<Op::UseProgram>(glad_glUseProgram);
+    hook<Op::BindBufferBase>(glad_glBindBufferBase);
+    hook<Op::TexBuffer>(glad_glTexBuffer);
+    hook<Op::BindRenderbuffer>(glad_glBindRenderbuffer);
+    hook<Op::RenderbufferStorage>(glad_glRenderbufferStorage);
+    hook<Op::BindFramebuffer>(glad_glBindFramebuffer);
+    hook<Op::FramebufferRenderbuffer>(glad_glFramebufferRenderbuffer);
+
+    hook<Op::CreateShader>(glad_glCreateShader);
+    hookCustom(glad_glShaderSource, rShaderSource, &wShaderSource);
+    hook<Op::CompileShader>(glad_glCompileShader);
+    hook<Op::CreateProgram>(glad_glCreateProgram);
+    hook<Op::AttachShader>(glad_glAttachShader);
+    hook<Op::LinkProgram>(glad_glLinkProgram);
+    hook<Op::DeleteShader>(glad_glDeleteShader);
+    hook<Op::DeleteProgram>(glad_glDeleteProgram);
+    hookCustom(glad_glGetUniformLocation, rGetUniformLocation, &wGetUniformLocation);
+    hookCustom(glad_glGetUniformBlockIndex, rGetUniformBlockIndex, &wGetUniformBlockIndex);
+    hook<Op::UniformBlockBinding>(glad_glUniformBlockBinding);
+    hook<Op::Uniform1i>(glad_glUniform1i);
+    hook<Op::Uniform1f>(glad_glUniform1f);
+    hook<Op::Uniform2i>(glad_glUniform2i);
+    hook<Op::Uniform2f>(glad_glUniform2f);
+    hook<Op::Uniform3f>(glad_glUniform3f);
+
+    hookGen<Op::GenBuffers>(glad_glGenBuffers);
+    hookDelete<Op::DeleteBuffers>(glad_glDeleteBuffers);
+    hookGen<Op::GenVertexArrays>(glad_glGenVertexArrays);
+    hookDelete<Op::DeleteVertexArrays>(glad_glDeleteVertexArrays);
+    hookGen<Op::GenTextures>(glad_glGenTextures);
+    hookDelete<Op::DeleteTextures>(glad_glDeleteTextures);
+    hookGen<Op::GenRenderbuffers>(glad_glGenRenderbuffers);
+    hookDelete<Op::DeleteRenderbuffers>(glad_glDeleteRenderbuffers);
+    hookGen<Op::GenFramebuffers>(glad_glGenFramebuffers);
+    hookDelete<Op::DeleteFramebuffers>(glad_glDeleteFramebuffers);
+
+    hookCustom(glad_glBufferData, rBufferData, &wBufferData);
+    hookCustom(glad_glBufferSubData, rBufferSubData, &wBufferSubData);
+    hookCustom(glad_glTexImage2D, rTexImage2D, &wTexImage2D);
+    hookCustom(glad_glReadPixels, rReadPixels, &wReadPixels);
+    hookCustom(glad_glMapBufferRange, rMapBufferRange, &wMapBufferRange);
+    hookCustom(glad_glUnmapBuffer, rUnmapBuffer, &wUnmapBuffer);
+}
+
+} // namespace
+
+bool start(const char* path, int width, int height, long fromFrame, long frames){
+    if(g.file) return false;
+    g.file = std::fopen(path, "wb");
+    if(!g.file){ std::fprintf(stderr, "Failed to open %s for writing\n", path); return false; }
+    g.path = path;
+    g.fromFrame = fromFrame;
+    g.toFrame = fromFrame + (frames > 0 ? frames : 1);
+    g.frames = 0;
+    g.bytes = 0;
+    g.buf.reserve(2u << 20);
+
+    FileHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.pointerSize = (uint32_t)sizeof(void*);
+    h.width = width; h.height = height;
+    put(h);
+
+    // Nobody can tell the recorder what is already bound: start from a known state
+    GLint pack = 0; glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack); g.packBuffer = (GLuint)pack;
+    GLint unpack = 4; glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack); g.unpackAlignment = unpack;
+    installHooks();
+    return true;
+}
+
+bool active(){ return g.file != nullptr; }
+
+void frame(long index){
+    if(!g.file) return;
+    if(index >= g.toFrame){ stop(); return; }
+    if(index < g.fromFrame) return;
+    putOp(Op::Frame); put((uint32_t)index);
+    ++g.frames;
+}
+
+void stop(){
+    if(!g.file) return;
+    for(auto& r : g.restore) r();
+    g.restore.clear();
+    flush();
+    // Patch the frame count into the header
+    bool ok = std::fseek(g.file, (long)offsetof(FileHeader, frames), SEEK_SET) == 0 &&
+              std::fwrite(&g.frames, sizeof(g.frames), 1, g.file) == 1;
+    ok = std::fclose(g.file) == 0 && ok;
+    g.file = nullptr;
+    g.maps.clear();
+    if(!ok) std::fprintf(stderr, "Failed to write %s\n", g.path);
+    else std::printf("gl record: %s, %u frame(s) after the setup prefix, %.1f KB\n", g.path, g.frames, (double)g.bytes / 1024.0);
+}
+
+} // namespace glrec
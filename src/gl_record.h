@@ -0,0 +1,63 @@
+// GL call recording for offline replay (skeleton_replay).
+//
+// start() swaps GLAD's function pointers for recording wrappers, so every
+// state change, object creation, upload and draw the app issues is appended
+// to a binary file, payloads included, while still reaching the driver.
+// Recording begins right after context creation; frames before `fromFrame`
+// are the setup prefix that the replayer runs once, and the `frames` frames
+// from there on are the body it re-issues in a loop. After the last recorded
+// frame the original pointers are restored and the file is closed, so the
+// rest of the run pays nothing.
+//
+// Object names, uniform locations and block indices are recorded as the
+// driver returned them and remapped on replay. Queries, fences and getters
+// are not recorded: they only feed our own measurements and would stall a
+// replay that has no consumer for them.
+//
+// File: 32-byte header (magic "SKGLREC1", format version, pointer size,
+// framebuffer size, recorded frame count) followed by commands, each a
+// uint16 Op and its arguments in native layout; variable payloads are a
+// uint64 byte count and the bytes. Files only replay on the same ABI.
+#pragma once
+
+#include <cstdint>
+
+namespace glrec {
+
+constexpr char kMagic[8] = {'S','K','G','L','R','E','C','1'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pointerSize;
+    int32_t width, height;
+    uint32_t frames;                    // frames after the setup prefix
+    uint32_t reserved;
+};
+
+enum class Op : uint16_t {
+    Frame = 1,                          // start of a recorded frame (uint32 index)
+    Enable, Disable, BlendFunc, DepthMask, CullFace, Viewport, ClearColor, Clear,
+    PixelStorei, ActiveTexture, TexParameteri,
+    VertexAttribDivisor, EnableVertexAttribArray, VertexAttribPointer, VertexAttribIPointer,
+    DrawArraysInstanced, DrawElementsInstancedBaseVertex, Finish,
+    BindBuffer, BindVertexArray, BindTexture, UseProgram, BindBufferBase, TexBuffer,
+    BindRenderbuffer, RenderbufferStorage, BindFramebuffer, FramebufferRenderbuffer,
+    CreateShader, ShaderSource, CompileShader, CreateProgram, AttachShader, LinkProgram,
+    DeleteShader, DeleteProgram,
+    GetUniformLocation, GetUniformBlockIndex, UniformBlockBinding,
+    Uniform1i, Uniform1f, Uniform2i, Uniform2f, Uniform3f,
+    GenBuffers, DeleteBuffers, GenVertexArrays, DeleteVertexArrays, GenTextures, DeleteTextures,
+    GenRenderbuffers, DeleteRenderbuffers, GenFramebuffers, DeleteFramebuffers,
+    BufferData, BufferSubData, TexImage2D, ReadPixels, MapBufferRange, UnmapBuffer,
+    Count
+};
+
+// Call with the context current and GLAD loaded; false if the file cannot be opened
+bool start(const char* path, int width, int height, long fromFrame, long frames);
+void frame(long index);                 // at the top of every frame, before any GL call
+bool active();
+void stop();                            // restores GLAD, finishes the file (also called by frame())
+
+} // namespace glrec
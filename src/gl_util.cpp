@@ -0,0 +1,41 @@
+#include "gl_util.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "image_io.h"
+
+GLuint compileShader(GLenum type, const char* src){
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, nullptr);
+    glCompileShader(s);
+    GLint ok = 0; glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if(!ok){
+        char log[1024]; glGetShaderInfoLog(s, 1024, nullptr, log);
+        std::fprintf(stderr, "Shader compile error: %s\n", log);
+    }
+    return s;
+}
+
+GLuint makeProgram(const char* vsSrc, const char* fsSrc){
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc);
+    GLuint p = glCreateProgram();
+    glAttachShader(p, vs);
+    glAttachShader(p, fs);
+    glLinkProgram(p);
+    GLint ok = 0; glGetProgramiv(p, GL_LINK_STATUS, &ok);
+    if(!ok){
+        char log[1024]; glGetProgramInfoLog(p, 1024, nullptr, log);
+        std::fprintf(stderr, "Link error: %s\n", log);
+    }
+    glDeleteShader(vs); glDeleteShader(fs);
+    return p;
+}
+
+bool writeFramebufferPPM(const char* path, int w, int h){
+    std::vector<uint8_t> px((size_t)w * (size_t)h * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, px.data());
+    return writePPM(path, w, h, px.data(), /*bottomUp=*/true);
+}
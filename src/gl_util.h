@@ -0,0 +1,10 @@
+// Small OpenGL helpers shared by the render paths.
+#pragma once
+
+#include <glad/glad.h>
+
+GLuint compileShader(GLenum type, const char* src);
+GLuint makeProgram(const char* vsSrc, const char* fsSrc);
+
+// Read back the current read framebuffer and save it as PPM
+bool writeFramebufferPPM(const char* path, int w, int h);
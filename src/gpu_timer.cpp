@@ -0,0 +1,76 @@
+#include "gpu_timer.h"
+
+#include <cstring>
+
+void GpuTimer::init(int ringFrames){
+    frames.resize((size_t)(ringFrames < 2 ? 2 : ringFrames));
+    for(Frame& f : frames) glGenQueries(kMaxPasses + 1, f.queries);
+    last.reserve(kMaxPasses);
+}
+
+void GpuTimer::beginFrame(){
+    if(frames.empty()) return;
+    resolve();
+    Frame& f = frames[cursor];
+    if(f.inFlight){ ++dropped; f.inFlight = false; }    // results still pending: overwrite
+    f.marks = 0;
+    glQueryCounter(f.queries[0], GL_TIMESTAMP);
+    recording = true;
+}
+
+void GpuTimer::mark(const char* pass){
+    if(!recording) return;
+    Frame& f = frames[cursor];
+    if(f.marks == kMaxPasses) return;
+    f.names[f.marks] = pass;
+    glQueryCounter(f.queries[++f.marks], GL_TIMESTAMP);
+}
+
+void GpuTimer::endFrame(){
+    if(!recording) return;
+    recording = false;
+    frames[cursor].inFlight = frames[cursor].marks > 0;
+    cursor = (cursor + 1) % frames.size();
+}
+
+// Oldest in-flight frame first; stop at the first one not ready yet
+void GpuTimer::resolve(){
+    for(size_t i=0;i<frames.size();++i){
+        Frame& f = frames[(cursor + i) % frames.size()];
+        if(!f.inFlight) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(f.queries[f.marks], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available) break;
+
+        GLuint64 stamps[kMaxPasses + 1];
+        for(int q=0;q<=f.marks;++q) glGetQueryObjectui64v(f.queries[q], GL_QUERY_RESULT, &stamps[q]);
+        last.clear();
+        for(int p=0;p<f.marks;++p){
+            const double passMs = (double)(stamps[p+1] - stamps[p]) * 1e-6;
+            last.push_back({f.names[p], passMs});
+            auto it = sums.begin();
+            while(it != sums.end() && std::strcmp(it->name, f.names[p]) != 0) ++it;
+            if(it == sums.end()) sums.push_back({f.names[p], passMs, 1});
+            else { it->ms += passMs; ++it->count; }
+        }
+        lastFrameMs = (double)(stamps[f.marks] - stamps[0]) * 1e-6;
+        f.inFlight = false;
+        ++resolved;
+    }
+}
+
+double GpuTimer::ms(const char* pass) const {
+    for(const Pass& p : last) if(std::strcmp(p.name, pass) == 0) return p.ms;
+    return -1.0;
+}
+
+std::vector<GpuTimer::Pass> GpuTimer::averages() const {
+    std::vector<Pass> out;
+    for(const Sum& s : sums) out.push_back({s.name, s.ms / (double)s.count});
+    return out;
+}
+
+void GpuTimer::destroy(){
+    for(Frame& f : frames) glDeleteQueries(kMaxPasses + 1, f.queries);
+    frames.clear();
+}
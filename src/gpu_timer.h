@@ -0,0 +1,51 @@
+// GPU pass timing with timestamp queries.
+//
+// beginFrame() and each mark() drop a glQueryCounter(GL_TIMESTAMP); a pass's
+// GPU time is the gap between its mark and the previous one. Timestamps,
+// unlike GL_TIME_ELAPSED, may interleave with other queries (the crowd's own
+// elapsed-time query). Frames live in a ring and are resolved, oldest first,
+// once their last query is available, so results arrive a few frames late
+// and never stall. A frame whose slot comes round again unresolved is dropped.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+struct GpuTimer {
+    static constexpr int kMaxPasses = 16;
+    struct Pass { const char* name; double ms; };
+
+    void init(int ringFrames = 4);
+    void beginFrame();
+    void mark(const char* pass);    // end of `pass` (name must outlive the timer)
+    void endFrame();
+    void destroy();
+
+    // Latest resolved frame; -1 until one is available or if the pass was not seen
+    double ms(const char* pass) const;
+    double frameMs() const { return lastFrameMs; }
+    const std::vector<Pass>& lastPasses() const { return last; }
+    // Mean of every resolved frame, per pass, in first-seen order
+    std::vector<Pass> averages() const;
+
+    long resolved = 0, dropped = 0;
+
+private:
+    struct Frame {
+        GLuint queries[kMaxPasses + 1] = {};
+        const char* names[kMaxPasses] = {};
+        int marks = 0;
+        bool inFlight = false;
+    };
+    std::vector<Frame> frames;
+    size_t cursor = 0;              // frame being recorded
+    bool recording = false;
+    std::vector<Pass> last;
+    double lastFrameMs = -1;
+    struct Sum { const char* name; double ms; long count; };
+    std::vector<Sum> sums;
+
+    void resolve();
+};
@@ -0,0 +1,97 @@
+#include "head_mesh.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/constants.hpp>
+
+// ------------------------------------------------------------
+// Shape definitions
+// ------------------------------------------------------------
+// Each shape acts on a cap of the unit sphere around `dir` (face is +Z,
+// up is +Y) with a smooth falloff to zero at `angle` radians. The delta
+// is a fixed offset, a push along the normal, or both, in units of radius.
+struct ShapeDef {
+    const char* name;
+    glm::vec3 dir;
+    float angle;
+    glm::vec3 offset;
+    float normalPush;
+};
+
+static const ShapeDef kShapes[] = {
+    { "jawOpen",    { 0.0f, -0.6f, 0.8f}, 0.9f, { 0.0f, -0.25f, 0.05f}, 0.0f },
+    { "jawLeft",    { 0.0f, -0.6f, 0.8f}, 0.8f, { 0.12f, 0.0f, 0.0f},  0.0f },
+    { "jawRight",   { 0.0f, -0.6f, 0.8f}, 0.8f, {-0.12f, 0.0f, 0.0f},  0.0f },
+    { "smile",      { 0.0f, -0.3f, 0.95f}, 0.6f, { 0.0f, 0.06f, 0.0f},  0.06f },
+    { "browRaise",  { 0.0f, 0.45f, 0.9f}, 0.6f, { 0.0f, 0.10f, 0.0f},  0.0f },
+    { "cheekPuffL", { 0.7f, -0.2f, 0.7f}, 0.6f, { 0.0f, 0.0f, 0.0f},   0.18f },
+    { "cheekPuffR", {-0.7f, -0.2f, 0.7f}, 0.6f, { 0.0f, 0.0f, 0.0f},   0.18f },
+    { "noseOut",    { 0.0f, 0.05f, 1.0f}, 0.35f, { 0.0f, 0.0f, 0.0f},  0.30f },
+};
+static constexpr int kShapeCount = (int)(sizeof(kShapes) / sizeof(kShapes[0]));
+
+// Entries below this fraction of the shape's peak are dropped
+static constexpr float kSparseEpsilon = 1e-3f;
+
+// ------------------------------------------------------------
+// Mesh
+// ------------------------------------------------------------
+HeadMesh buildHeadMesh(float radius, int stacks, int slices){
+    HeadMesh m;
+    const glm::vec3 center(0, radius, 0);
+    std::vector<glm::vec3> unit;
+    for(int i=0;i<=stacks;i++){
+        float phi = (float)i / (float)stacks * glm::pi<float>();
+        for(int j=0;j<=slices;j++){
+            float theta = (float)j / (float)slices * glm::two_pi<float>();
+            glm::vec3 d(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            unit.push_back(d);
+            m.positions.push_back(center + radius * d);
+        }
+    }
+    const uint32_t row = (uint32_t)slices + 1;
+    for(uint32_t i=1;i<=(uint32_t)stacks;i++){
+        for(uint32_t j=0;j<(uint32_t)slices;j++){
+            uint32_t p00 = (i-1)*row + j, p01 = p00 + 1;
+            uint32_t p10 = i*row + j,     p11 = p10 + 1;
+            m.indices.insert(m.indices.end(), {p00, p10, p11, p00, p11, p01});
+        }
+    }
+
+    for(int s=0;s<kShapeCount;++s) m.shapeNames.push_back(kShapes[s].name);
+
+    m.morphFirst.resize(m.positions.size());
+    m.morphCount.resize(m.positions.size());
+    for(size_t v=0;v<unit.size();++v){
+        m.morphFirst[v] = (uint32_t)m.morphEntries.size();
+        for(int s=0;s<kShapeCount;++s){
+            const ShapeDef& d = kShapes[s];
+            float a = std::acos(glm::clamp(glm::dot(unit[v], glm::normalize(d.dir)), -1.0f, 1.0f));
+            if(a >= d.angle) continue;
+            float f = 0.5f + 0.5f * std::cos(a / d.angle * glm::pi<float>());   // 1 at the center, 0 at the rim
+            if(f < kSparseEpsilon) continue;
+            glm::vec3 delta = radius * f * (d.offset + d.normalPush * unit[v]);
+            m.morphEntries.push_back(glm::vec4(delta, (float)s));
+        }
+        m.morphCount[v] = (uint32_t)m.morphEntries.size() - m.morphFirst[v];
+    }
+    return m;
+}
+
+void headShapeWeights(float t, float seed, float* w, int shapeCount){
+    std::fill(w, w + shapeCount, 0.0f);
+    if(shapeCount < kShapeCount) return;
+    const float s = seed * 6.2831853f;
+    // Talking: fast jaw flutter gated by a slower sentence rhythm
+    float talk = std::max(0.0f, std::sin(t * 0.9f + s));
+    w[0] = talk * (0.5f + 0.5f * std::sin(t * 11.0f + s * 3.0f));
+    w[1] = 0.3f * std::max(0.0f, std::sin(t * 1.3f + s));
+    w[2] = 0.3f * std::max(0.0f, -std::sin(t * 1.3f + s));
+    w[3] = 0.5f + 0.5f * std::sin(t * 0.4f + s * 2.0f);
+    w[4] = std::pow(std::max(0.0f, std::sin(t * 0.7f + s * 5.0f)), 8.0f);
+    float puff = std::pow(std::max(0.0f, std::sin(t * 0.25f + s * 7.0f)), 4.0f);
+    w[5] = puff; w[6] = puff;
+    w[7] = 0.3f * std::pow(std::max(0.0f, std::sin(t * 0.5f + s * 11.0f)), 6.0f);
+}
+
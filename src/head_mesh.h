@@ -0,0 +1,34 @@
+// Indexed head mesh with sparse blendshapes (morph targets).
+//
+// Deltas are stored per vertex in CSR form: vertex v owns entries
+// [morphFirst[v], morphFirst[v] + morphCount[v]) of morphEntries, each holding
+// the xyz offset and the shape index in w. Only vertices a shape actually moves
+// get an entry, so memory and per-vertex shader work scale with the amount of
+// deformation, not with vertices * shapes.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct HeadMesh {
+    std::vector<glm::vec3> positions;       // head-bone local, sphere resting on the neck joint
+    std::vector<uint32_t> indices;          // triangle list
+    std::vector<uint32_t> morphFirst;       // per vertex
+    std::vector<uint32_t> morphCount;       // per vertex
+    std::vector<glm::vec4> morphEntries;    // xyz = delta, w = shape index
+    std::vector<const char*> shapeNames;
+
+    int shapeCount() const { return (int)shapeNames.size(); }
+    size_t sparseBytes() const { return morphEntries.size() * sizeof(glm::vec4); }
+    size_t denseBytes() const { return positions.size() * shapeNames.size() * sizeof(glm::vec3); }
+};
+
+// UV sphere of the given radius (same tessellation as buildHeadSphereTris)
+// with the built-in facial shapes attached.
+HeadMesh buildHeadMesh(float radius, int stacks=16, int slices=24);
+
+// Procedural facial animation: fills shapeCount weights for time t. seed
+// decorrelates instances.
+void headShapeWeights(float t, float seed, float* weights, int shapeCount);
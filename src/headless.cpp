@@ -0,0 +1,86 @@
+#include "headless.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if SKEL_HEADLESS
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+bool HeadlessContext::init(int w, int h){
+    if(w <= 0 || h <= 0){ std::fprintf(stderr, "Bad headless size %dx%d\n", w, h); return false; }
+
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(getPlatformDisplay) dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if(dpy == EGL_NO_DISPLAY) dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr)){
+        std::fprintf(stderr, "Failed to init EGL (0x%x)\n", eglGetError()); return false; }
+    display = dpy;
+
+    const char* ext = eglQueryString(dpy, EGL_EXTENSIONS);
+    if(!ext || !std::strstr(ext, "EGL_KHR_surfaceless_context")){
+        std::fprintf(stderr, "EGL_KHR_surfaceless_context not supported\n"); destroy(); return false; }
+
+    if(!eglBindAPI(EGL_OPENGL_API)){ std::fprintf(stderr, "EGL has no desktop OpenGL\n"); destroy(); return false; }
+    const EGLint configAttribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr; EGLint configs = 0;
+    eglChooseConfig(dpy, configAttribs, &config, 1, &configs);
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+    EGLContext ctx = eglCreateContext(dpy, configs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+    if(ctx == EGL_NO_CONTEXT){ std::fprintf(stderr, "Failed to create EGL context (0x%x)\n", eglGetError()); destroy(); return false; }
+    context = ctx;
+    if(!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)){
+        std::fprintf(stderr, "Failed to make EGL context current (0x%x)\n", eglGetError()); destroy(); return false; }
+
+    if(!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)){
+        std::fprintf(stderr, "Failed to init GLAD\n"); destroy(); return false; }
+
+    width = w; height = h;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &colorRb);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRb);
+    glGenRenderbuffers(1, &depthRb);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRb);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::fprintf(stderr, "Headless framebuffer %dx%d incomplete\n", w, h); destroy(); return false; }
+
+    std::printf("Headless: %s, %s, %dx%d\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION), w, h);
+    return true;
+}
+
+void HeadlessContext::destroy(){
+    EGLDisplay dpy = (EGLDisplay)display;
+    if(context){
+        if(fbo){
+            glDeleteFramebuffers(1, &fbo);
+            glDeleteRenderbuffers(1, &colorRb);
+            glDeleteRenderbuffers(1, &depthRb);
+            fbo = colorRb = depthRb = 0;
+        }
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(dpy, (EGLContext)context);
+        context = nullptr;
+    }
+    if(dpy){ eglTerminate(dpy); display = nullptr; }
+}
+
+#else
+
+bool HeadlessContext::init(int, int){
+    std::fprintf(stderr, "Built without EGL: headless mode is not available\n");
+    return false;
+}
+
+void HeadlessContext::destroy(){}
+
+#endif
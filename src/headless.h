@@ -0,0 +1,25 @@
+// Offscreen GL 3.3 core context without a window or display server.
+//
+// init() creates a surfaceless EGL context (Mesa's surfaceless platform,
+// falling back to the default display), loads GL through GLAD and binds a
+// framebuffer object of the requested size with RGBA8 color and 24-bit
+// depth, so the normal render code runs unchanged on e.g. llvmpipe.
+// Builds without EGL (SKEL_HEADLESS=0) keep the type; init() then reports
+// that headless mode is unavailable and returns false.
+#pragma once
+
+#include <glad/glad.h>
+
+#ifndef SKEL_HEADLESS
+#define SKEL_HEADLESS 0
+#endif
+
+struct HeadlessContext {
+    int width = 0, height = 0;
+    GLuint fbo = 0, colorRb = 0, depthRb = 0;
+    void* display = nullptr;        // EGLDisplay
+    void* context = nullptr;        // EGLContext
+
+    bool init(int w, int h);
+    void destroy();
+};
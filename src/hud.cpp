@@ -0,0 +1,73 @@
+#include "hud.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+void Hud::init(){
+    text.init();
+    frameTimes.assign((size_t)std::max(window, 1), 0.0f);
+    sorted.reserve(frameTimes.size());
+    buf.resize(4096);
+    glyphs.resize(buf.size());
+}
+
+void Hud::record(const HudFrame& f){
+    frameTimes[next] = (float)f.frameMs;
+    next = (next + 1) % frameTimes.size();
+    filled = std::min(filled + 1, frameTimes.size());
+    if(visible) last = f;
+}
+
+// Nearest-rank percentile of the already partially ordered window
+static float percentile(std::vector<float>& v, double p){
+    size_t k = std::min(v.size() - 1, (size_t)(p * (double)(v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + (std::ptrdiff_t)k, v.end());
+    return v[k];
+}
+
+void Hud::draw(int eyeCount, int viewportW, int viewportH){
+    if(!visible){ built = false; return; }
+    if(filled == 0) return;
+    auto t0 = std::chrono::steady_clock::now();
+    if(built && std::chrono::duration<double>(t0 - lastBuild).count() < refreshSeconds){
+        text.drawUploaded(eyeCount, viewportW, viewportH);
+        return;
+    }
+    built = true; lastBuild = t0;
+
+    sorted.assign(frameTimes.begin(), frameTimes.begin() + (std::ptrdiff_t)filled);
+    const float p50 = percentile(sorted, 0.50), p95 = percentile(sorted, 0.95), p99 = percentile(sorted, 0.99);
+    const float worst = *std::max_element(sorted.begin(), sorted.end());
+    auto fps = [](float ms){ return ms > 0.0f ? 1000.0f / ms : 0.0f; };
+
+    char* p = buf.data();
+    char* end = p + buf.size();
+    auto put = [&](const char* fmt, auto... args){
+        if(p < end){ int n = std::snprintf(p, (size_t)(end - p), fmt, args...); p += std::max(n, 0); }
+    };
+    put("frame %6.2f ms  %5.1f fps\n", last.frameMs, fps((float)last.frameMs));
+    put("p50 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f ms  (%zu frames)\n", p50, p95, p99, worst, filled);
+    put("fps p50 %5.1f  1%% low %5.1f\n", fps(p50), fps(p99));
+    if(last.cpuMs >= 0.0 && last.gpuMs >= 0.0)
+        put("cpu %6.2f ms  gpu %6.2f ms  %s-bound\n", last.cpuMs, last.gpuMs, last.gpuMs > last.cpuMs ? "gpu" : "cpu");
+    put("instances %d  bones %d  draws %d  upload %.1f KB\n",
+        last.instances, last.bones, last.drawCalls, last.uploadBytes / 1024.0);
+    put("\nstage         cpu ms   gpu ms\n");
+    for(int i=0;i<last.stageCount;++i){
+        const HudFrame::Stage& s = last.stages[i];
+        if(s.gpuMs >= 0.0) put("%-12s %7.3f  %7.3f\n", s.name, s.cpuMs, s.gpuMs);
+        else put("%-12s %7.3f        -\n", s.name, s.cpuMs);
+    }
+    put("%-12s %7.3f\n", "hud", selfMs);
+
+    const int n = layoutText(buf.data(), glm::vec4(8.0f, 8.0f, 0.0f, 0.0f), glm::vec2(0.0f),
+                             packRGBA(glm::vec3(0.85f, 0.95f, 0.85f)), text.scale, glyphs.data(), (int)glyphs.size());
+    text.draw(glyphs.data(), (size_t)n, eyeCount, viewportW, viewportH);
+
+    selfMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Hud::destroy(){
+    text.destroy();
+}
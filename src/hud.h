@@ -0,0 +1,55 @@
+// On-screen performance overlay.
+//
+// The app fills a HudFrame each frame and hands it to Hud::record(); when the
+// overlay is visible, draw() formats the text into a reused buffer and renders
+// it with a single instanced glyph draw (text_renderer.h). The text is only
+// rebuilt and re-uploaded every refreshSeconds, which also keeps the numbers
+// readable; in between the previous upload is redrawn. Hidden, record() only
+// stores the frame time and draw() returns immediately.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "text_renderer.h"
+
+// One frame's numbers; all times in milliseconds, gpuMs < 0 = not measured
+struct HudFrame {
+    struct Stage { const char* name; double cpuMs; double gpuMs; };
+    static constexpr int kMaxStages = 12;
+
+    double frameMs = 0;                 // wall time since the previous frame
+    double cpuMs = -1, gpuMs = -1;      // this frame's CPU work, latest resolved GPU frame
+    int instances = 0, bones = 0;
+    int drawCalls = 0;
+    size_t uploadBytes = 0;
+    Stage stages[kMaxStages];
+    int stageCount = 0;
+
+    void stage(const char* name, double cpuMs, double gpuMs = -1.0){
+        if(stageCount < kMaxStages) stages[stageCount++] = {name, cpuMs, gpuMs};
+    }
+};
+
+struct Hud {
+    bool visible = false;
+    int window = 240;                   // frames in the percentile window
+    double refreshSeconds = 0.25;
+
+    void init();
+    void record(const HudFrame& f);
+    void draw(int eyeCount, int viewportW, int viewportH);
+    void destroy();
+
+private:
+    TextRenderer text;
+    HudFrame last;
+    std::vector<float> frameTimes, sorted;  // ring of the last `window` frame times
+    size_t next = 0, filled = 0;
+    std::vector<char> buf;
+    std::vector<GlyphInstance> glyphs;
+    double selfMs = 0;                  // cost of the last text rebuild + draw
+    std::chrono::steady_clock::time_point lastBuild;
+    bool built = false;
+};
@@ -0,0 +1,156 @@
+#include "hw_counters.h"
+
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace hwc {
+
+namespace {
+
+const char* const kEventNames[kEventCount] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+
+struct Stage {
+    const char* name;
+    const char* unit;
+    double units = 0;
+    long calls = 0;
+    double counts[kEventCount] = {};
+    double seconds = 0;
+};
+
+struct State {
+    bool enabled = false;
+    int fds[kEventCount] = {-1, -1, -1, -1};
+    int slot[kEventCount] = {-1, -1, -1, -1};   // position in the group read, -1 = not counted
+    int members = 0;
+    std::vector<Stage> stages;                  // first-seen order
+};
+
+State g;
+
+// Current group values into out[kEventCount], time enabled, time running
+bool readGroup(unsigned long long* out){
+#ifdef __linux__
+    unsigned long long buf[3 + kEventCount];    // nr, time enabled, time running, values
+    if(read(g.fds[0], buf, sizeof(buf)) < (ssize_t)(3 + g.members) * (ssize_t)sizeof(unsigned long long)) return false;
+    for(int e=0;e<kEventCount;++e) out[e] = g.slot[e] >= 0 ? buf[3 + g.slot[e]] : 0;
+    out[kEventCount] = buf[1];
+    out[kEventCount + 1] = buf[2];
+    return true;
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+} // namespace
+
+bool init(){
+#ifdef __linux__
+    static const unsigned long long kConfigs[kEventCount] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for(int e=0;e<kEventCount;++e){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = kConfigs[e];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = e == 0;                 // the leader starts the whole group
+        attr.exclude_kernel = 1;                // allowed at perf_event_paranoid 2
+        attr.exclude_hv = 1;
+        const int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, e == 0 ? -1 : g.fds[0], 0);
+        if(fd < 0){
+            if(e == 0){
+                const int err = errno;
+                int paranoid = -9;
+                if(std::FILE* f = std::fopen("/proc/sys/kernel/perf_event_paranoid", "r")){
+                    if(std::fscanf(f, "%d", &paranoid) != 1) paranoid = -9;
+                    std::fclose(f);
+                }
+                std::fprintf(stderr, "hw counters unavailable: perf_event_open(cycles) failed: %s", std::strerror(err));
+                if(paranoid != -9) std::fprintf(stderr, " (perf_event_paranoid %d)", paranoid);
+                std::fprintf(stderr, "%s\n", err == ENOENT || err == EOPNOTSUPP ? "; no hardware PMU (virtual machine?)" : "");
+                return false;
+            }
+            std::fprintf(stderr, "hw counters: %s not available (%s)\n", kEventNames[e], std::strerror(errno));
+            continue;
+        }
+        g.fds[e] = fd;
+        g.slot[e] = g.members++;
+    }
+    ioctl(g.fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(g.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    unsigned long long probe[kEventCount + 2];
+    if(!readGroup(probe)){
+        std::fprintf(stderr, "hw counters unavailable: reading the counter group failed\n");
+        shutdown();
+        return false;
+    }
+    g.enabled = true;
+    return true;
+#else
+    std::fprintf(stderr, "hw counters unavailable: perf_event_open is Linux only\n");
+    return false;
+#endif
+}
+
+bool enabled(){ return g.enabled; }
+
+void shutdown(){
+#ifdef __linux__
+    for(int& fd : g.fds) if(fd >= 0){ close(fd); fd = -1; }
+#endif
+    g.enabled = false;
+}
+
+Scope::Scope(const char* stageName, double stageUnits, const char* unitName)
+    : stage(stageName), unit(unitName), units(stageUnits), active(g.enabled && readGroup(begin)) {}
+
+Scope::~Scope(){
+    if(!active) return;
+    unsigned long long end[kEventCount + 2];
+    if(!readGroup(end)) return;
+    const double enabledNs = (double)(end[kEventCount] - begin[kEventCount]);
+    const double runningNs = (double)(end[kEventCount + 1] - begin[kEventCount + 1]);
+    if(runningNs <= 0) return;                  // descheduled from the PMU the whole time
+    const double scale = enabledNs / runningNs;
+
+    Stage* s = nullptr;
+    for(Stage& x : g.stages) if(std::strcmp(x.name, stage) == 0){ s = &x; break; }
+    if(!s){ g.stages.push_back(Stage{stage, unit}); s = &g.stages.back(); }
+    for(int e=0;e<kEventCount;++e) s->counts[e] += (double)(end[e] - begin[e]) * scale;
+    s->units += units;
+    s->seconds += enabledNs * 1e-9;
+    ++s->calls;
+}
+
+void report(std::FILE* out){
+    if(!g.enabled || g.stages.empty()) return;
+    std::fprintf(out, "hw counters (user space, per call and per unit):\n");
+    std::fprintf(out, "  %-16s %8s %12s %12s %6s %14s %14s %10s\n",
+                 "stage", "calls", "cycles", "instr", "IPC", "cache-miss/u", "branch-miss/u", "~DRAM MB/s");
+    for(const Stage& s : g.stages){
+        const double calls = (double)s.calls;
+        std::fprintf(out, "  %-16s %8ld %12.0f %12.0f ", s.name, s.calls, s.counts[0] / calls, s.counts[1] / calls);
+        if(g.slot[0] >= 0 && g.slot[1] >= 0 && s.counts[0] > 0) std::fprintf(out, "%6.2f ", s.counts[1] / s.counts[0]);
+        else std::fprintf(out, "%6s ", "n/a");
+        // Per unit only means something when the stage counted its units
+        if(g.slot[2] >= 0 && s.units > 0) std::fprintf(out, "%14.4f ", s.counts[2] / s.units); else std::fprintf(out, "%14s ", "n/a");
+        if(g.slot[3] >= 0 && s.units > 0) std::fprintf(out, "%14.4f ", s.counts[3] / s.units); else std::fprintf(out, "%14s ", "n/a");
+        if(g.slot[2] >= 0 && s.seconds > 0) std::fprintf(out, "%10.1f", s.counts[2] * 64.0 / s.seconds * 1e-6);
+        else std::fprintf(out, "%10s", "n/a");
+        std::fprintf(out, "  (unit: %s, %.0f per call)\n", s.unit, s.units / calls);
+    }
+}
+
+} // namespace hwc
@@ -0,0 +1,46 @@
+// Hardware performance counters per frame stage (Linux perf_event_open).
+//
+// hwc::init() opens one counter group on the calling thread: cycles,
+// instructions, cache misses (last-level on most CPUs) and branch misses,
+// user space only. A hwc::Scope then attributes the counts between its
+// construction and destruction to a named stage, together with how many
+// units (bones, vertices) the stage processed, so the report can give IPC
+// and misses per unit. Counts are scaled by time enabled / time running when
+// the kernel multiplexes the PMU. DRAM traffic is estimated as cache misses
+// times the 64-byte line; real memory-controller counters need system-wide
+// access.
+//
+// When counters are unavailable (not Linux, perf_event_paranoid, no PMU in a
+// VM) init() says why and returns false, and every Scope is a single branch.
+// Events the CPU lacks, and per-unit figures of stages that counted no units,
+// are reported as n/a. Stage names must outlive the report; only the pointer
+// is stored.
+#pragma once
+
+#include <cstdio>
+
+namespace hwc {
+
+constexpr int kEventCount = 4;          // cycles, instructions, cache misses, branch misses
+
+bool init();
+bool enabled();
+void report(std::FILE* out);
+void shutdown();
+
+// Counts of the enclosing scope, added to `stage`
+struct Scope {
+    Scope(const char* stage, double units, const char* unit);
+    ~Scope();
+    void setUnits(double n){ units = n; }   // when the count is only known at the end
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    const char* stage;
+    const char* unit;
+    double units;
+    bool active;
+    unsigned long long begin[kEventCount + 2];    // counts, time enabled, time running
+};
+
+} // namespace hwc
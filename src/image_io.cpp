@@ -0,0 +1,23 @@
+#include "image_io.h"
+
+#include <cstdio>
+#include <vector>
+
+bool writePPM(const char* path, int w, int h, const uint8_t* rgba, bool bottomUp){
+    std::FILE* f = std::fopen(path, "wb");
+    if(!f){ std::fprintf(stderr, "Cannot open '%s' for writing\n", path); return false; }
+    std::fprintf(f, "P6\n%d %d\n255\n", w, h);
+    std::vector<uint8_t> row((size_t)w * 3);
+    for(int y=0;y<h;++y){
+        const uint8_t* src = rgba + (size_t)(bottomUp ? h-1-y : y) * (size_t)w * 4;
+        for(int x=0;x<w;++x){
+            row[(size_t)x*3+0] = src[x*4+0];
+            row[(size_t)x*3+1] = src[x*4+1];
+            row[(size_t)x*3+2] = src[x*4+2];
+        }
+        std::fwrite(row.data(), 1, row.size(), f);
+    }
+    bool ok = std::ferror(f) == 0;
+    std::fclose(f);
+    return ok;
+}
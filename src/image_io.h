@@ -0,0 +1,8 @@
+// Minimal image output (binary PPM), no external dependencies.
+#pragma once
+
+#include <cstdint>
+
+// Write an 8-bit RGBA image as P6 (alpha dropped). bottomUp flips rows, as
+// needed for GL read-backs whose first row is the bottom of the image.
+bool writePPM(const char* path, int w, int h, const uint8_t* rgba, bool bottomUp);
@@ -4,8 +4,64 @@
 // skeleton (hierarchical bones) and animates a simple walk cycle.
 // Now with a solid triangulated SPHERE for the head.
 //
+// Options:
+//   --crowd N            draw N GPU-skinned walkers instead of the single one
+//   --palette mat4|quat|half
+//                        bone palette encoding for the crowd (default quat)
+//   --stereo             single-pass side-by-side stereo (both eyes per draw)
+//   --ipd METERS         eye separation for --stereo (default 0.064)
+//   --screenshot FILE    where F12 saves the current frame (PPM)
+//   --history N          onion-skin the last N poses of the (first) walker; H toggles
+//   --history-step K     record every K-th frame into the history (default 2)
+//   --hud                start with the stats overlay shown (F1 toggles)
+//   --headless           render offscreen through a surfaceless EGL context
+//                        (no window or display); --screenshot saves the last frame
+//   --size WxH           headless framebuffer size (default 1280x720)
+//   --frames N           headless: frames to render (default 600)
+//   --duration SECONDS   headless: simulated time to render, at a fixed 60 Hz step
+//   --capture PATTERN    save every frame as PPM (printf pattern, e.g. out/f%05d.ppm)
+//                        through asynchronous PBO readback
+//   --capture-ring N     readback buffers in flight (default 3)
+//   --trace FILE         where P saves the CPU zone trace (Chrome trace JSON,
+//                        default trace.json); given explicitly, also saved at exit
+//   --trace-frames N     frames kept in a trace dump (default 120)
+//   --stats SECONDS      print frame/CPU/swap/GPU time percentiles this often
+//                        (default 5, 0 = only the whole-run summary at exit)
+//   --frame-csv FILE     stream per-frame times to FILE as CSV
+//   --pace vsync|uncapped|FPS
+//                        frame pacing: swap interval 1, 0, or a precise FPS cap (default vsync)
+//   --low-latency        simulate first, then sleep until just before the present
+//                        deadline and only then poll input and build the view
+//                        (input-to-present latency is the "input" row of --stats)
+//   --on-demand          only render when something changed (animation running,
+//                        input, window events); idle in glfwWaitEvents otherwise
+//   --background-fps N   frame cap while the window is unfocused, with --on-demand
+//                        (default 10, 0 = no cap); iconified windows never render
+//   --scene SPEC         benchmark scene: walker count (1, 100, 10k, 100k or
+//                        single/small/large/huge) and layout, e.g. 10k-random;
+//                        fixed 60 Hz time, scripted camera, JSON report at exit
+//   --seed N             scene seed for random layouts and phases (default 1)
+//   --report FILE        where the scene report goes (default stdout)
+//   --hw-counters        count cycles, instructions, cache and branch misses per
+//                        CPU stage with perf_event_open (Linux) and report IPC and
+//                        misses per bone/vertex at exit; skipped if not permitted
+//   --gl-record FILE     record every GL call and payload from context creation to
+//                        FILE for skeleton_replay; frames before --gl-record-from
+//                        form the setup prefix, the next --gl-record-frames the body
+//   --gl-record-from K   first frame of the replayed body (default 1)
+//   --gl-record-frames N frames in the replayed body (default 1)
+//   --fast-start         build CPU assets on a loader thread while the context is
+//                        created, and compile the overlay shaders after the first frame
+//   --asset FILE         take the single walker's skeleton from a skeleton asset
+//                        (skeleton_asset.h) and play its clip instead of the walk
+//   --clip NAME          clip to play from --asset (default the first; its skeleton is used);
+//                        an asset without clips shows its first skeleton in the bind pose
+//
+// Keys: F1 stats overlay, J joint axes/labels (debug draw builds only),
+// F12 screenshot, H pose history, P CPU trace (profiler builds only), Space pause.
+//
 // Build (Linux/Mac):
-//   c++ -std=c++17 main.cpp -lglfw -ldl -framework Cocoa -framework IOKit -framework CoreVideo \
+//   c++ -std=c++17 *.cpp -lglfw -ldl -framework Cocoa -framework IOKit -framework CoreVideo \
 //      -I/path/to/glad/include -I/path/to/glm -L/path/to/glad/lib -lglad -o skel
 // (adjust frameworks/libs per platform; on Linux remove the frameworks, keep -ldl -lGL)
 //
@@ -15,11 +71,16 @@
 //   - GLM
 // ------------------------------------------------------------
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
 #include <vector>
 #include <string>
 #include <cmath>
 #include <optional>
+#include <future>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -28,21 +89,46 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_util.h"
+#include "skeleton.h"
+#include "skeleton_asset.h"
+#include "bone_palette.h"
+#include "crowd.h"
+#include "camera_block.h"
+#include "pose_history.h"
+#include "debug_draw.h"
+#include "hud.h"
+#include "headless.h"
+#include "frame_capture.h"
+#include "gpu_timer.h"
+#include "profiler.h"
+#include "frame_stats.h"
+#include "upload_stats.h"
+#include "startup_profile.h"
+#include "head_mesh.h"
+#include "frame_pacer.h"
+#include "redraw_scheduler.h"
+#include "stress_scene.h"
+#include "hw_counters.h"
+#include "gl_record.h"
+#include "pose_check.h"
+#include "image_io.h"
+
 // ------------------------------------------------------------
 // Shader sources (position + color; no lighting)
 // ------------------------------------------------------------
-static const char* kVS = R"GLSL(
+// The camera block (kCameraBlockGLSL) is spliced in between head and main
+static const char* kVSHead = R"GLSL(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
+)GLSL";
 
-uniform mat4 uView;
-uniform mat4 uProj;
-
+static const char* kVSMain = R"GLSL(
 out vec3 vColor;
 void main(){
     vColor = aColor;
-    gl_Position = uProj * uView * vec4(aPos, 1.0);
+    gl_Position = eyeClip(aPos, eyeIndex());
 }
 )GLSL";
 
@@ -55,314 +141,287 @@ void main(){
 }
 )GLSL";
 
-static GLuint compileShader(GLenum type, const char* src){
-    GLuint s = glCreateShader(type);
-    glShaderSource(s, 1, &src, nullptr);
-    glCompileShader(s);
-    GLint ok = 0; glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-    if(!ok){
-        char log[1024]; glGetShaderInfoLog(s, 1024, nullptr, log);
-        std::fprintf(stderr, "Shader compile error: %s\n", log);
-    }
-    return s;
-}
-
-static GLuint makeProgram(){
-    GLuint vs = compileShader(GL_VERTEX_SHADER, kVS);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, kFS);
-    GLuint p = glCreateProgram();
-    glAttachShader(p, vs);
-    glAttachShader(p, fs);
-    glLinkProgram(p);
-    GLint ok = 0; glGetProgramiv(p, GL_LINK_STATUS, &ok);
-    if(!ok){
-        char log[1024]; glGetProgramInfoLog(p, 1024, nullptr, log);
-        std::fprintf(stderr, "Link error: %s\n", log);
-    }
-    glDeleteShader(vs); glDeleteShader(fs);
-    return p;
-}
-
 // ------------------------------------------------------------
-// Bones / Skeleton
+// Camera & input
 // ------------------------------------------------------------
-struct Bone {
-    int parent;                 // -1 for root
-    glm::vec3 bindOffset;       // from parent to this joint in bind pose
-    glm::vec3 eulerDeg;         // current local rotation (XYZ degrees)
-    float length;               // bone visual length (for child end)
-    glm::mat4 global;           // world-space transform of this joint
-};
-
-struct Skeleton {
-    std::vector<Bone> bones;
-
-    int addBone(int parent, glm::vec3 bindOffset, float length){
-        Bone b{}; b.parent = parent; b.bindOffset = bindOffset; b.eulerDeg = glm::vec3(0); b.length = length; b.global = glm::mat4(1);
-        bones.push_back(b);
-        return (int)bones.size()-1;
-    }
-
-    static glm::mat4 rotXYZ(const glm::vec3& deg){
-        glm::vec3 r = glm::radians(deg);
-        glm::mat4 Rx = glm::rotate(glm::mat4(1), r.x, {1,0,0});
-        glm::mat4 Ry = glm::rotate(glm::mat4(1), r.y, {0,1,0});
-        glm::mat4 Rz = glm::rotate(glm::mat4(1), r.z, {0,0,1});
-        return Rz * Ry * Rx; // XYZ intrinsic
-    }
+struct Camera {
+    float yaw = 30.0f, pitch = -15.0f, dist = 3.0f;
+    glm::vec3 target = {0, 1.0f, 0};
 
-    void updateGlobals(){
-        for(size_t i=0;i<bones.size();++i){
-            const int p = bones[i].parent;
-            glm::mat4 T = glm::translate(glm::mat4(1), bones[i].bindOffset);
-            glm::mat4 R = rotXYZ(bones[i].eulerDeg);
-            glm::mat4 local = T * R;
-            bones[i].global = (p >= 0) ? bones[p].global * local : local;
-        }
+    glm::mat4 view() const {
+        float cy = std::cos(glm::radians(yaw));
+        float sy = std::sin(glm::radians(yaw));
+        float cp = std::cos(glm::radians(pitch));
+        float sp = std::sin(glm::radians(pitch));
+        glm::vec3 dir = {cy*cp, sp, sy*cp};
+        glm::vec3 eye = target - dir * dist;
+        return glm::lookAt(eye, target, {0,1,0});
     }
 };
 
-// Build a very small human-like hierarchy
-Skeleton makeHuman() {
-    Skeleton s;
-    // Reference scale ~1.8 m tall stick figure, Y is up.
-    const float pelvisH = 1.0f;     // baseline hip height
-    const float spineLen = 0.4f;    // spine
-    const float neckLen  = 0.1f;
-    const float headLen  = 0.22f;
-
-    const float upperLeg = 0.45f, lowerLeg = 0.45f, footLen = 0.18f;
-    const float upperArm = 0.30f, lowerArm = 0.30f, handLen = 0.12f;
-    const float hipWidth = 0.18f, shoulderWidth = 0.28f;
-
-    // ------------------------------------------------------------
-    // Root pelvis center — raised high so "middle line" starts above hips
-    // ------------------------------------------------------------
-    int root = s.addBone(-1, {0, pelvisH + 0.30f, 0}, 0.0f);   // pelvis center (much higher)
-    int spine = s.addBone(root, {0, 0.0f, 0}, spineLen);
-    int neck  = s.addBone(spine, {0, spineLen, 0}, neckLen);
-    int head  = s.addBone(neck,  {0, neckLen, 0}, headLen);
-
-    // ------------------------------------------------------------
-    // Legs — attach far below pelvis so torso line clearly above them
-    // ------------------------------------------------------------
-    int hipL = s.addBone(root, {+hipWidth * 0.5f, -0.30f, 0}, upperLeg);
-    int kneeL = s.addBone(hipL, {0, -upperLeg, 0}, lowerLeg);
-    int ankleL = s.addBone(kneeL, {0, -lowerLeg, 0}, footLen);
-
-    int hipR = s.addBone(root, {-hipWidth * 0.5f, -0.30f, 0}, upperLeg);
-    int kneeR = s.addBone(hipR, {0, -upperLeg, 0}, lowerLeg);
-    int ankleR = s.addBone(kneeR, {0, -lowerLeg, 0}, footLen);
-
-    // ------------------------------------------------------------
-    // Arms — attach at shoulder level
-    // ------------------------------------------------------------
-    int shoulderL = s.addBone(spine, {+shoulderWidth * 0.5f, spineLen, 0}, upperArm);
-    int elbowL = s.addBone(shoulderL, {0, -upperArm, 0}, lowerArm);
-    int wristL = s.addBone(elbowL, {0, -lowerArm, 0}, handLen);
-
-    int shoulderR = s.addBone(spine, {-shoulderWidth * 0.5f, spineLen, 0}, upperArm);
-    int elbowR = s.addBone(shoulderR, {0, -upperArm, 0}, lowerArm);
-    int wristR = s.addBone(elbowR, {0, -lowerArm, 0}, handLen);
-
-    (void)ankleL; (void)wristL; (void)wristR;
-    return s;
+static bool g_mouseDown=false; static double g_lastX=0, g_lastY=0; static Camera g_cam;
+static RedrawScheduler g_redraw;
+static void cursorPos(GLFWwindow*, double x, double y){ if(!g_mouseDown){ g_lastX=x; g_lastY=y; return; } double dx=x-g_lastX, dy=y-g_lastY; g_lastX=x; g_lastY=y; g_cam.yaw += (float)dx*0.3f; g_cam.pitch += (float)dy*0.3f; g_cam.pitch = glm::clamp(g_cam.pitch, -85.0f, 85.0f); g_redraw.markDirty();} 
+static void mouseBtn(GLFWwindow*, int button, int action, int){ if(button==GLFW_MOUSE_BUTTON_LEFT) g_mouseDown = (action==GLFW_PRESS); }
+static void scrollCB(GLFWwindow*, double, double yoff){ g_cam.dist = glm::clamp(g_cam.dist - (float)yoff*0.2f, 1.2f, 8.0f); g_redraw.markDirty(); }
+static void focusCB(GLFWwindow*, int focused){ g_redraw.focused = focused != 0; g_redraw.markDirty(); }
+static void iconifyCB(GLFWwindow*, int iconified){ g_redraw.iconified = iconified != 0; g_redraw.markDirty(); }
+static void refreshCB(GLFWwindow*){ g_redraw.markDirty(); }
+static bool g_screenshotRequested=false, g_historyToggled=false, g_jointDebug=false, g_hudToggled=false, g_traceRequested=false;
+static bool g_pauseToggled=false;
+static void keyCB(GLFWwindow*, int key, int, int action, int){
+    if(action!=GLFW_PRESS) return;
+    g_redraw.markDirty();
+    if(key==GLFW_KEY_SPACE) g_pauseToggled = true;
+    if(key==GLFW_KEY_F12) g_screenshotRequested = true;
+    if(key==GLFW_KEY_H) g_historyToggled = true;
+    if(key==GLFW_KEY_J) g_jointDebug = !g_jointDebug;
+    if(key==GLFW_KEY_F1) g_hudToggled = true;
+    if(key==GLFW_KEY_P) g_traceRequested = true;
 }
 
-
-
 // ------------------------------------------------------------
-// Geometry helpers
+// Command line
 // ------------------------------------------------------------
-struct LineVertex{ glm::vec3 pos; glm::vec3 col; };
-struct TriVertex { glm::vec3 pos; glm::vec3 col; };
+struct AppOptions {
+    int crowd = 0;                                  // 0 = single CPU-built walker
+    PaletteFormat palette = PaletteFormat::QuatTrans;
+    bool stereo = false;
+    float ipd = 0.064f;
+    const char* screenshot = "screenshot.ppm";
+    int history = 0;                                // frames of pose history, 0 = off
+    int historyStep = 2;
+    bool hud = false;
+    bool headless = false;
+    int width = 1280, height = 720;                 // headless framebuffer
+    int frames = 0;                                 // headless run length, 0 = from duration or 600
+    double duration = 0;                            // simulated seconds
+    bool screenshotSet = false;
+    const char* capture = nullptr;                  // per-frame PPM pattern
+    int captureRing = 3;
+    const char* trace = "trace.json";
+    bool traceSet = false;
+    int traceFrames = 120;
+    double statsInterval = 5.0;                     // seconds between percentile summaries
+    const char* frameCsv = nullptr;
+    bool fastStart = false;
+    PaceMode pace = PaceMode::Vsync;
+    double targetFps = 0;
+    bool lowLatency = false;
+    bool onDemand = false;
+    double backgroundFps = 10.0;
+    const char* scene = nullptr;
+    unsigned seed = 1;
+    const char* report = nullptr;
+    bool hwCounters = false;
+    const char* glRecord = nullptr;
+    long glRecordFrom = 1;
+    long glRecordFrames = 1;
+    const char* asset = nullptr;
+    const char* clip = nullptr;
+};
 
-static glm::vec3 jointPos(const Bone& b){ return glm::vec3(b.global[3]); }
-static glm::vec3 endpointPos(const Bone& b){
-    glm::vec4 p = b.global * glm::vec4(0, -b.length, 0, 1);
-    return glm::vec3(p);
+static bool parseArgs(int argc, char** argv, AppOptions& o){
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        const char* next = (i+1 < argc) ? argv[i+1] : nullptr;
+        if(std::strcmp(a, "--crowd") == 0 && next){ o.crowd = std::atoi(next); ++i; }
+        else if(std::strcmp(a, "--palette") == 0 && next){
+            if(!parsePaletteFormat(next, o.palette)){ std::fprintf(stderr, "Unknown palette format '%s'\n", next); return false; }
+            ++i;
+        }
+        else if(std::strcmp(a, "--stereo") == 0){ o.stereo = true; }
+        else if(std::strcmp(a, "--ipd") == 0 && next){ o.ipd = (float)std::atof(next); ++i; }
+        else if(std::strcmp(a, "--screenshot") == 0 && next){ o.screenshot = next; o.screenshotSet = true; ++i; }
+        else if(std::strcmp(a, "--history") == 0 && next){ o.history = std::atoi(next); ++i; }
+        else if(std::strcmp(a, "--history-step") == 0 && next){ o.historyStep = std::atoi(next); ++i; }
+        else if(std::strcmp(a, "--hud") == 0){ o.hud = true; }
+        else if(std::strcmp(a, "--headless") == 0){ o.headless = true; }
+        else if(std::strcmp(a, "--size") == 0 && next){
+            if(std::sscanf(next, "%dx%d", &o.width, &o.height) != 2){ std::fprintf(stderr, "Bad size '%s'\n", next); return false; }
+            ++i;
+        }
+        else if(std::strcmp(a, "--frames") == 0 && next){ o.frames = std::atoi(next); ++i; }
+        else if(std::strcmp(a, "--duration") == 0 && next){ o.duration = std::atof(next); ++i; }
+        else if(std::strcmp(a, "--capture") == 0 && next){ o.capture = next; ++i; }
+        else if(std::strcmp(a, "--capture-ring") == 0 && next){ o.captureRing = std::atoi(next); ++i; }
+        else if(std::strcmp(a, "--trace") == 0 && next){ o.trace = next; o.traceSet = true; ++i; }
+        else if(std::strcmp(a, "--trace-frames") == 0 && next){ o.traceFrames = std::atoi(next); ++i; }
+        else if(std::strcmp(a, "--stats") == 0 && next){ o.statsInterval = std::atof(next); ++i; }
+        else if(std::strcmp(a, "--frame-csv") == 0 && next){ o.frameCsv = next; ++i; }
+        else if(std::strcmp(a, "--fast-start") == 0){ o.fastStart = true; }
+        else if(std::strcmp(a, "--pace") == 0 && next){
+            if(std::strcmp(next, "vsync") == 0) o.pace = PaceMode::Vsync;
+            else if(std::strcmp(next, "uncapped") == 0) o.pace = PaceMode::Uncapped;
+            else if((o.targetFps = std::atof(next)) > 0) o.pace = PaceMode::Target;
+            else { std::fprintf(stderr, "Unknown pacing '%s'\n", next); return false; }
+            ++i;
+        }
+        else if(std::strcmp(a, "--low-latency") == 0){ o.lowLatency = true; }
+        else if(std::strcmp(a, "--on-demand") == 0){ o.onDemand = true; }
+        else if(std::strcmp(a, "--scene") == 0 && next){ o.scene = next; ++i; }
+        else if(std::strcmp(a, "--seed") == 0 && next){ o.seed = (unsigned)std::strtoul(next, nullptr, 10); ++i; }
+        else if(std::strcmp(a, "--report") == 0 && next){ o.report = next; ++i; }
+        else if(std::strcmp(a, "--background-fps") == 0 && next){ o.backgroundFps = std::atof(next); ++i; }
+        else if(std::strcmp(a, "--hw-counters") == 0){ o.hwCounters = true; }
+        else if(std::strcmp(a, "--gl-record") == 0 && next){ o.glRecord = next; ++i; }
+        else if(std::strcmp(a, "--gl-record-from") == 0 && next){ o.glRecordFrom = std::max(0L, std::atol(next)); ++i; }
+        else if(std::strcmp(a, "--gl-record-frames") == 0 && next){ o.glRecordFrames = std::max(1L, std::atol(next)); ++i; }
+        else if(std::strcmp(a, "--asset") == 0 && next){ o.asset = next; ++i; }
+        else if(std::strcmp(a, "--clip") == 0 && next){ o.clip = next; ++i; }
+        else { std::fprintf(stderr, "Unknown argument '%s'\n", a); return false; }
+    }
+    return true;
 }
 
-static void appendLine(std::vector<LineVertex>& v, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c){
-    v.push_back({a,c}); v.push_back({b,c});
+static void printCrowdReport(const Crowd& c, double frames, double seconds, const CrowdStats& sum){
+    const double mb = sum.paletteBytes / frames / (1024.0*1024.0);
+    std::printf("crowd: %d x %d bones, palette %s (%zu B/bone) %.2f MB/frame, %.1f MB/s, face weights %.1f KB/frame | "
+                "anim %.2f ms, encode %.2f ms, upload %.2f ms, gpu %.2f ms\n",
+                c.instances, c.boneCount, paletteFormatName(c.stats.format), paletteBytesPerBone(c.stats.format),
+                mb, sum.paletteBytes / seconds / (1024.0*1024.0), sum.morphBytes / frames / 1024.0,
+                sum.animMs / frames, sum.encodeMs / frames, sum.uploadMs / frames, c.stats.gpuMs);
 }
 
-// Build all skeleton lines (skip zero-length bones like pelvis)
-static std::vector<LineVertex> buildSkeletonLines(const Skeleton& s){
-    std::vector<LineVertex> v; v.reserve(s.bones.size()*2 + 200);
-    const glm::vec3 boneColor(1.0f, 0.9f, 0.4f);
-
-    for (size_t i = 0; i < s.bones.size(); ++i) {
-        const auto& b = s.bones[i];
-        // skip invisible or placeholder bones
-        if (b.length <= 0.001f) continue; // pelvis root
-        if (i == 0) continue;             // explicitly skip root bone
-        if (i == 3) continue;             // skip head bone (sphere)
-        glm::vec3 a = jointPos(b);
-        glm::vec3 e = endpointPos(b);
-        appendLine(v, a, e, boneColor);
-    }    
-
-    // Ground grid (XZ)
-    const float G = 2.0f; int N = 20;
-    for(int i=-N;i<=N;++i){
-        float t = (i%5==0)? 0.2f:0.08f;
-        glm::vec3 c(t,t,t);
-        appendLine(v, { (float)i*0.1f, 0, -G }, {(float)i*0.1f, 0, +G}, c);
-        appendLine(v, { -G, 0, (float)i*0.1f }, { +G, 0, (float)i*0.1f }, c);
+#if SKEL_DEBUG_DRAW
+// Joint frames and indices of one walker; globals == nullptr uses the skeleton's own pose
+static void drawJointDebug(const Skeleton& s, const glm::mat4* globals, const glm::vec3& origin){
+    const glm::mat4 shift = glm::translate(glm::mat4(1.0f), origin);
+    for(size_t i=0;i<s.bones.size();++i){
+        glm::mat4 m = shift * (globals ? globals[i] : s.bones[i].global);
+        char label[24]; std::snprintf(label, sizeof(label), "%zu", i);
+        DEBUG_AXES(m, 0.08f, 0.0f, false);
+        DEBUG_TEXT(glm::vec3(m[3]), label, glm::vec3(1.0f, 0.9f, 0.4f));
     }
-    return v;
 }
+#endif
 
-// Build a UV-sphere (triangles) centered at the head center
-static std::vector<TriVertex> buildHeadSphereTris(const Skeleton& s, int stacks=16, int slices=24){
-    std::vector<TriVertex> tris;
-    if (s.bones.size() <= 3) return tris;
-    const glm::vec3 headColor(0.95f, 0.75f, 0.25f);
-
-    const Bone& head = s.bones[3];
-
-    // Neck joint = base of the head
-    glm::vec3 neckBase = jointPos(head);
-
-    // Sphere radius proportional to head bone length
-    float radius = head.length * 0.6f;
-
-    // "Up" direction of the head in world space (its +Y axis)
-    glm::vec3 up = glm::normalize(glm::vec3(head.global * glm::vec4(0,1,0,0)));
-
-    // Place the sphere so its bottom touches the neck base:
-    // center = neckBase + up * radius
-    glm::vec3 center = neckBase + up * radius;
-
-    // UV-sphere triangulation
-    std::vector<glm::vec3> ring((size_t)(slices+1));
-    std::vector<glm::vec3> prev;
-    for(int i=0;i<=stacks;i++){
-        float v = (float)i / (float)stacks;         // [0,1]
-        float phi = v * glm::pi<float>();           // [0,pi]
-        float sy = std::cos(phi);                   // y on unit sphere
-        float sr = std::sin(phi);                   // ring radius
-        for(int j=0;j<=slices;j++){
-            float u = (float)j / (float)slices;     // [0,1]
-            float theta = u * glm::two_pi<float>(); // [0,2pi]
-            float sx = sr * std::cos(theta);
-            float sz = sr * std::sin(theta);
-            // Build in the head's local axes: use head.global's basis
-            glm::vec3 X = glm::normalize(glm::vec3(head.global * glm::vec4(1,0,0,0)));
-            glm::vec3 Y = up; // already normalized
-            glm::vec3 Z = glm::normalize(glm::vec3(head.global * glm::vec4(0,0,1,0)));
-            ring[(size_t)j] = center + radius*(sx*X + sy*Y + sz*Z);
-        }
-        if(i==0){ prev = ring; continue; }
-        for(int j=0;j<slices;j++){
-            glm::vec3 p00 = prev[(size_t)j];
-            glm::vec3 p01 = prev[(size_t)(j+1)];
-            glm::vec3 p10 = ring[(size_t)j];
-            glm::vec3 p11 = ring[(size_t)(j+1)];
-
-            tris.push_back({p00, headColor});
-            tris.push_back({p10, headColor});
-            tris.push_back({p11, headColor});
-
-            tris.push_back({p00, headColor});
-            tris.push_back({p11, headColor});
-            tris.push_back({p01, headColor});
-        }
-        prev = ring;
-    }
-    return tris;
+static double nowSeconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-// ------------------------------------------------------------
-// Animation
-// ------------------------------------------------------------
-static void animateWalk(Skeleton& s, float t){
-    float walkSpeed = 1.6f; // steps per second
-    float phase = t * walkSpeed * glm::two_pi<float>();
-
-    auto setR = [&](int idx, float rx, float ry, float rz){ s.bones[idx].eulerDeg = {rx, ry, rz}; };
-
-    const int root=0, spine=1, neck=2, head=3;
-    int hipL=4, kneeL=5, ankleL=6; int hipR=7, kneeR=8, ankleR=9;
-    int shoulderL=10, elbowL=11, wristL=12; int shoulderR=13, elbowR=14, wristR=15;
-
-    setR(root, 0.0f, 0.0f, 3.0f * std::sin(phase*0.5f));
-
-    setR(spine, 5.0f*std::sin(phase*0.5f), 0.0f, 0.0f);
-    setR(neck, -3.0f*std::sin(phase*0.5f), 0.0f, 0.0f);
-    setR(head, 2.0f*std::sin(phase*0.5f), 0.0f, 0.0f);
-
-    float hipSwing = 30.0f * std::sin(phase);
-    float kneeFlex = 25.0f * std::max(0.0f, std::sin(phase));
-
-    setR(hipL,  hipSwing,  0, 0);
-    setR(kneeL, -kneeFlex, 0, 0);
-    setR(ankleL, 5.0f*std::sin(phase+0.4f), 0, 0);
-
-    setR(hipR, -hipSwing,  0, 0);
-    setR(kneeR, -25.0f * std::max(0.0f, std::sin(phase+glm::pi<float>())), 0, 0);
-    setR(ankleR, 5.0f*std::sin(phase+glm::pi<float>()+0.4f), 0, 0);
-
-    float armSwing = 35.0f * std::sin(phase + glm::pi<float>());
-    float elbowFlex = 10.0f * std::max(0.0f, std::sin(phase + glm::pi<float>()));
-
-    setR(shoulderL,  armSwing, 0, 0);
-    setR(elbowL,    -elbowFlex,0,0);
-    setR(wristL,     5.0f*std::sin(phase+1.0f),0,0);
-
-    setR(shoulderR, -armSwing, 0, 0);
-    setR(elbowR,    -10.0f * std::max(0.0f, std::sin(phase)), 0, 0);
-    setR(wristR,     5.0f*std::sin(phase+glm::pi<float>()+1.0f),0,0);
+// CPU-side scene data that needs no GL context
+struct StartupAssets {
+    Skeleton skel;
+    HeadMesh head;              // crowd only
+    AssetFile file;             // --asset, mapped for the whole run
+    int clip = -1;
+    bool ok = true;
+    double ms = 0;
+};
 
-    s.updateGlobals();
+static StartupAssets buildStartupAssets(bool crowdHead, const char* assetPath, const char* clipName){
+    const auto t0 = std::chrono::steady_clock::now();
+    StartupAssets a;
+    if(!assetPath) a.skel = makeHuman();
+    else if(!a.file.init(assetPath)) a.ok = false;
+    else {
+        a.clip = clipName ? a.file.findClip(clipName) : (a.file.clipCount() ? 0 : -1);
+        if(clipName && a.clip < 0){ std::fprintf(stderr, "%s: no clip '%s'\n", assetPath, clipName); a.ok = false; }
+        else if(a.clip < 0 && a.file.skeletonCount() == 0){ std::fprintf(stderr, "%s: no skeletons\n", assetPath); a.ok = false; }
+        else a.skel = a.file.skeleton(a.clip >= 0 ? a.file.clip((uint32_t)a.clip).skeleton : 0).toSkeleton();
+    }
+    if(crowdHead && a.skel.bones.size() > (size_t)kHeadBone) a.head = buildHeadMesh(a.skel.bones[(size_t)kHeadBone].length * 0.6f);
+    a.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return a;
 }
 
-// ------------------------------------------------------------
-// Camera & input
-// ------------------------------------------------------------
-struct Camera {
-    float yaw = 30.0f, pitch = -15.0f, dist = 3.0f;
-    glm::vec3 target = {0, 1.0f, 0};
-
-    glm::mat4 view() const {
-        float cy = std::cos(glm::radians(yaw));
-        float sy = std::sin(glm::radians(yaw));
-        float cp = std::cos(glm::radians(pitch));
-        float sp = std::sin(glm::radians(pitch));
-        glm::vec3 dir = {cy*cp, sp, sy*cp};
-        glm::vec3 eye = target - dir * dist;
-        return glm::lookAt(eye, target, {0,1,0});
+static void saveTrace(const char* path, int frames){
+#if SKEL_PROFILE
+    if(PROFILE_DUMP(path, frames)){
+        const prof::Stats ps = prof::stats();
+        std::printf("Saved %s (last %d frames; %llu zones on %d thread(s), %llu overwritten)\n", path, frames,
+                    (unsigned long long)ps.zones, ps.threads, (unsigned long long)ps.overwritten);
     }
-};
-
-static bool g_mouseDown=false; static double g_lastX=0, g_lastY=0; static Camera g_cam;
-static void cursorPos(GLFWwindow*, double x, double y){ if(!g_mouseDown){ g_lastX=x; g_lastY=y; return; } double dx=x-g_lastX, dy=y-g_lastY; g_lastX=x; g_lastY=y; g_cam.yaw += (float)dx*0.3f; g_cam.pitch += (float)dy*0.3f; g_cam.pitch = glm::clamp(g_cam.pitch, -85.0f, 85.0f);} 
-static void mouseBtn(GLFWwindow*, int button, int action, int){ if(button==GLFW_MOUSE_BUTTON_LEFT) g_mouseDown = (action==GLFW_PRESS); }
-static void scrollCB(GLFWwindow*, double, double yoff){ g_cam.dist = glm::clamp(g_cam.dist - (float)yoff*0.2f, 1.2f, 8.0f); }
+#else
+    (void)path; (void)frames;
+    std::fprintf(stderr, "Built without the profiler (SKELETON_PROFILER=OFF)\n");
+#endif
+}
 
 // ------------------------------------------------------------
 // Main
 // ------------------------------------------------------------
-int main(){
-    if(!glfwInit()){ std::fprintf(stderr, "Failed to init GLFW\n"); return 1; }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* win = glfwCreateWindow(1280, 720, "OpenGL3 Skeleton Walk (Head Sphere)", nullptr, nullptr);
-    if(!win){ std::fprintf(stderr, "Failed to create window\n"); glfwTerminate(); return 1; }
-    glfwMakeContextCurrent(win);
-    glfwSwapInterval(1);
+int main(int argc, char** argv){
+    AppOptions opts;
+    if(!parseArgs(argc, argv, opts)) return 1;
+    PROFILE_THREAD("main");
+    StartupProfile startup; startup.begin();
+
+    // A scene replaces --crowd and runs a fixed number of simulated frames
+    StressScene scene;
+    if(opts.scene){
+        if(!scene.parse(opts.scene)) return 1;
+        scene.seed = opts.seed;
+        opts.crowd = scene.walkers;
+    }
+    if(opts.asset && opts.crowd > 0){
+        std::fprintf(stderr, "--asset drives the single walker; it cannot be combined with --crowd or --scene\n"); return 1; }
+    const bool fixedRun = opts.headless || opts.scene;
+
+    // Fast start: the loader thread overlaps context creation
+    std::future<StartupAssets> assetsLoading;
+    if(opts.fastStart) assetsLoading = std::async(std::launch::async, buildStartupAssets, opts.crowd > 0, opts.asset, opts.clip);
+
+    FramePacer pacer;
+    pacer.mode = opts.pace; pacer.targetFps = opts.targetFps; pacer.lowLatency = opts.lowLatency;
+
+    GLFWwindow* win = nullptr;
+    HeadlessContext headless;
+    if(opts.headless){
+        if(!headless.init(opts.width, opts.height)) return 1;
+        startup.phase("EGL context + glad");
+    } else {
+        if(!glfwInit()){ std::fprintf(stderr, "Failed to init GLFW\n"); return 1; }
+        startup.phase("glfwInit");
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        win = glfwCreateWindow(1280, 720, "OpenGL3 Skeleton Walk (Head Sphere)", nullptr, nullptr);
+        if(!win){ std::fprintf(stderr, "Failed to create window\n"); glfwTerminate(); return 1; }
+        glfwMakeContextCurrent(win);
+        glfwSwapInterval(pacer.swapInterval());
+        if(const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor()))
+            if(mode->refreshRate > 0) pacer.refreshSeconds = g_redraw.refreshSeconds = 1.0 / mode->refreshRate;
+        startup.phase("window + context");
+
+        if(!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)){
+            std::fprintf(stderr, "Failed to init GLAD\n"); return 1; }
+        startup.phase("gladLoadGLLoader");
+
+        glfwSetCursorPosCallback(win, cursorPos); glfwSetMouseButtonCallback(win, mouseBtn); glfwSetScrollCallback(win, scrollCB);
+        glfwSetKeyCallback(win, keyCB);
+        glfwSetWindowFocusCallback(win, focusCB); glfwSetWindowIconifyCallback(win, iconifyCB);
+        glfwSetWindowRefreshCallback(win, refreshCB); glfwSetFramebufferSizeCallback(win, [](GLFWwindow*, int, int){ g_redraw.markDirty(); });
+        g_redraw.enabled = opts.onDemand; g_redraw.backgroundFps = opts.backgroundFps;
+    }
+    // Headless and scene runs use simulated time: a fixed 60 Hz step for a set number of frames
+    const double simStep = 1.0 / 60.0;
+    const long frameLimit = opts.frames > 0 ? opts.frames : opts.duration > 0 ? (long)std::ceil(opts.duration / simStep) : 600;
+
+    if(opts.glRecord){
+        int fbw = opts.width, fbh = opts.height;
+        if(win) glfwGetFramebufferSize(win, &fbw, &fbh);
+        if(!glrec::start(opts.glRecord, fbw, fbh, opts.glRecordFrom, opts.glRecordFrames)) return 1;
+    }
 
-    if(!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)){
-        std::fprintf(stderr, "Failed to init GLAD\n"); return 1; }
+    std::string vsSrc = std::string(kVSHead) + kCameraBlockGLSL + kVSMain;
+    GLuint prog = makeProgram(vsSrc.c_str(), kFS);
+    bindCameraBlock(prog);
+    startup.phase("makeProgram");
 
-    glfwSetCursorPosCallback(win, cursorPos); glfwSetMouseButtonCallback(win, mouseBtn); glfwSetScrollCallback(win, scrollCB);
+    // The overlays are not needed for the first frame unless the HUD starts visible
+    Hud hud; hud.visible = opts.hud;
+    bool overlaysReady = false;
+    auto initOverlays = [&]{
+        DEBUG_DRAW_INIT();
+        hud.init();
+        overlaysReady = true;
+    };
+    if(!opts.fastStart || opts.hud){ initOverlays(); startup.phase("overlay shaders"); }
 
-    GLuint prog = makeProgram();
-    GLint uView = glGetUniformLocation(prog, "uView");
-    GLint uProj = glGetUniformLocation(prog, "uProj");
+    CameraUniforms camUniforms; camUniforms.init();
 
     // --- VAO/VBO for lines (skeleton + grid)
     GLuint vaoLines=0, vboLines=0; glGenVertexArrays(1, &vaoLines); glGenBuffers(1, &vboLines);
@@ -381,59 +440,367 @@ int main(){
     glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TriVertex), (void*)0);
     glEnableVertexAttribArray(1); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TriVertex), (void*)(sizeof(glm::vec3)));
     glBindVertexArray(0);
-
-    Skeleton skel = makeHuman();
+    startup.phase("buffers");
+
+    StartupAssets assets;
+    if(opts.fastStart){
+        assets = assetsLoading.get();
+        startup.phase("wait for assets");
+        startup.overlapped("assets", assets.ms);
+    } else {
+        assets = buildStartupAssets(opts.crowd > 0, opts.asset, opts.clip);
+        startup.phase("assets");
+    }
+    if(!assets.ok) return 1;
+    ClipView clip{};
+    if(assets.clip >= 0){
+        clip = assets.file.clip((uint32_t)assets.clip);
+        std::printf("Asset: %s, skeleton %s (%u bones), clip %s (%u frames at %g fps)\n", opts.asset,
+                    assets.file.skeleton(clip.skeleton).name, clip.boneCount, clip.name, clip.frameCount, (double)clip.frameRate);
+    } else if(opts.asset){
+        std::printf("Asset: %s, skeleton %s (%zu bones), no clip: holding the bind pose\n", opts.asset,
+                    assets.file.skeleton(0).name, assets.skel.bones.size());
+    }
+    Skeleton skel = assets.skel;
+
+    Crowd crowd;
+    if(opts.crowd > 0 && !crowd.init(skel, opts.crowd, opts.palette, opts.fastStart ? &assets.head : nullptr)){
+        std::fprintf(stderr, "Failed to set up crowd of %d\n", opts.crowd); return 1; }
+
+    PoseHistory history;
+    if(opts.history > 0 && !history.init(skel, opts.history, opts.historyStep, opts.palette))
+        std::fprintf(stderr, "Pose history needs at least 2 frames\n");
+    std::vector<glm::mat4> pose(skel.bones.size());
+    SceneReport sceneReport;
+    if(opts.scene && crowd.instances > 0){
+        std::vector<glm::vec3> offsets; std::vector<float> phases;
+        scene.generate(offsets, phases);
+        crowd.setLayout(offsets, phases);
+        sceneReport.cpuBytes = crowd.cpuBytes();
+        sceneReport.gpuBytes = crowd.gpuBytes();
+        sceneReport.walkers = crowd.instances;
+        std::printf("scene %s: %d walkers, %s layout, seed %u\n", scene.name.c_str(), crowd.instances,
+                    scene.layout == SceneLayout::Grid ? "grid" : "random", scene.seed);
+    }
+    if(opts.crowd > 0 || opts.history > 0) startup.phase("crowd + history");
+
+    GpuTimer gpuTimer; gpuTimer.init();
+    long gpuResolved = 0;
+
+    FrameStats frameStats;
+    if(!frameStats.init(opts.frameCsv)) return 1;
+
+    FrameCapture capture;
+    if(opts.capture){
+        const char* pattern = opts.capture;
+        auto writeFrame = [pattern](const uint8_t* rgba, int fw, int fh, long frame){
+            char path[1024]; std::snprintf(path, sizeof(path), pattern, frame);
+            if(!writePPM(path, fw, fh, rgba, /*bottomUp=*/true)) std::fprintf(stderr, "Failed to write %s\n", path);
+        };
+        if(!capture.init(opts.captureRing, writeFrame)) return 1;
+    }
 
     glEnable(GL_DEPTH_TEST);
     // glEnable(GL_CULL_FACE); glCullFace(GL_BACK); // optional: cull back-faces
-
-    double start = glfwGetTime();
-
-    while(!glfwWindowShouldClose(win)){
-        glfwPollEvents();
-        int w, h; glfwGetFramebufferSize(win, &w, &h);
+    // Counters follow the calling thread: every counted stage runs on this one
+    if(opts.hwCounters && hwc::init()) std::printf("hw counters: on (user space, main thread)\n");
+    startup.phase("timers + capture");
+
+    double start = nowSeconds();
+    double reportStart = start; int reportFrames = 0; CrowdStats reportSum;
+    double statsStart = start, prevFrameEnd = start;
+    double lastFrame = start;
+    int lastW = opts.width, lastH = opts.height;    // framebuffer size of the last frame
+    double pausedAt = 0, pausedTotal = 0;           // animation clock stops while paused
+    auto msSince = [](double t0){ return (nowSeconds() - t0) * 1000.0; };
+
+    for(long frame = 0; (!fixedRun || frame < frameLimit) && (opts.headless || !glfwWindowShouldClose(win)); ++frame){
+        int w = opts.width, h = opts.height;
+        bool idled = false;
+        if(!opts.headless){
+            idled = g_redraw.wait(win, pausedAt == 0);
+            if(glfwWindowShouldClose(win)) break;
+            pacer.beginFrame();
+            if(!pacer.lowLatency){ glfwPollEvents(); pacer.inputSampled(); }
+            glfwGetFramebufferSize(win, &w, &h);
+        }
+        lastW = w; lastH = h;
+        glrec::frame(frame);
+        PROFILE_FRAME();
+        const double frameStart = nowSeconds();
+        if(g_pauseToggled){
+            g_pauseToggled = false;
+            if(pausedAt > 0){ pausedTotal += frameStart - pausedAt; pausedAt = 0; }
+            else pausedAt = frameStart;
+        }
+        const double animNow = pausedAt > 0 ? pausedAt : frameStart;
+        float t = fixedRun ? (float)(frame * simStep) : (float)(animNow - start - pausedTotal);
+        HudFrame hf;
+        hf.frameMs = (frameStart - lastFrame) * 1000.0; lastFrame = frameStart;
+        hf.bones = (int)skel.bones.size();
+        hf.instances = crowd.instances > 0 ? crowd.instances : 1;
+        // A GPU pass ends at each endPass(); its GPU time comes from a few frames ago
+        auto endPass = [&](const char* name, double cpuStart){
+            gpuTimer.mark(name);
+            hf.stage(name, msSince(cpuStart), gpuTimer.ms(name));
+        };
+
+        double stageStart = nowSeconds();
+        gpuTimer.beginFrame();
         glViewport(0,0,w,h);
         glClearColor(0.05f,0.06f,0.08f,1.0f);
         glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+        endPass("clear", stageStart);
+
+        // Build/draw lines and head sphere; the crowd only needs the grid from here
+        std::vector<LineVertex> lineVerts;
+        std::vector<TriVertex> triVerts;
+        stageStart = nowSeconds();
+        if(crowd.instances > 0){
+            appendGroundGrid(lineVerts);
+            crowd.update(t);
+            crowd.upload();
+            hf.stage("animate", crowd.stats.animMs);
+            hf.stage("encode", crowd.stats.encodeMs);
+            gpuTimer.mark("crowd upload");
+            hf.stage("crowd upload", crowd.stats.uploadMs, gpuTimer.ms("crowd upload"));
+        } else {
+            const double bones = (double)skel.bones.size();
+            {
+                PROFILE_ZONE("animateWalk");
+                {
+                    hwc::Scope hw("animate", bones, "bone");
+                    // The walk cycle drives makeHuman()'s bone layout only; an
+                    // asset skeleton without a clip holds its bind pose
+                    if(clip.rotations) clip.apply(skel, t); else if(!opts.asset) poseWalk(skel, t);
+                }
+                { PROFILE_ZONE("updateGlobals"); hwc::Scope hw("hierarchy", bones, "bone"); skel.updateGlobals(); }
+                POSE_SHADOW(skel);
+            }
+            {
+                hwc::Scope hw("geometry", 0, "vertex");
+                lineVerts = buildSkeletonLines(skel);
+                triVerts = buildHeadSphereTris(skel, /*stacks=*/16, /*slices=*/24);
+                hw.setUnits((double)(lineVerts.size() + triVerts.size()));
+            }
+            hf.stage("animate", msSince(stageStart));
+        }
+        if(history.capacity > 0){
+            if(crowd.instances > 0) history.push(crowd.globals.data());
+            else {
+                for(size_t i=0;i<skel.bones.size();++i) pose[i] = skel.bones[i].global;
+                history.push(pose.data());
+            }
+        }
+        stageStart = nowSeconds();
+        {
+            PROFILE_ZONE("upload");
+            hwc::Scope hw("upload", (double)(lineVerts.size() + triVerts.size()), "vertex");
+            glBindBuffer(GL_ARRAY_BUFFER, vboLines);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(lineVerts.size()*sizeof(LineVertex)), lineVerts.data());
+
+            glBindBuffer(GL_ARRAY_BUFFER, vboTris);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(triVerts.size()*sizeof(TriVertex)), triVerts.data());
+            countUpload(UploadCategory::Vertex, lineVerts.size()*sizeof(LineVertex) + triVerts.size()*sizeof(TriVertex));
+        }
+        endPass("upload", stageStart);
 
-        float t = (float)(glfwGetTime() - start);
-        animateWalk(skel, t);
-
-        // Build/draw lines
-        std::vector<LineVertex> lineVerts = buildSkeletonLines(skel);
-        glBindBuffer(GL_ARRAY_BUFFER, vboLines);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(lineVerts.size()*sizeof(LineVertex)), lineVerts.data());
-
-        // Build/draw head sphere
-        std::vector<TriVertex> triVerts = buildHeadSphereTris(skel, /*stacks=*/16, /*slices=*/24);
-        glBindBuffer(GL_ARRAY_BUFFER, vboTris);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(triVerts.size()*sizeof(TriVertex)), triVerts.data());
-
-        glm::mat4 V = g_cam.view();
-        glm::mat4 P = glm::perspective(glm::radians(60.0f), w>0? (float)w/(float)h : 1.6f, 0.05f, 50.0f);
+        // Low latency: everything above ran ahead of the input it does not need
+        if(!opts.headless && pacer.lowLatency){
+            pacer.waitForInput();
+            glfwPollEvents();
+            pacer.inputSampled();
+        }
+        float zFar = 50.0f;
+        glm::mat4 V = opts.scene ? scene.view(t, zFar) : g_cam.view();
+        float aspect = (w>0 && h>0)? (float)w/(float)h : 1.6f;
+        camUniforms.update(makeCameraBlock(V, 60.0f, aspect, 0.05f, zFar, opts.stereo, opts.ipd));
+        const int eyes = camUniforms.eyeCount;
+
+        {
+            hwc::Scope hw("draw", 0, "call");        // units: the draw calls, counted below
+            stageStart = nowSeconds();
+            glUseProgram(prog);
+
+            // Draw triangles (head) first or last — either is fine with depth test.
+            // One instance per eye: stereo never doubles the draw calls.
+            glBindVertexArray(vaoTris);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, (GLint)triVerts.size(), eyes);
+            glBindVertexArray(0);
+            endPass("head", stageStart);
+
+            stageStart = nowSeconds();
+            glBindVertexArray(vaoLines);
+            glDrawArraysInstanced(GL_LINES, 0, (GLint)lineVerts.size(), eyes);
+            glBindVertexArray(0);
+            endPass("lines", stageStart);
+            hf.drawCalls += 2;
+
+            if(crowd.instances > 0){
+                stageStart = nowSeconds();
+                crowd.draw(eyes);
+                endPass("crowd", stageStart);
+                hf.drawCalls += 2;
+            }
+
+            if(g_historyToggled){ g_historyToggled = false; history.visible = !history.visible; }
+            if(history.capacity > 0){
+                stageStart = nowSeconds();
+                history.draw(eyes, crowd.instances > 0 ? crowd.offsets[0] : glm::vec3(0));
+                endPass("history", stageStart);
+                if(history.visible && history.filled > 1) hf.drawCalls += 2;
+            }
+            hw.setUnits(hf.drawCalls);
+        }
 
-        glUseProgram(prog);
-        glUniformMatrix4fv(uView, 1, GL_FALSE, glm::value_ptr(V));
-        glUniformMatrix4fv(uProj, 1, GL_FALSE, glm::value_ptr(P));
+#if SKEL_DEBUG_DRAW
+        if(g_jointDebug){
+            if(crowd.instances > 0) drawJointDebug(skel, crowd.globals.data(), crowd.offsets[0]);
+            else drawJointDebug(skel, nullptr, glm::vec3(0));
+        }
+        stageStart = nowSeconds();
+        // Timed primitives expire on a clock that keeps running while paused
+        DEBUG_DRAW_FLUSH(fixedRun ? t : (float)(frameStart - start), eyes, w, h);
+        endPass("debug draw", stageStart);
+        hf.drawCalls += dbg::stats().draws;
+#endif
+
+        if(g_hudToggled){ g_hudToggled = false; hud.visible = !hud.visible; }
+        hf.cpuMs = msSince(frameStart);
+        hf.uploadBytes = (size_t)uploadFrameBytes();
+        hf.gpuMs = gpuTimer.frameMs();
+        if(opts.scene) sceneReport.addFrame(hf);
+        if(overlaysReady){
+            hud.record(hf);
+            hud.draw(eyes, w, h);
+        }
+        gpuTimer.mark("hud");
+
+        if(crowd.instances > 0){
+            reportSum.animMs += crowd.stats.animMs; reportSum.encodeMs += crowd.stats.encodeMs;
+            reportSum.uploadMs += crowd.stats.uploadMs; reportSum.paletteBytes += crowd.stats.paletteBytes;
+            reportSum.morphBytes += crowd.stats.morphBytes;
+            ++reportFrames;
+            double now = nowSeconds();
+            if(now - reportStart >= 2.0){
+                printCrowdReport(crowd, reportFrames, now - reportStart, reportSum);
+                reportStart = now; reportFrames = 0; reportSum = CrowdStats{};
+            }
+        }
 
-        // Draw triangles (head) first or last — either is fine with depth test
-        glBindVertexArray(vaoTris);
-        glDrawArrays(GL_TRIANGLES, 0, (GLint)triVerts.size());
-        glBindVertexArray(0);
+        if(opts.headless && opts.screenshotSet && frame == frameLimit - 1) g_screenshotRequested = true;
+        if(g_screenshotRequested){
+            g_screenshotRequested = false;
+            if(writeFramebufferPPM(opts.screenshot, w, h)){
+                std::printf("Saved %s (%dx%d)\n", opts.screenshot, w, h);
+                DEBUG_SCREEN_TEXT(glm::vec2(12.0f, 12.0f), "screenshot saved", glm::vec3(0.6f, 1.0f, 0.6f), 2.0f);
+                g_redraw.redrawAfter(2.0);
+            }
+        }
 
-        glBindVertexArray(vaoLines);
-        glDrawArrays(GL_LINES, 0, (GLint)lineVerts.size());
-        glBindVertexArray(0);
+        if(opts.capture){
+            capture.capture(w, h, frame);
+            gpuTimer.mark("readback");
+        }
+        gpuTimer.endFrame();
+
+        if(g_traceRequested){ g_traceRequested = false; saveTrace(opts.trace, opts.traceFrames); }
+
+        FrameStats::Sample fs;
+        fs.frameMs = frame > 0 && !idled ? hf.frameMs : -1.0;     // idle gaps are not frame times
+        fs.cpuMs = msSince(frameStart);
+        if(gpuTimer.resolved > gpuResolved){ gpuResolved = gpuTimer.resolved; fs.gpuMs = gpuTimer.frameMs(); }
+        if(frame == 0) startup.phase("first frame");
+        if(!opts.headless){
+            PROFILE_ZONE("glfwSwapBuffers");
+            pacer.beforePresent();
+            const double swapStart = nowSeconds();
+            glfwSwapBuffers(win);
+            fs.swapMs = msSince(swapStart);
+            pacer.presented();
+            fs.inputMs = pacer.lastInputToPresent() * 1000.0;
+            g_redraw.rendered();
+            if(frame == 0) startup.phase("first glfwSwapBuffers");
+        }
+        if(frame == 0){
+            startup.report(stdout);
+            if(!overlaysReady){
+                const double t0 = nowSeconds();
+                initOverlays();
+                std::printf("startup: overlay shaders compiled after the first frame in %.2f ms\n", msSince(t0));
+            }
+        }
+        const double frameEnd = nowSeconds();
+        frameStats.record(frame, frameEnd - start, fs);
+        endUploadFrame(frameEnd - prevFrameEnd);
+        prevFrameEnd = frameEnd;
+        if(opts.statsInterval > 0 && frameEnd - statsStart >= opts.statsInterval){
+            char label[64]; std::snprintf(label, sizeof(label), "frame times, last %.1f s", frameEnd - statsStart);
+            frameStats.summary(stdout, label, false);
+            uploadWindow().print(stdout, "  uploads");
+            frameStats.restartWindow();
+            restartUploadWindow();
+            statsStart = frameEnd;
+        }
+    }
+    glrec::stop();
+    frameStats.summary(stdout, "frame times, whole run", true);
+    if(g_redraw.enabled)
+        std::printf("  on-demand: %ld frames rendered, %.0f display refreshes skipped (idle %.0f, unfocused %.0f, iconified %.0f)\n",
+                    g_redraw.frames, g_redraw.skipped(), g_redraw.skippedIdle, g_redraw.skippedBackground, g_redraw.skippedIconified);
+    if(pacer.sleeps > 0)
+        std::printf("  pacing: slept %.1f ms/frame, wake-up overshoot %.3f ms avg\n",
+                    pacer.sleptSeconds * 1000.0 / (double)std::max(frameStats.totalFrames, 1L),
+                    pacer.overshootSeconds * 1000.0 / (double)pacer.sleeps);
+    std::printf("  startup uploads: %.1f KB\n", (double)startupUploadBytes() / 1024.0);
+    uploadRun().print(stdout, "  uploads");
+    hwc::report(stdout);
+#if SKEL_POSE_SHADOW
+    const PoseShadowStats shadow = poseShadowStats();
+    if(shadow.checked > 0)
+        std::printf("  pose shadow: %ld of %ld frame poses checked against the reference, %ld mismatched\n",
+                    shadow.checked, shadow.calls, shadow.mismatches);
+#endif
+    hwc::shutdown();
+    frameStats.destroy();
+    if(opts.traceSet) saveTrace(opts.trace, opts.traceFrames);
+
+    if(gpuTimer.resolved > 0){
+        std::printf("gpu: %.3f ms/frame (last), %ld frames timed, %ld dropped |", gpuTimer.frameMs(), gpuTimer.resolved, gpuTimer.dropped);
+        for(const GpuTimer::Pass& p : gpuTimer.averages()) std::printf(" %s %.3f", p.name, p.ms);
+        std::printf(" ms avg\n");
+    }
+    gpuTimer.destroy();
+
+    if(opts.capture){
+        capture.destroy();
+        const FrameCaptureStats& cs = capture.stats;
+        const double n = (double)std::max(cs.captured, 1L);
+        std::printf("capture: %ld frames, latency %.2f frames / %.2f ms, CPU waited on %ld frames (%.2f ms total)\n",
+                    cs.captured, cs.latencyFrames / n, cs.latencyMs / n, cs.waits, cs.waitMs);
+    }
 
-        glfwSwapBuffers(win);
+    if(opts.headless){
+        glFinish();
+        const double wall = nowSeconds() - start;
+        std::printf("headless: %ld frames (%.2f s simulated) in %.3f s, %.3f ms/frame\n",
+                    frameLimit, frameLimit * simStep, wall, wall * 1000.0 / (double)std::max(frameLimit, 1L));
     }
 
+    if(opts.scene) sceneReport.write(opts.report, scene, frameStats, lastW, lastH, nowSeconds() - start);
+
+    if(crowd.instances > 0) crowd.destroy();
+    if(history.capacity > 0) history.destroy();
     glDeleteBuffers(1, &vboLines);
     glDeleteVertexArrays(1, &vaoLines);
     glDeleteBuffers(1, &vboTris);
     glDeleteVertexArrays(1, &vaoTris);
+    hud.destroy();
+    DEBUG_DRAW_SHUTDOWN();
+    camUniforms.destroy();
     glDeleteProgram(prog);
-    glfwDestroyWindow(win);
-    glfwTerminate();
+    assets.file.destroy();
+    if(opts.headless) headless.destroy();
+    else { glfwDestroyWindow(win); glfwTerminate(); }
     return 0;
 }
@@ -0,0 +1,452 @@
+// Benchmark baseline store and regression comparator
+// ------------------------------------------------------------
+// Keeps named baselines of skeleton_bench --json results and --scene
+// --report files, and compares new runs against them:
+//
+//   skeleton_perfcmp save NAME RUN.json [RUN.json ...]
+//   skeleton_perfcmp compare NAME RUN.json [RUN.json ...]
+//   skeleton_perfcmp list
+//
+// A baseline is the directory DIR/NAME holding copies of its runs. Each
+// microbenchmark is one metric whose samples are its raw samples_ns; every
+// number in a scene report's frame_ms, stages_ms, uploads and memory sections
+// is a metric with one sample per run, so pass several runs of the same scene
+// to get a distribution. Per metric the comparison prints both medians, the
+// relative change, its bootstrap 95% confidence interval and the two-sided
+// Mann-Whitney U p-value. Lower is better for every metric.
+//
+// A metric regresses when its median grows by more than the threshold and the
+// difference is significant (p < alpha), or, with fewer than 3 samples on
+// either side where no test is meaningful, on the threshold alone.
+//
+// Options:
+//   --dir DIR            baseline store (default perf-baselines)
+//   --append             save: add runs to an existing baseline
+//   --threshold PCT      allowed median regression (default 5)
+//   --alpha P            significance level (default 0.01)
+//   --filter TEXT        only metrics whose name contains TEXT
+//
+// Exit status: 0 ok, 1 regression, 2 bad usage or unreadable input.
+// ------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct CompareOptions {
+    const char* dir = "perf-baselines";
+    bool append = false;
+    double thresholdPct = 5.0;
+    double alpha = 0.01;
+    const char* filter = nullptr;
+    std::vector<const char*> positional;
+};
+
+static bool parseArgs(int argc, char** argv, CompareOptions& o){
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        const char* next = (i+1 < argc) ? argv[i+1] : nullptr;
+        if(std::strcmp(a, "--dir") == 0 && next){ o.dir = next; ++i; }
+        else if(std::strcmp(a, "--append") == 0){ o.append = true; }
+        else if(std::strcmp(a, "--threshold") == 0 && next){ o.thresholdPct = std::atof(next); ++i; }
+        else if(std::strcmp(a, "--alpha") == 0 && next){ o.alpha = std::atof(next); ++i; }
+        else if(std::strcmp(a, "--filter") == 0 && next){ o.filter = next; ++i; }
+        else if(a[0] == '-' && a[1] == '-'){ std::fprintf(stderr, "Unknown argument '%s'\n", a); return false; }
+        else o.positional.push_back(a);
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Minimal JSON reader (the subset our own writers produce, plus escapes)
+// ------------------------------------------------------------
+struct Json {
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    double number = 0;
+    std::string string;
+    std::vector<Json> items;                            // Array
+    std::vector<std::pair<std::string, Json>> members;  // Object, in file order
+
+    const Json* find(const char* key) const {
+        for(const auto& m : members) if(m.first == key) return &m.second;
+        return nullptr;
+    }
+};
+
+struct JsonParser {
+    const char* p;
+    const char* end;
+    const char* error = nullptr;
+
+    void skipSpace(){ while(p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p; }
+    bool fail(const char* what){ if(!error) error = what; return false; }
+    bool literal(const char* s){
+        const size_t n = std::strlen(s);
+        if((size_t)(end - p) < n || std::strncmp(p, s, n) != 0) return fail("bad literal");
+        p += n; return true;
+    }
+
+    bool parseString(std::string& out){
+        if(*p != '"') return fail("expected string");
+        for(++p; p < end && *p != '"'; ++p){
+            if(*p != '\\'){ out += *p; continue; }
+            if(++p == end) break;
+            switch(*p){
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': if(end - p < 5) return fail("bad escape"); out += '?'; p += 4; break;   // names are ASCII
+                default: out += *p;
+            }
+        }
+        if(p == end) return fail("unterminated string");
+        ++p; return true;
+    }
+
+    bool parseValue(Json& v, int depth){
+        if(depth > 64) return fail("nesting too deep");
+        skipSpace();
+        if(p == end) return fail("unexpected end");
+        if(*p == '{'){
+            v.type = Json::Object; ++p; skipSpace();
+            if(p < end && *p == '}'){ ++p; return true; }
+            for(;;){
+                skipSpace();
+                std::string key;
+                if(!parseString(key)) return false;
+                skipSpace();
+                if(p == end || *p != ':') return fail("expected ':'");
+                ++p;
+                v.members.emplace_back(std::move(key), Json());
+                if(!parseValue(v.members.back().second, depth + 1)) return false;
+                skipSpace();
+                if(p < end && *p == ','){ ++p; continue; }
+                if(p < end && *p == '}'){ ++p; return true; }
+                return fail("expected ',' or '}'");
+            }
+        }
+        if(*p == '['){
+            v.type = Json::Array; ++p; skipSpace();
+            if(p < end && *p == ']'){ ++p; return true; }
+            for(;;){
+                v.items.emplace_back();
+                if(!parseValue(v.items.back(), depth + 1)) return false;
+                skipSpace();
+                if(p < end && *p == ','){ ++p; continue; }
+                if(p < end && *p == ']'){ ++p; return true; }
+                return fail("expected ',' or ']'");
+            }
+        }
+        if(*p == '"'){ v.type = Json::String; return parseString(v.string); }
+        if(*p == 't'){ v.type = Json::Bool; v.number = 1; return literal("true"); }
+        if(*p == 'f'){ v.type = Json::Bool; return literal("false"); }
+        if(*p == 'n'){ v.type = Json::Null; return literal("null"); }
+        char* stop = nullptr;
+        v.type = Json::Number;
+        v.number = std::strtod(p, &stop);
+        if(stop == p) return fail("unexpected character");
+        p = stop; return true;
+    }
+};
+
+static bool loadJson(const std::string& path, Json& out){
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if(!f){ std::fprintf(stderr, "Failed to open %s\n", path.c_str()); return false; }
+    std::string text;
+    char buf[1 << 16];
+    for(size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) text.append(buf, n);
+    std::fclose(f);
+
+    JsonParser jp{text.data(), text.data() + text.size()};
+    if(jp.parseValue(out, 0)){ jp.skipSpace(); if(jp.p != jp.end) jp.fail("trailing characters"); }
+    if(jp.error){
+        std::fprintf(stderr, "%s: JSON error at byte %ld: %s\n", path.c_str(), (long)(jp.p - text.data()), jp.error);
+        return false;
+    }
+    if(out.type != Json::Object){ std::fprintf(stderr, "%s: expected a JSON object\n", path.c_str()); return false; }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Metrics
+// ------------------------------------------------------------
+using MetricSet = std::map<std::string, std::vector<double>>;
+
+// Numeric leaves below v as "prefix.key"; array elements are keyed by their "name"
+static void flattenNumbers(const Json& v, const std::string& prefix, MetricSet& out){
+    if(v.type == Json::Number){ out[prefix].push_back(v.number); return; }
+    if(v.type == Json::Object){
+        for(const auto& m : v.members) if(m.first != "name") flattenNumbers(m.second, prefix + "." + m.first, out);
+        return;
+    }
+    if(v.type == Json::Array){
+        for(size_t i=0;i<v.items.size();++i){
+            const Json* name = v.items[i].find("name");
+            flattenNumbers(v.items[i], prefix + "." + (name && name->type == Json::String ? name->string : std::to_string(i)), out);
+        }
+    }
+}
+
+// Adds one run's metrics; `kind` says what the file was ("bench"/"scene:NAME")
+static bool collectMetrics(const std::string& path, MetricSet& out, std::string& kind){
+    Json root;
+    if(!loadJson(path, root)) return false;
+    if(const Json* benches = root.find("benchmarks")){
+        kind = "bench";
+        for(const Json& b : benches->items){
+            const Json* name = b.find("name");
+            const Json* samples = b.find("samples_ns");
+            if(!name || !samples) continue;
+            std::vector<double>& dst = out["bench." + name->string];
+            for(const Json& s : samples->items) if(s.type == Json::Number) dst.push_back(s.number);
+        }
+        return true;
+    }
+    if(const Json* scene = root.find("scene")){
+        const Json* name = scene->find("name");
+        kind = "scene:" + (name ? name->string : std::string("?"));
+        for(const char* section : {"frame_ms", "stages_ms", "uploads", "memory"})
+            if(const Json* s = root.find(section)) flattenNumbers(*s, section, out);
+        return true;
+    }
+    std::fprintf(stderr, "%s: neither a skeleton_bench result nor a scene report\n", path.c_str());
+    return false;
+}
+
+static bool collectRuns(const std::vector<std::string>& paths, MetricSet& out, std::string& kind){
+    for(const std::string& path : paths){
+        std::string k;
+        if(!collectMetrics(path, out, k)) return false;
+        if(!kind.empty() && k != kind){
+            std::fprintf(stderr, "%s: is %s but earlier runs are %s\n", path.c_str(), k.c_str(), kind.c_str());
+            return false;
+        }
+        kind = k;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Statistics
+// ------------------------------------------------------------
+static double median(std::vector<double> v){
+    std::sort(v.begin(), v.end());
+    const size_t n = v.size();
+    return n % 2 ? v[n/2] : 0.5 * (v[n/2 - 1] + v[n/2]);
+}
+
+// Two-sided Mann-Whitney U test, normal approximation with tie correction
+static double mannWhitneyP(const std::vector<double>& a, const std::vector<double>& b){
+    struct Obs { double v; int group; };
+    std::vector<Obs> all;
+    all.reserve(a.size() + b.size());
+    for(double v : a) all.push_back({v, 0});
+    for(double v : b) all.push_back({v, 1});
+    std::sort(all.begin(), all.end(), [](const Obs& x, const Obs& y){ return x.v < y.v; });
+
+    const double n1 = (double)a.size(), n2 = (double)b.size(), n = n1 + n2;
+    double rankSumA = 0, tieTerm = 0;
+    for(size_t i=0;i<all.size();){
+        size_t j = i;
+        while(j < all.size() && all[j].v == all[i].v) ++j;
+        const double rank = 0.5 * (double)(i + 1 + j);     // average of ranks i+1..j
+        const double t = (double)(j - i);
+        tieTerm += t * t * t - t;
+        for(size_t k=i;k<j;++k) if(all[k].group == 0) rankSumA += rank;
+        i = j;
+    }
+    const double u = rankSumA - n1 * (n1 + 1) * 0.5;
+    const double mu = n1 * n2 * 0.5;
+    const double sigma = std::sqrt(n1 * n2 / 12.0 * ((n + 1) - tieTerm / (n * (n - 1))));
+    if(sigma <= 0) return 1.0;
+    const double z = std::max(0.0, std::fabs(u - mu) - 0.5) / sigma;
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+// Fixed-seed generator so reruns print the same intervals
+struct Pcg32 {
+    uint64_t state = 0x853c49e6748fea9bULL;
+    uint32_t next(){
+        const uint64_t old = state;
+        state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        const uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+    size_t below(size_t n){ return (size_t)(((uint64_t)next() * n) >> 32); }
+};
+
+// Percentile bootstrap 95% interval of median(b) / median(a) - 1
+static void bootstrapRatioCI(const std::vector<double>& a, const std::vector<double>& b, double& lo, double& hi){
+    const int kResamples = 2000;
+    Pcg32 rng;
+    std::vector<double> ratios, ra(a.size()), rb(b.size());
+    ratios.reserve(kResamples);
+    for(int r=0;r<kResamples;++r){
+        for(double& x : ra) x = a[rng.below(a.size())];
+        for(double& x : rb) x = b[rng.below(b.size())];
+        const double ma = median(ra);
+        if(ma > 0) ratios.push_back(median(rb) / ma - 1.0);
+    }
+    if(ratios.empty()){ lo = hi = NAN; return; }
+    std::sort(ratios.begin(), ratios.end());
+    lo = ratios[(size_t)(0.025 * (double)(ratios.size() - 1))];
+    hi = ratios[(size_t)(0.975 * (double)(ratios.size() - 1))];
+}
+
+// ------------------------------------------------------------
+// Baseline store
+// ------------------------------------------------------------
+static std::vector<std::string> baselineRuns(const fs::path& dir){
+    std::vector<std::string> runs;
+    std::error_code ec;
+    for(const auto& e : fs::directory_iterator(dir, ec))
+        if(e.is_regular_file() && e.path().extension() == ".json") runs.push_back(e.path().string());
+    std::sort(runs.begin(), runs.end());
+    return runs;
+}
+
+static bool validName(const char* name){
+    if(!*name || std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) return false;
+    for(const char* c = name; *c; ++c) if(*c == '/' || *c == '\\') return false;
+    return true;
+}
+
+static int cmdSave(const CompareOptions& o, const char* name, const std::vector<std::string>& runs){
+    MetricSet metrics;
+    std::string kind;
+    if(!collectRuns(runs, metrics, kind)) return 2;     // refuse to store anything unreadable
+
+    const fs::path dir = fs::path(o.dir) / name;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if(ec){ std::fprintf(stderr, "Failed to create %s: %s\n", dir.string().c_str(), ec.message().c_str()); return 2; }
+    const std::vector<std::string> existing = baselineRuns(dir);
+    if(o.append && !existing.empty()){
+        MetricSet old;
+        std::string oldKind;
+        if(collectRuns(existing, old, oldKind) && oldKind != kind){
+            std::fprintf(stderr, "Baseline '%s' holds %s results, not %s\n", name, oldKind.c_str(), kind.c_str());
+            return 2;
+        }
+    }
+    size_t index = existing.size();
+    for(const std::string& run : runs){
+        char file[32];
+        do std::snprintf(file, sizeof(file), "run%03zu.json", index++); while(fs::exists(dir / file));
+        fs::copy_file(run, dir / file, ec);
+        if(ec){ std::fprintf(stderr, "Failed to copy %s: %s\n", run.c_str(), ec.message().c_str()); return 2; }
+    }
+    // Replaced runs go only once the new ones are in place
+    if(!o.append) for(const std::string& old : existing) fs::remove(old, ec);
+    std::printf("Baseline '%s': %zu run(s) of %s, %zu metrics (%s)\n", name, (o.append ? existing.size() : 0) + runs.size(),
+                kind.c_str(), metrics.size(), dir.string().c_str());
+    return 0;
+}
+
+static int cmdList(const CompareOptions& o){
+    std::error_code ec;
+    std::vector<fs::path> names;
+    for(const auto& e : fs::directory_iterator(o.dir, ec)) if(e.is_directory()) names.push_back(e.path());
+    std::sort(names.begin(), names.end());
+    for(const fs::path& p : names){
+        MetricSet m;
+        std::string kind;
+        const std::vector<std::string> runs = baselineRuns(p);
+        if(runs.empty() || !collectRuns(runs, m, kind)) kind = "unreadable";
+        std::printf("%-24s %3zu run(s)  %s\n", p.filename().string().c_str(), runs.size(), kind.c_str());
+    }
+    if(names.empty()) std::printf("No baselines in %s\n", o.dir);
+    return 0;
+}
+
+static int cmdCompare(const CompareOptions& o, const char* name, const std::vector<std::string>& runs){
+    const std::vector<std::string> baseRuns = baselineRuns(fs::path(o.dir) / name);
+    if(baseRuns.empty()){ std::fprintf(stderr, "No baseline '%s' in %s\n", name, o.dir); return 2; }
+    MetricSet base, cur;
+    std::string baseKind, curKind;
+    if(!collectRuns(baseRuns, base, baseKind) || !collectRuns(runs, cur, curKind)) return 2;
+    if(baseKind != curKind){
+        std::fprintf(stderr, "Baseline '%s' holds %s results, new runs are %s\n", name, baseKind.c_str(), curKind.c_str());
+        return 2;
+    }
+
+    std::printf("%s vs baseline '%s' (%zu run(s) vs %zu), threshold %+.1f%%, alpha %g\n",
+                curKind.c_str(), name, runs.size(), baseRuns.size(), o.thresholdPct, o.alpha);
+    std::printf("%-40s %12s %12s %9s %19s %9s  %s\n", "metric", "baseline", "new", "delta", "95% CI", "p", "verdict");
+    int regressions = 0, improvements = 0, compared = 0;
+    for(const auto& kv : cur){
+        const std::string& metric = kv.first;
+        if(o.filter && metric.find(o.filter) == std::string::npos) continue;
+        const auto it = base.find(metric);
+        if(it == base.end() || it->second.empty() || kv.second.empty()){
+            std::printf("%-40s %12s %12s %9s %19s %9s  %s\n", metric.c_str(), "-", "", "", "", "", "new metric");
+            continue;
+        }
+        const std::vector<double>& a = it->second;
+        const std::vector<double>& b = kv.second;
+        const double ma = median(a), mb = median(b);
+        const double delta = ma != 0 ? mb / ma - 1.0 : (mb == 0 ? 0.0 : INFINITY);
+        const bool testable = a.size() >= 3 && b.size() >= 3;
+        const double p = testable ? mannWhitneyP(a, b) : NAN;
+        const bool significant = !testable || p < o.alpha;
+        const double limit = o.thresholdPct * 0.01;
+
+        const char* verdict = "ok";
+        if(delta > limit && significant){ verdict = "REGRESSION"; ++regressions; }
+        else if(delta < -limit && significant){ verdict = "improved"; ++improvements; }
+        else if(std::fabs(delta) > limit) verdict = "noise";
+        ++compared;
+
+        char ci[32] = "", pv[16] = "";
+        if(testable){
+            double lo, hi; bootstrapRatioCI(a, b, lo, hi);
+            std::snprintf(ci, sizeof(ci), "[%+.1f%%, %+.1f%%]", lo * 100.0, hi * 100.0);
+            std::snprintf(pv, sizeof(pv), "%.2g", p);
+        }
+        std::printf("%-40s %12.4g %12.4g %+8.1f%% %19s %9s  %s\n", metric.c_str(), ma, mb, delta * 100.0, ci, pv, verdict);
+    }
+    for(const auto& kv : base)
+        if(!cur.count(kv.first) && (!o.filter || kv.first.find(o.filter) != std::string::npos))
+            std::printf("%-40s %12.4g %12s %9s %19s %9s  %s\n", kv.first.c_str(), median(kv.second), "-", "", "", "", "missing");
+
+    std::printf("%d metric(s) compared: %d regression(s), %d improvement(s)\n", compared, regressions, improvements);
+    return regressions ? 1 : 0;
+}
+
+// ------------------------------------------------------------
+// Main
+// ------------------------------------------------------------
+static void usage(){
+    std::fprintf(stderr, "Usage: skeleton_perfcmp save NAME RUN.json...    store runs as baseline NAME\n"
+                         "       skeleton_perfcmp compare NAME RUN.json... compare runs against NAME\n"
+                         "       skeleton_perfcmp list                     show stored baselines\n"
+                         "Options: --dir DIR --append --threshold PCT --alpha P --filter TEXT\n");
+}
+
+int main(int argc, char** argv){
+    CompareOptions opts;
+    if(!parseArgs(argc, argv, opts) || opts.positional.empty()){ usage(); return 2; }
+    const char* cmd = opts.positional[0];
+    if(std::strcmp(cmd, "list") == 0) return cmdList(opts);
+
+    if(opts.positional.size() < 3){ usage(); return 2; }
+    const char* name = opts.positional[1];
+    if(!validName(name)){ std::fprintf(stderr, "Bad baseline name '%s'\n", name); return 2; }
+    const std::vector<std::string> runs(opts.positional.begin() + 2, opts.positional.end());
+    if(std::strcmp(cmd, "save") == 0) return cmdSave(opts, name, runs);
+    if(std::strcmp(cmd, "compare") == 0) return cmdCompare(opts, name, runs);
+    usage();
+    return 2;
+}
@@ -0,0 +1,118 @@
+#include "pose_check.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// ------------------------------------------------------------
+// Reference
+// ------------------------------------------------------------
+// Do not optimize these two: they are the definition of correct
+static glm::mat4 referenceRotXYZ(const glm::vec3& deg){
+    glm::vec3 r = glm::radians(deg);
+    glm::mat4 Rx = glm::rotate(glm::mat4(1), r.x, {1,0,0});
+    glm::mat4 Ry = glm::rotate(glm::mat4(1), r.y, {0,1,0});
+    glm::mat4 Rz = glm::rotate(glm::mat4(1), r.z, {0,0,1});
+    return Rz * Ry * Rx;
+}
+
+void referenceGlobals(const Skeleton& s, std::vector<glm::mat4>& out){
+    out.resize(s.bones.size());
+    for(size_t i=0;i<s.bones.size();++i){
+        const int p = s.bones[i].parent;
+        glm::mat4 T = glm::translate(glm::mat4(1), s.bones[i].bindOffset);
+        glm::mat4 local = T * referenceRotXYZ(s.bones[i].eulerDeg);
+        out[i] = (p >= 0) ? out[(size_t)p] * local : local;
+    }
+}
+
+// ------------------------------------------------------------
+// Comparison
+// ------------------------------------------------------------
+int64_t ulpDistance(float a, float b){
+    if(std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b) ? 0 : std::numeric_limits<int64_t>::max();
+    int32_t ia, ib;
+    std::memcpy(&ia, &a, sizeof(ia));
+    std::memcpy(&ib, &b, sizeof(ib));
+    // Map sign-magnitude onto a monotonic integer line (+0 and -0 meet at 0)
+    const int64_t la = ia < 0 ? -(int64_t)(ia & 0x7fffffff) : ia;
+    const int64_t lb = ib < 0 ? -(int64_t)(ib & 0x7fffffff) : ib;
+    return la > lb ? la - lb : lb - la;
+}
+
+PoseMismatch comparePoses(const glm::mat4* reference, const glm::mat4* value, size_t count, const PoseTolerance& tol){
+    PoseMismatch worst;
+    for(size_t b=0;b<count;++b){
+        for(int c=0;c<4;++c){
+            for(int r=0;r<4;++r){
+                const float ref = reference[b][c][r], got = value[b][c][r];
+                const int64_t ulps = ulpDistance(ref, got);
+                const float absError = std::fabs(ref - got);
+                // <= 1 passes: within the ULP budget or the absolute one, whichever is looser
+                const double score = std::isnan(absError) ? INFINITY :
+                    std::min(tol.maxUlps > 0 ? (double)ulps / (double)tol.maxUlps : (ulps ? INFINITY : 0.0),
+                             tol.absEps > 0 ? (double)absError / (double)tol.absEps : (absError > 0 ? INFINITY : 0.0));
+                if(worst.bone < 0 || score > worst.score){
+                    worst.bone = (int)b; worst.column = c; worst.row = r;
+                    worst.reference = ref; worst.value = got;
+                    worst.ulps = ulps; worst.absError = absError;
+                    worst.score = score;
+                    worst.withinTolerance = score <= 1.0;
+                }
+            }
+        }
+    }
+    return worst;
+}
+
+void printMismatch(std::FILE* out, const char* label, const PoseMismatch& m){
+    if(m.bone < 0){ std::fprintf(out, "%s: nothing compared\n", label); return; }
+    std::fprintf(out, "%s: %s, worst bone %d m[%d][%d]: reference %.9g, got %.9g (%lld ulps, abs %.3g)\n",
+                 label, m.withinTolerance ? "ok" : "MISMATCH", m.bone, m.column, m.row,
+                 (double)m.reference, (double)m.value, (long long)m.ulps, (double)m.absError);
+}
+
+// ------------------------------------------------------------
+// Shadow evaluation
+// ------------------------------------------------------------
+namespace {
+std::atomic<int> g_sampleEvery{64};
+std::atomic<long> g_calls{0}, g_checked{0}, g_mismatches{0};
+std::mutex g_worstMutex;
+PoseTolerance g_tolerance;
+PoseMismatch g_worst;
+constexpr long kReportedMismatches = 5;     // then only counted
+}
+
+void poseShadowConfigure(int sampleEvery, const PoseTolerance& tol){
+    std::lock_guard<std::mutex> lock(g_worstMutex);
+    g_sampleEvery = std::max(1, sampleEvery);
+    g_tolerance = tol;
+}
+
+void poseShadowCheck(const Skeleton& s){
+    const long call = g_calls.fetch_add(1, std::memory_order_relaxed);
+    if(call % g_sampleEvery.load(std::memory_order_relaxed) != 0) return;
+
+    thread_local std::vector<glm::mat4> ref, got;
+    referenceGlobals(s, ref);
+    got.resize(s.bones.size());
+    for(size_t i=0;i<s.bones.size();++i) got[i] = s.bones[i].global;
+    g_checked.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(g_worstMutex);
+    const PoseMismatch m = comparePoses(ref.data(), got.data(), ref.size(), g_tolerance);
+    if(g_worst.bone < 0 || m.score > g_worst.score) g_worst = m;
+    if(!m.withinTolerance && g_mismatches.fetch_add(1, std::memory_order_relaxed) < kReportedMismatches)
+        printMismatch(stderr, "pose shadow: updateGlobals", m);
+}
+
+PoseShadowStats poseShadowStats(){
+    std::lock_guard<std::mutex> lock(g_worstMutex);
+    return {g_calls.load(), g_checked.load(), g_mismatches.load(), g_worst};
+}
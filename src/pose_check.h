@@ -0,0 +1,69 @@
+// Pose equivalence checking: a frozen scalar reference for the joint
+// hierarchy and tolerant comparison of global transforms.
+//
+// referenceGlobals() is the original glm implementation of rotXYZ and
+// updateGlobals, kept here unchanged so that optimized versions of those
+// (SIMD, SoA, quaternion composition, affine 3x4 matrices) always have
+// something to be compared against. comparePoses() checks two arrays of
+// transforms element by element: an element matches when it is within
+// maxUlps units in the last place OR within absEps, so values near zero do
+// not fail on huge ULP counts. The result names the worst element.
+//
+// POSE_SHADOW(skeleton) re-evaluates every sampleEvery-th call against the
+// reference and reports mismatches on stderr; it is on in builds without
+// NDEBUG and compiles to ((void)0) with SKEL_POSE_SHADOW=0. The app calls it
+// once per frame after its updateGlobals, and the crowd once per update
+// rather than per walker, so the cost does not grow with the crowd.
+// skeleton_posecheck runs the same comparison offline over random poses and
+// random topologies for every registered path.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "skeleton.h"
+
+#ifndef SKEL_POSE_SHADOW
+#ifdef NDEBUG
+#define SKEL_POSE_SHADOW 0
+#else
+#define SKEL_POSE_SHADOW 1
+#endif
+#endif
+
+struct PoseTolerance {
+    int64_t maxUlps = 4;
+    float absEps = 1e-5f;
+};
+
+// Worst element of a comparison; bone < 0 when nothing was compared
+struct PoseMismatch {
+    int bone = -1;
+    int column = 0, row = 0;            // glm: m[column][row]
+    float reference = 0, value = 0;
+    int64_t ulps = 0;
+    float absError = 0;
+    double score = 0;                   // error over tolerance, the looser of ULP and absolute; <= 1 passes
+    bool withinTolerance = true;
+};
+
+int64_t ulpDistance(float a, float b);
+void referenceGlobals(const Skeleton& s, std::vector<glm::mat4>& out);
+PoseMismatch comparePoses(const glm::mat4* reference, const glm::mat4* value, size_t count, const PoseTolerance& tol);
+void printMismatch(std::FILE* out, const char* label, const PoseMismatch& m);
+
+// Sampled shadow evaluation of Skeleton::updateGlobals; thread safe
+struct PoseShadowStats { long calls, checked, mismatches; PoseMismatch worst; };
+void poseShadowCheck(const Skeleton& s);
+PoseShadowStats poseShadowStats();
+void poseShadowConfigure(int sampleEvery, const PoseTolerance& tol);
+
+#if SKEL_POSE_SHADOW
+#define POSE_SHADOW(skel) poseShadowCheck(skel)
+#else
+#define POSE_SHADOW(skel) ((void)0)
+#endif
@@ -0,0 +1,204 @@
+// Pose equivalence checker (no GPU, no window, no OpenGL)
+// ------------------------------------------------------------
+// Runs the frozen scalar reference (pose_check.h) and every registered fast
+// path side by side and compares the global transforms. Inputs are the
+// makeHuman() skeleton over a full walk cycle plus random topologies (random
+// parents, offsets and bone counts) in random poses, all from --seed. For
+// each path it prints the worst element seen, with the bone, its depth and
+// the trial that produced it, and exits 1 if any path leaves its tolerance.
+//
+// Paths:
+//   updateGlobals        Skeleton::updateGlobals, the production hierarchy walk
+//   palette/quat         QuatTrans palette round trip, decoded as the shader does
+//   palette/half         QuatTransHalf palette round trip
+// New fast paths (SIMD, SoA, affine) register in kPaths with their tolerance.
+//
+// Options:
+//   --trials N           random skeletons (default 2000)
+//   --max-bones N        largest random skeleton (default 96)
+//   --seed N             random seed (default 1)
+//   --ulps N             override every path's ULP tolerance
+//   --abs EPS            override every path's absolute tolerance
+//   --path TEXT          only paths whose name contains TEXT
+// ------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "bone_palette.h"
+#include "pose_check.h"
+#include "skeleton.h"
+
+struct CheckOptions {
+    int trials = 2000;
+    int maxBones = 96;
+    uint32_t seed = 1;
+    long long ulps = -1;
+    float abs = -1.0f;
+    const char* path = nullptr;
+};
+
+static bool parseArgs(int argc, char** argv, CheckOptions& o){
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        const char* next = (i+1 < argc) ? argv[i+1] : nullptr;
+        if(std::strcmp(a, "--trials") == 0 && next){ o.trials = std::max(0, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--max-bones") == 0 && next){ o.maxBones = std::max(1, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--seed") == 0 && next){ o.seed = (uint32_t)std::strtoul(next, nullptr, 10); ++i; }
+        else if(std::strcmp(a, "--ulps") == 0 && next){ o.ulps = std::atoll(next); ++i; }
+        else if(std::strcmp(a, "--abs") == 0 && next){ o.abs = (float)std::atof(next); ++i; }
+        else if(std::strcmp(a, "--path") == 0 && next){ o.path = next; ++i; }
+        else { std::fprintf(stderr, "Unknown argument '%s'\n", a); return false; }
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Paths under test
+// ------------------------------------------------------------
+// Each computes the globals of s (locals already set) into out
+static void evalUpdateGlobals(Skeleton& s, std::vector<glm::mat4>& out){
+    s.updateGlobals();
+    out.resize(s.bones.size());
+    for(size_t i=0;i<s.bones.size();++i) out[i] = s.bones[i].global;
+}
+
+// CPU mirror of paletteFetch() in kPaletteDecodeGLSL for the compact formats
+static glm::mat4 decodeQuatTrans(glm::vec4 q, const glm::vec3& t){
+    q = glm::normalize(q);
+    const float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+    const float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+    const float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+    return glm::mat4(
+        glm::vec4(1.0f - 2.0f*(yy+zz), 2.0f*(xy+wz),        2.0f*(xz-wy),        0.0f),
+        glm::vec4(2.0f*(xy-wz),        1.0f - 2.0f*(xx+zz), 2.0f*(yz+wx),        0.0f),
+        glm::vec4(2.0f*(xz+wy),        2.0f*(yz-wx),        1.0f - 2.0f*(xx+yy), 0.0f),
+        glm::vec4(t, 1.0f));
+}
+
+static void evalPalette(PaletteFormat f, Skeleton& s, std::vector<glm::mat4>& out){
+    std::vector<glm::mat4> globals;
+    referenceGlobals(s, globals);
+    std::vector<unsigned char> buf(globals.size() * paletteBytesPerBone(f));
+    out.resize(globals.size());
+    if(!encodePalette(f, globals.data(), globals.size(), buf.data())){
+        for(glm::mat4& m : out) m = glm::mat4(NAN);     // would have fallen back to Mat4: flag it
+        return;
+    }
+    for(size_t i=0;i<globals.size();++i){
+        if(f == PaletteFormat::QuatTrans){
+            const float* p = reinterpret_cast<const float*>(buf.data()) + i * 8;
+            out[i] = decodeQuatTrans(glm::vec4(p[0], p[1], p[2], p[3]), glm::vec3(p[4], p[5], p[6]));
+        } else {
+            uint64_t p[2];
+            std::memcpy(p, buf.data() + i * 16, sizeof(p));
+            out[i] = decodeQuatTrans(glm::unpackHalf4x16(p[0]), glm::vec3(glm::unpackHalf4x16(p[1])));
+        }
+    }
+}
+
+struct PosePath {
+    const char* name;
+    PoseTolerance tolerance;
+    void (*eval)(Skeleton& s, std::vector<glm::mat4>& out);
+};
+
+// Tolerances: updateGlobals must stay bit-exact until someone decides
+// otherwise; fp32 quaternions lose a few ULPs per element; half floats keep
+// 11 significant bits, 2^12 fp32 ULPs, and rotation terms near 1e-3 absolute.
+static const PosePath kPaths[] = {
+    {"updateGlobals", {0, 0.0f}, evalUpdateGlobals},
+    {"palette/quat", {64, 2e-6f}, [](Skeleton& s, std::vector<glm::mat4>& out){ evalPalette(PaletteFormat::QuatTrans, s, out); }},
+    {"palette/half", {8192, 2e-3f}, [](Skeleton& s, std::vector<glm::mat4>& out){ evalPalette(PaletteFormat::QuatTransHalf, s, out); }},
+};
+
+// ------------------------------------------------------------
+// Inputs
+// ------------------------------------------------------------
+struct Pcg32 {
+    uint64_t state;
+    explicit Pcg32(uint64_t seed) : state(seed * 6364136223846793005ULL + 1442695040888963407ULL) {}
+    uint32_t next(){
+        const uint64_t old = state;
+        state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        const uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+    float uniform(float lo, float hi){ return lo + (hi - lo) * (float)(next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+// Parents always precede children, as updateGlobals requires; chains and bushes both occur
+static Skeleton randomSkeleton(Pcg32& rng, int maxBones){
+    Skeleton s;
+    const int n = 1 + (int)(rng.next() % (uint32_t)maxBones);
+    const bool chainy = (rng.next() & 1) != 0;
+    for(int i=0;i<n;++i){
+        int parent = -1;
+        if(i > 0) parent = chainy ? std::max(0, i - 1 - (int)(rng.next() % 3)) : (int)(rng.next() % (uint32_t)i);
+        const glm::vec3 offset(rng.uniform(-0.3f, 0.3f), rng.uniform(-0.3f, 0.3f), rng.uniform(-0.3f, 0.3f));
+        s.addBone(parent, i == 0 ? glm::vec3(rng.uniform(-5, 5), rng.uniform(0, 2), rng.uniform(-5, 5)) : offset, 0.1f);
+    }
+    for(Bone& b : s.bones) b.eulerDeg = glm::vec3(rng.uniform(-180, 180), rng.uniform(-180, 180), rng.uniform(-180, 180));
+    return s;
+}
+
+static int depthOf(const Skeleton& s, int bone){
+    int d = 0;
+    for(int b = s.bones[(size_t)bone].parent; b >= 0; b = s.bones[(size_t)b].parent) ++d;
+    return d;
+}
+
+// ------------------------------------------------------------
+// Main
+// ------------------------------------------------------------
+int main(int argc, char** argv){
+    CheckOptions opts;
+    if(!parseArgs(argc, argv, opts)) return 1;
+
+    int failures = 0, paths = 0;
+    for(const PosePath& path : kPaths){
+        if(opts.path && !std::strstr(path.name, opts.path)) continue;
+        ++paths;
+        PoseTolerance tol = path.tolerance;
+        if(opts.ulps >= 0) tol.maxUlps = opts.ulps;
+        if(opts.abs >= 0) tol.absEps = opts.abs;
+
+        PoseMismatch worst;
+        int worstTrial = -1, worstDepth = 0, worstBones = 0;
+        long failedTrials = 0, poses = 0;
+        std::vector<glm::mat4> ref, got;
+        auto check = [&](Skeleton& s, int trial){
+            referenceGlobals(s, ref);
+            path.eval(s, got);
+            const PoseMismatch m = comparePoses(ref.data(), got.data(), ref.size(), tol);
+            ++poses;
+            if(!m.withinTolerance) ++failedTrials;
+            if(worst.bone < 0 || m.score > worst.score){ worst = m; worstTrial = trial; worstDepth = depthOf(s, m.bone); worstBones = (int)s.bones.size(); }
+        };
+
+        // Trial -1..-120: the shipped skeleton over two seconds of walk
+        Skeleton human = makeHuman();
+        for(int f=0;f<120;++f){ poseWalk(human, (float)f / 60.0f); check(human, -1 - f); }
+        Pcg32 rng(opts.seed);
+        for(int t=0;t<opts.trials;++t){ Skeleton s = randomSkeleton(rng, opts.maxBones); check(s, t); }
+
+        char label[128];
+        std::snprintf(label, sizeof(label), "%-14s %ld poses, %ld out of tolerance (ulps %lld, abs %g)",
+                      path.name, poses, failedTrials, (long long)tol.maxUlps, (double)tol.absEps);
+        printMismatch(stdout, label, worst);
+        if(worst.bone >= 0)
+            std::printf("%16s trial %d (%s, %d bones), bone depth %d\n", "", worstTrial,
+                        worstTrial < 0 ? "walk cycle" : "random", worstBones, worstDepth);
+        if(failedTrials) ++failures;
+    }
+    if(paths == 0){ std::fprintf(stderr, "No path matches '%s'\n", opts.path); return 1; }
+    return failures ? 1 : 0;
+}
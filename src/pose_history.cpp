@@ -0,0 +1,174 @@
+#include "pose_history.h"
+
+#include <cstdio>
+#include <string>
+
+#include "gl_util.h"
+#include "camera_block.h"
+#include "crowd.h"
+#include "upload_stats.h"
+
+// ------------------------------------------------------------
+// Shader sources
+// ------------------------------------------------------------
+// uTrail = 0: instance = age-1 of a ghost pose, vertices from the bone template
+// uTrail = 1: instance = joint, gl_VertexID = age along its trajectory
+static const char* kHistoryVSHead = R"GLSL(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in int  aBone;
+
+uniform samplerBuffer uHistory;
+uniform int uFormat;
+uniform int uBoneCount;
+uniform int uCapacity;
+uniform int uNewest;
+uniform int uFilled;
+uniform int uTrail;
+uniform vec3 uOrigin;
+
+out vec4 vColor;
+)GLSL";
+
+static const char* kHistoryVSMain = R"GLSL(
+void main(){
+    int age, bone; vec3 local;
+    if(uTrail == 1){ age = gl_VertexID; bone = instanceIndex(); local = vec3(0.0); }
+    else           { age = instanceIndex() + 1; bone = aBone; local = aPos; }
+    int slot = (uNewest - age + uCapacity) % uCapacity;
+    mat4 M = paletteFetch(uHistory, uFormat, slot * uBoneCount + bone);
+    vec3 world = (M * vec4(local, 1.0)).xyz + uOrigin;
+
+    float fade = 1.0 - float(age) / float(uFilled);
+    vColor = uTrail == 1 ? vec4(1.0, 0.45, 0.2, 0.8 * fade)
+                         : vec4(0.4, 0.7, 1.0, 0.5 * fade * fade);
+    gl_Position = eyeClip(world, eyeIndex());
+}
+)GLSL";
+
+static const char* kHistoryFS = R"GLSL(
+#version 330 core
+in vec4 vColor;
+out vec4 FragColor;
+void main(){
+    FragColor = vColor;
+}
+)GLSL";
+
+// ------------------------------------------------------------
+// PoseHistory
+// ------------------------------------------------------------
+bool PoseHistory::init(const Skeleton& s, int frames, int everyNth, PaletteFormat fmt){
+    if(frames < 2) return false;
+    capacity = frames;
+    step = everyNth > 0 ? everyNth : 1;
+    boneCount = (int)s.bones.size();
+    format = fmt;
+
+    std::string vs = std::string(kHistoryVSHead) + kCameraBlockGLSL + kPaletteDecodeGLSL + kHistoryVSMain;
+    prog = makeProgram(vs.c_str(), kHistoryFS);
+    bindCameraBlock(prog);
+    uHistory = glGetUniformLocation(prog, "uHistory");
+    uFormat = glGetUniformLocation(prog, "uFormat");
+    uBoneCount = glGetUniformLocation(prog, "uBoneCount");
+    uCapacity = glGetUniformLocation(prog, "uCapacity");
+    uNewest = glGetUniformLocation(prog, "uNewest");
+    uFilled = glGetUniformLocation(prog, "uFilled");
+    uTrail = glGetUniformLocation(prog, "uTrail");
+    uOrigin = glGetUniformLocation(prog, "uOrigin");
+
+    std::vector<SkinnedVertex> lines;
+    appendSkinnedBoneLines(s, glm::vec3(1), lines);
+    boneVertexCount = (GLint)lines.size();
+
+    glGenVertexArrays(1, &vaoBones); glGenBuffers(1, &vboBones);
+    glBindVertexArray(vaoBones);
+    glBindBuffer(GL_ARRAY_BUFFER, vboBones);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(lines.size()*sizeof(SkinnedVertex)), lines.data(), GL_STATIC_DRAW);
+    countUpload(UploadCategory::Vertex, lines.size()*sizeof(SkinnedVertex));
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)0);
+    glEnableVertexAttribArray(2); glVertexAttribIPointer(2, 1, GL_INT, sizeof(SkinnedVertex), (void*)(2*sizeof(glm::vec3)));
+    glBindVertexArray(0);
+    glGenVertexArrays(1, &vaoEmpty);   // trails are attribute-less but core profile needs a VAO
+
+    glGenBuffers(1, &buf);
+    glGenTextures(1, &tex);
+    allocate();
+    std::printf("pose history: %d frames (every %d), %d bones, %s palette, %.1f KB\n",
+                capacity, step, boneCount, paletteFormatName(format), memoryBytes() / 1024.0);
+    return true;
+}
+
+void PoseHistory::allocate(){
+    scratch.resize((size_t)boneCount * paletteBytesPerBone(format));
+    glBindBuffer(GL_TEXTURE_BUFFER, buf);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)memoryBytes(), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, tex);
+    glTexBuffer(GL_TEXTURE_BUFFER, format == PaletteFormat::QuatTransHalf ? GL_RGBA16F : GL_RGBA32F, buf);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    clear();
+}
+
+void PoseHistory::push(const glm::mat4* globals){
+    if(pushed++ % (unsigned)step != 0) return;
+    if(!encodePalette(format, globals, (size_t)boneCount, scratch.data())){
+        // A non-rigid pose cannot live in a compact ring: restart it lossless
+        std::fprintf(stderr, "pose history: non-rigid transform, switching to mat4\n");
+        format = PaletteFormat::Mat4;
+        allocate();
+        encodePalette(format, globals, (size_t)boneCount, scratch.data());
+    }
+    newest = (newest + 1) % capacity;
+    if(filled < capacity) ++filled;
+    glBindBuffer(GL_TEXTURE_BUFFER, buf);
+    glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)((size_t)newest * scratch.size()), (GLsizeiptr)scratch.size(), scratch.data());
+    countUpload(UploadCategory::Texture, scratch.size());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void PoseHistory::draw(int eyeCount, const glm::vec3& origin){
+    if(!visible || filled < 2) return;
+
+    glUseProgram(prog);
+    glUniform1i(uHistory, 0);
+    glUniform1i(uFormat, (GLint)format);
+    glUniform1i(uBoneCount, boneCount);
+    glUniform1i(uCapacity, capacity);
+    glUniform1i(uNewest, newest);
+    glUniform1i(uFilled, filled);
+    glUniform3f(uOrigin, origin.x, origin.y, origin.z);
+    countUpload(UploadCategory::Uniform, 6*sizeof(GLint) + 3*sizeof(float));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, tex);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    // Ghost poses, age 1..filled-1 (age 0 is the live pose)
+    glUniform1i(uTrail, 0);
+    glBindVertexArray(vaoBones);
+    glDrawArraysInstanced(GL_LINES, 0, boneVertexCount, (filled - 1) * eyeCount);
+
+    // Joint trajectories, one strip per joint
+    glUniform1i(uTrail, 1);
+    countUpload(UploadCategory::Uniform, 2*sizeof(GLint));
+    glBindVertexArray(vaoEmpty);
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, filled, boneCount * eyeCount);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void PoseHistory::destroy(){
+    glDeleteTextures(1, &tex);
+    glDeleteBuffers(1, &buf);
+    glDeleteBuffers(1, &vboBones);
+    glDeleteVertexArrays(1, &vaoBones);
+    glDeleteVertexArrays(1, &vaoEmpty);
+    glDeleteProgram(prog);
+    capacity = 0;
+}
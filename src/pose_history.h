@@ -0,0 +1,46 @@
+// Onion-skin pose history: the last N bone palettes in a GPU ring buffer.
+//
+// push() encodes one frame's joint transforms into the next slot of a
+// texture buffer. draw() renders every stored pose with a single instanced
+// call (instance = age, fading with age) and the joint trajectories as one
+// instanced line strip per joint (vertex = age), so history length costs GPU
+// work but no CPU geometry rebuilds.
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "skeleton.h"
+#include "bone_palette.h"
+
+struct PoseHistory {
+    int capacity = 0;           // frames kept
+    int step = 1;               // record every step-th pushed frame
+    int boneCount = 0;
+    int newest = -1;            // slot of the latest pose
+    int filled = 0;             // valid slots
+    unsigned pushed = 0;
+    PaletteFormat format = PaletteFormat::QuatTrans;
+    bool visible = true;
+
+    std::vector<unsigned char> scratch;     // one encoded pose
+
+    GLuint prog = 0;
+    GLint uHistory = -1, uFormat = -1, uBoneCount = -1, uCapacity = -1;
+    GLint uNewest = -1, uFilled = -1, uTrail = -1, uOrigin = -1;
+    GLuint buf = 0, tex = 0;
+    GLuint vaoBones = 0, vboBones = 0, vaoEmpty = 0;
+    GLint boneVertexCount = 0;
+
+    bool init(const Skeleton& s, int frames, int everyNth, PaletteFormat fmt);
+    void push(const glm::mat4* globals);    // boneCount transforms
+    void clear() { newest = -1; filled = 0; }
+    void draw(int eyeCount, const glm::vec3& origin);
+    size_t memoryBytes() const { return (size_t)capacity * (size_t)boneCount * paletteBytesPerBone(format); }
+    void destroy();
+
+private:
+    void allocate();
+};
@@ -0,0 +1,158 @@
+#include "profiler.h"
+
+#if SKEL_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace prof {
+
+// ------------------------------------------------------------
+// Per-thread rings
+// ------------------------------------------------------------
+static constexpr uint64_t kRingEvents = 1u << 16;    // per thread, 1.5 MB
+static constexpr uint64_t kFrameMarks = 4096;
+
+struct Event { const char* name; uint64_t begin, end; };
+
+// Only the owning thread writes; head is published with release so a dump
+// sees complete events. A dump racing with wrap-around discards the slots the
+// writer may have reused while it was copying.
+struct ThreadRing {
+    Event events[kRingEvents];
+    std::atomic<uint64_t> head{0};
+    int tid = 0;
+    char name[32] = {};
+};
+
+static std::mutex g_mutex;                              // registration and dumps
+static std::vector<std::unique_ptr<ThreadRing>> g_rings; // kept until exit, threads may end first
+static thread_local ThreadRing* t_ring = nullptr;
+
+static uint64_t g_frameMarks[kFrameMarks];              // written by the frameMark() thread only
+static std::atomic<uint64_t> g_frameCount{0};
+
+static uint64_t steadyNs(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Tick origin for the trace and its pairing with steady_clock for TSC scaling
+static const uint64_t g_originTicks = ticks();
+static const uint64_t g_originNs = steadyNs();
+
+static ThreadRing* registerThread(){
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_rings.push_back(std::make_unique<ThreadRing>());
+    ThreadRing* r = g_rings.back().get();
+    r->tid = (int)g_rings.size();
+    std::snprintf(r->name, sizeof(r->name), "thread %d", r->tid);
+    t_ring = r;
+    return r;
+}
+
+void record(const char* name, uint64_t begin, uint64_t end){
+    ThreadRing* r = t_ring ? t_ring : registerThread();
+    const uint64_t h = r->head.load(std::memory_order_relaxed);
+    r->events[h & (kRingEvents - 1)] = Event{name, begin, end};
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+void frameMark(){
+    const uint64_t now = ticks();
+    const uint64_t n = g_frameCount.load(std::memory_order_relaxed);
+    if(n > 0) record("frame", g_frameMarks[(n - 1) % kFrameMarks], now);
+    g_frameMarks[n % kFrameMarks] = now;
+    g_frameCount.store(n + 1, std::memory_order_release);
+}
+
+void setThreadName(const char* name){
+    ThreadRing* r = t_ring ? t_ring : registerThread();
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::snprintf(r->name, sizeof(r->name), "%s", name);
+}
+
+Stats stats(){
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Stats s;
+    s.threads = (int)g_rings.size();
+    for(const auto& r : g_rings){
+        const uint64_t h = r->head.load(std::memory_order_acquire);
+        s.zones += h;
+        s.overwritten += h > kRingEvents ? h - kRingEvents : 0;
+    }
+    return s;
+}
+
+// ------------------------------------------------------------
+// Chrome trace-event export
+// ------------------------------------------------------------
+static void writeName(std::FILE* f, const char* s){
+    std::fputc('"', f);
+    for(; *s; ++s){
+        if(*s == '"' || *s == '\\') std::fputc('\\', f);
+        if((unsigned char)*s >= 0x20) std::fputc(*s, f);
+    }
+    std::fputc('"', f);
+}
+
+bool dumpChromeTrace(const char* path, int frames){
+    // Microseconds per tick, measured over the whole run so far
+    double usPerTick = 1e-3;
+#if SKEL_PROFILE_TSC
+    const uint64_t nowTicks = ticks(), nowNs = steadyNs();
+    if(nowTicks > g_originTicks) usPerTick = (double)(nowNs - g_originNs) * 1e-3 / (double)(nowTicks - g_originTicks);
+#endif
+
+    // Window start: the mark `frames` frames back, or everything buffered
+    uint64_t from = 0;
+    const uint64_t marks = g_frameCount.load(std::memory_order_acquire);
+    if(frames > 0 && marks > 0){
+        const uint64_t back = std::min<uint64_t>({(uint64_t)frames, marks, kFrameMarks});
+        from = g_frameMarks[(marks - back) % kFrameMarks];
+    }
+
+    std::FILE* f = std::fopen(path, "wb");
+    if(!f){ std::fprintf(stderr, "Failed to open %s for writing\n", path); return false; }
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::vector<Event> snapshot;
+    size_t written = 0;
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for(const auto& r : g_rings){
+        std::fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", written ? ",\n" : "", r->tid);
+        writeName(f, r->name);
+        std::fprintf(f, "}}");
+        ++written;
+
+        const uint64_t head = r->head.load(std::memory_order_acquire);
+        const uint64_t first = head > kRingEvents ? head - kRingEvents : 0;
+        snapshot.clear();
+        for(uint64_t i = first; i < head; ++i) snapshot.push_back(r->events[i & (kRingEvents - 1)]);
+        // Slots below this were reused by the writer while copying
+        const uint64_t after = r->head.load(std::memory_order_acquire);
+        const uint64_t valid = after > kRingEvents ? after - kRingEvents : 0;
+        for(uint64_t i = std::max(first, valid); i < head; ++i){
+            const Event& e = snapshot[(size_t)(i - first)];
+            if(e.end < from || e.begin < g_originTicks) continue;
+            std::fprintf(f, ",\n{\"ph\":\"X\",\"name\":");
+            writeName(f, e.name);
+            std::fprintf(f, ",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", r->tid,
+                         (double)(e.begin - g_originTicks) * usPerTick, (double)(e.end - e.begin) * usPerTick);
+            ++written;
+        }
+    }
+    std::fprintf(f, "\n]}\n");
+    const bool ok = std::fclose(f) == 0;
+    if(!ok) std::fprintf(stderr, "Failed to write %s\n", path);
+    return ok;
+}
+
+} // namespace prof
+
+#endif
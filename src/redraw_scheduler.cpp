@@ -0,0 +1,48 @@
+#include "redraw_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <GLFW/glfw3.h>
+
+static double nowSeconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RedrawScheduler::redrawAfter(double seconds){
+    const double t = nowSeconds() + seconds;
+    wakeAt = wakeAt > 0 ? std::min(wakeAt, t) : t;
+}
+
+bool RedrawScheduler::wait(GLFWwindow* win, bool animating){
+    if(!enabled) return false;
+    for(bool waited = false;; waited = true){
+        if(glfwWindowShouldClose(win)) return waited;
+        double now = nowSeconds();
+        if(wakeAt > 0 && now >= wakeAt){ wakeAt = 0; dirty = true; }
+
+        const double t0 = now;
+        if(iconified){
+            glfwWaitEvents();
+            skippedIconified += (nowSeconds() - t0) / refreshSeconds;
+            continue;
+        }
+        if(dirty || animating){
+            if(focused || backgroundFps <= 0) return waited;
+            const double next = lastFrame + 1.0 / backgroundFps;
+            if(now >= next) return waited;
+            glfwWaitEventsTimeout(next - now);
+            skippedBackground += (nowSeconds() - t0) / refreshSeconds;
+            continue;
+        }
+        if(wakeAt > 0) glfwWaitEventsTimeout(wakeAt - now);
+        else glfwWaitEvents();
+        skippedIdle += (nowSeconds() - t0) / refreshSeconds;
+    }
+}
+
+void RedrawScheduler::rendered(){
+    dirty = false;
+    lastFrame = nowSeconds();
+    ++frames;
+}
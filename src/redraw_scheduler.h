@@ -0,0 +1,36 @@
+// On-demand rendering: decides when the windowed loop may render and idles
+// in glfwWaitEvents* otherwise.
+//
+// A frame is due when the scene is dirty (input, window events, a pending
+// request) or the animation is running. With nothing due the loop sleeps in
+// glfwWaitEventsTimeout until an event or the next scheduled redraw (e.g. a
+// timed debug label expiring). Unfocused windows render at most
+// backgroundFps; iconified ones block in glfwWaitEvents until restored.
+// Time spent not rendering is counted as skipped display refreshes.
+#pragma once
+
+struct GLFWwindow;
+
+struct RedrawScheduler {
+    bool enabled = false;
+    double backgroundFps = 10.0;        // unfocused cap, <= 0 = no throttle
+    double refreshSeconds = 1.0 / 60.0; // display period, for skipped-frame counts
+
+    // Window state, kept current by the GLFW callbacks
+    bool focused = true, iconified = false;
+
+    void markDirty() { dirty = true; }
+    void redrawAfter(double seconds);   // one more frame after `seconds`
+    // Blocks until a frame is due or the window should close; true if it had to wait
+    bool wait(GLFWwindow* win, bool animating);
+    void rendered();                    // a frame was drawn; clears the dirty flag
+
+    long frames = 0;
+    double skippedIdle = 0, skippedBackground = 0, skippedIconified = 0;   // display refreshes
+    double skipped() const { return skippedIdle + skippedBackground + skippedIconified; }
+
+private:
+    bool dirty = true;
+    double wakeAt = 0;                  // scheduled redraw, 0 = none
+    double lastFrame = 0;
+};
@@ -0,0 +1,418 @@
+// Headless replay of a GL recording (skeleton --gl-record)
+// ------------------------------------------------------------
+// Runs the recorded setup prefix once, then re-issues the recorded frames in
+// a loop on a surfaceless EGL context: the same calls, uploads and draws the
+// app made, without any of its CPU work. Per replayed frame it reports the
+// CPU time spent submitting (driver cost), the frame interval and, through
+// timestamp queries, the GPU time, so the same file can be timed on
+// different drivers (e.g. llvmpipe against a vendor driver).
+//
+// Options:
+//   --loops N            replays of the recorded frames (default 100)
+//   --warmup N           unmeasured replays first (default 2)
+//   --sync               glFinish after every frame, so intervals include the GPU
+//   --screenshot FILE    save the last replayed frame (PPM)
+// ------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_record.h"
+#include "headless.h"
+#include "gpu_timer.h"
+#include "frame_stats.h"
+#include "gl_util.h"
+
+using glrec::Op;
+
+struct ReplayOptions {
+    const char* file = nullptr;
+    int loops = 100;
+    int warmup = 2;
+    bool sync = false;
+    const char* screenshot = nullptr;
+};
+
+static bool parseArgs(int argc, char** argv, ReplayOptions& o){
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        const char* next = (i+1 < argc) ? argv[i+1] : nullptr;
+        if(std::strcmp(a, "--loops") == 0 && next){ o.loops = std::max(1, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--warmup") == 0 && next){ o.warmup = std::max(0, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--sync") == 0){ o.sync = true; }
+        else if(std::strcmp(a, "--screenshot") == 0 && next){ o.screenshot = next; ++i; }
+        else if(a[0] != '-' && !o.file){ o.file = a; }
+        else { std::fprintf(stderr, "Unknown argument '%s'\n", a); return false; }
+    }
+    if(!o.file){ std::fprintf(stderr, "Usage: skeleton_replay FILE [--loops N] [--warmup N] [--sync] [--screenshot FILE]\n"); return false; }
+    return true;
+}
+
+static double nowSeconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ------------------------------------------------------------
+// Command interpreter
+// ------------------------------------------------------------
+// Recorded object name -> name in this context (0 stays 0)
+struct NameMap {
+    std::unordered_map<GLuint, GLuint> names;
+    GLuint operator()(GLuint recorded) const {
+        if(recorded == 0) return 0;
+        auto it = names.find(recorded);
+        return it == names.end() ? recorded : it->second;
+    }
+};
+
+struct Replayer {
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+    bool error = false;
+
+    NameMap buffers, arrays, textures, renderbuffers, framebuffers, objects;   // objects: shaders + programs
+    std::unordered_map<uint64_t, GLint> locations;      // (program, recorded location)
+    std::unordered_map<uint64_t, GLuint> blockIndices;  // (program, recorded index)
+    GLuint program = 0;                                 // recorded name of the current program
+    GLuint defaultFramebuffer = 0;                      // the headless FBO stands in for 0
+    struct Mapping { GLenum target; void* ptr; };
+    std::vector<Mapping> maps;
+    std::vector<uint8_t> scratch;
+    long calls = 0;
+    uint64_t uploadBytes = 0;
+
+    template<class T> T get(){
+        T v{};
+        if((size_t)(end - p) < sizeof(T)){ error = true; p = end; return v; }
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+    const uint8_t* bytes(size_t& n){
+        n = (size_t)get<uint64_t>();
+        if((size_t)(end - p) < n){ error = true; n = 0; p = end; return nullptr; }
+        const uint8_t* d = p;
+        p += n;
+        return n ? d : nullptr;
+    }
+    static uint64_t key(GLuint prog, uint32_t v){ return ((uint64_t)prog << 32) | v; }
+    GLint location(GLint recorded) const {
+        if(recorded < 0) return recorded;
+        auto it = locations.find(key(program, (uint32_t)recorded));
+        return it == locations.end() ? recorded : it->second;
+    }
+
+    void gen(NameMap& m, void (APIENTRYP fn)(GLsizei, GLuint*)){
+        size_t n; const uint8_t* d = bytes(n);
+        std::vector<GLuint> rec(n / sizeof(GLuint)), out(rec.size());
+        if(d) std::memcpy(rec.data(), d, n);
+        fn((GLsizei)out.size(), out.data());
+        for(size_t i=0;i<rec.size();++i) m.names[rec[i]] = out[i];
+    }
+    void del(NameMap& m, void (APIENTRYP fn)(GLsizei, const GLuint*)){
+        size_t n; const uint8_t* d = bytes(n);
+        std::vector<GLuint> names(n / sizeof(GLuint));
+        if(d) std::memcpy(names.data(), d, n);
+        for(GLuint& x : names){ const GLuint r = m(x); m.names.erase(x); x = r; }
+        fn((GLsizei)names.size(), names.data());
+    }
+
+    // Executes one command; returns it (Op::Frame = frame boundary, Op::Count = end or error)
+    Op step(){
+        if(p >= end) return Op::Count;
+        const Op op = (Op)get<uint16_t>();
+        ++calls;
+        switch(op){
+        case Op::Frame: get<uint32_t>(); --calls; break;
+        case Op::Enable: glEnable(get<GLenum>()); break;
+        case Op::Disable: glDisable(get<GLenum>()); break;
+        case Op::BlendFunc: { const GLenum s = get<GLenum>(), d = get<GLenum>(); glBlendFunc(s, d); } break;
+        case Op::DepthMask: glDepthMask(get<GLboolean>()); break;
+        case Op::CullFace: glCullFace(get<GLenum>()); break;
+        case Op::Viewport: {
+            const GLint x = get<GLint>(), y = get<GLint>(); const GLsizei w = get<GLsizei>(), h = get<GLsizei>();
+            glViewport(x, y, w, h);
+        } break;
+        case Op::ClearColor: {
+            const GLfloat r = get<GLfloat>(), g = get<GLfloat>(), b = get<GLfloat>(), a = get<GLfloat>();
+            glClearColor(r, g, b, a);
+        } break;
+        case Op::Clear: glClear(get<GLbitfield>()); break;
+        case Op::PixelStorei: { const GLenum n = get<GLenum>(); glPixelStorei(n, get<GLint>()); } break;
+        case Op::ActiveTexture: glActiveTexture(get<GLenum>()); break;
+        case Op::TexParameteri: {
+            const GLenum t = get<GLenum>(), n = get<GLenum>();
+            glTexParameteri(t, n, get<GLint>());
+        } break;
+        case Op::VertexAttribDivisor: { const GLuint i = get<GLuint>(); glVertexAttribDivisor(i, get<GLuint>()); } break;
+        case Op::EnableVertexAttribArray: glEnableVertexAttribArray(get<GLuint>()); break;
+        case Op::VertexAttribPointer: {
+            const GLuint i = get<GLuint>(); const GLint size = get<GLint>(); const GLenum type = get<GLenum>();
+            const GLboolean norm = get<GLboolean>(); const GLsizei stride = get<GLsizei>();
+            glVertexAttribPointer(i, size, type, norm, stride, get<const void*>());
+        } break;
+        case Op::VertexAttribIPointer: {
+            const GLuint i = get<GLuint>(); const GLint size = get<GLint>(); const GLenum type = get<GLenum>();
+            const GLsizei stride = get<GLsizei>();
+            glVertexAttribIPointer(i, size, type, stride, get<const void*>());
+        } break;
+        case Op::DrawArraysInstanced: {
+            const GLenum mode = get<GLenum>(); const GLint first = get<GLint>();
+            const GLsizei count = get<GLsizei>(), inst = get<GLsizei>();
+            glDrawArraysInstanced(mode, first, count, inst);
+        } break;
+        case Op::DrawElementsInstancedBaseVertex: {
+            const GLenum mode = get<GLenum>(); const GLsizei count = get<GLsizei>(); const GLenum type = get<GLenum>();
+            const void* indices = get<const void*>(); const GLsizei inst = get<GLsizei>(); const GLint base = get<GLint>();
+            glDrawElementsInstancedBaseVertex(mode, count, type, indices, inst, base);
+        } break;
+        case Op::Finish: glFinish(); break;
+
+        case Op::BindBuffer: { const GLenum t = get<GLenum>(); glBindBuffer(t, buffers(get<GLuint>())); } break;
+        case Op::BindVertexArray: glBindVertexArray(arrays(get<GLuint>())); break;
+        case Op::BindTexture: { const GLenum t = get<GLenum>(); glBindTexture(t, textures(get<GLuint>())); } break;
+        case Op::UseProgram: program = get<GLuint>(); glUseProgram(objects(program)); break;
+        case Op::BindBufferBase: {
+            const GLenum t = get<GLenum>(); const GLuint i = get<GLuint>();
+            glBindBufferBase(t, i, buffers(get<GLuint>()));
+        } break;
+        case Op::TexBuffer: {
+            const GLenum t = get<GLenum>(), f = get<GLenum>();
+            glTexBuffer(t, f, buffers(get<GLuint>()));
+        } break;
+        case Op::BindRenderbuffer: { const GLenum t = get<GLenum>(); glBindRenderbuffer(t, renderbuffers(get<GLuint>())); } break;
+        case Op::RenderbufferStorage: {
+            const GLenum t = get<GLenum>(), f = get<GLenum>(); const GLsizei w = get<GLsizei>(), h = get<GLsizei>();
+            glRenderbufferStorage(t, f, w, h);
+        } break;
+        case Op::BindFramebuffer: {
+            const GLenum t = get<GLenum>(); const GLuint fb = get<GLuint>();
+            auto it = framebuffers.names.find(fb);
+            glBindFramebuffer(t, it != framebuffers.names.end() ? it->second : defaultFramebuffer);
+        } break;
+        case Op::FramebufferRenderbuffer: {
+            const GLenum t = get<GLenum>(), att = get<GLenum>(), rt = get<GLenum>();
+            glFramebufferRenderbuffer(t, att, rt, renderbuffers(get<GLuint>()));
+        } break;
+
+        case Op::CreateShader: { const GLenum type = get<GLenum>(); objects.names[get<GLuint>()] = glCreateShader(type); } break;
+        case Op::ShaderSource: {
+            const GLuint s = objects(get<GLuint>());
+            size_t n; const uint8_t* d = bytes(n);
+            const GLchar* src = reinterpret_cast<const GLchar*>(d ? d : (const uint8_t*)"");
+            const GLint len = (GLint)n;
+            glShaderSource(s, 1, &src, &len);
+        } break;
+        case Op::CompileShader: glCompileShader(objects(get<GLuint>())); break;
+        case Op::CreateProgram: objects.names[get<GLuint>()] = glCreateProgram(); break;
+        case Op::AttachShader: { const GLuint prog = objects(get<GLuint>()); glAttachShader(prog, objects(get<GLuint>())); } break;
+        case Op::LinkProgram: glLinkProgram(objects(get<GLuint>())); break;
+        case Op::DeleteShader: { const GLuint s = get<GLuint>(); glDeleteShader(objects(s)); objects.names.erase(s); } break;
+        case Op::DeleteProgram: { const GLuint s = get<GLuint>(); glDeleteProgram(objects(s)); objects.names.erase(s); } break;
+        case Op::GetUniformLocation: {
+            const GLuint prog = get<GLuint>(); const GLint loc = get<GLint>();
+            size_t n; const uint8_t* d = bytes(n);
+            const std::string name(reinterpret_cast<const char*>(d ? d : (const uint8_t*)""), n);
+            if(loc >= 0) locations[key(prog, (uint32_t)loc)] = glGetUniformLocation(objects(prog), name.c_str());
+        } break;
+        case Op::GetUniformBlockIndex: {
+            const GLuint prog = get<GLuint>(); const GLuint index = get<GLuint>();
+            size_t n; const uint8_t* d = bytes(n);
+            const std::string name(reinterpret_cast<const char*>(d ? d : (const uint8_t*)""), n);
+            blockIndices[key(prog, index)] = glGetUniformBlockIndex(objects(prog), name.c_str());
+        } break;
+        case Op::UniformBlockBinding: {
+            const GLuint prog = get<GLuint>(), index = get<GLuint>(), binding = get<GLuint>();
+            auto it = blockIndices.find(key(prog, index));
+            glUniformBlockBinding(objects(prog), it == blockIndices.end() ? index : it->second, binding);
+        } break;
+        case Op::Uniform1i: { const GLint l = location(get<GLint>()); glUniform1i(l, get<GLint>()); } break;
+        case Op::Uniform1f: { const GLint l = location(get<GLint>()); glUniform1f(l, get<GLfloat>()); } break;
+        case Op::Uniform2i: {
+            const GLint l = location(get<GLint>()); const GLint x = get<GLint>(), y = get<GLint>();
+            glUniform2i(l, x, y);
+        } break;
+        case Op::Uniform2f: {
+            const GLint l = location(get<GLint>()); const GLfloat x = get<GLfloat>(), y = get<GLfloat>();
+            glUniform2f(l, x, y);
+        } break;
+        case Op::Uniform3f: {
+            const GLint l = location(get<GLint>()); const GLfloat x = get<GLfloat>(), y = get<GLfloat>(), z = get<GLfloat>();
+            glUniform3f(l, x, y, z);
+        } break;
+
+        case Op::GenBuffers: gen(buffers, glGenBuffers); break;
+        case Op::DeleteBuffers: del(buffers, glDeleteBuffers); break;
+        case Op::GenVertexArrays: gen(arrays, glGenVertexArrays); break;
+        case Op::DeleteVertexArrays: del(arrays, glDeleteVertexArrays); break;
+        case Op::GenTextures: gen(textures, glGenTextures); break;
+        case Op::DeleteTextures: del(textures, glDeleteTextures); break;
+        case Op::GenRenderbuffers: gen(renderbuffers, glGenRenderbuffers); break;
+        case Op::DeleteRenderbuffers: del(renderbuffers, glDeleteRenderbuffers); break;
+        case Op::GenFramebuffers: gen(framebuffers, glGenFramebuffers); break;
+        case Op::DeleteFramebuffers: del(framebuffers, glDeleteFramebuffers); break;
+
+        case Op::BufferData: {
+            const GLenum t = get<GLenum>(); const GLsizeiptr size = get<GLsizeiptr>(); const GLenum usage = get<GLenum>();
+            size_t n; const uint8_t* d = bytes(n);
+            glBufferData(t, size, d, usage);
+            uploadBytes += n;
+        } break;
+        case Op::BufferSubData: {
+            const GLenum t = get<GLenum>(); const GLintptr off = get<GLintptr>();
+            size_t n; const uint8_t* d = bytes(n);
+            glBufferSubData(t, off, (GLsizeiptr)n, d);
+            uploadBytes += n;
+        } break;
+        case Op::TexImage2D: {
+            const GLenum t = get<GLenum>(); const GLint level = get<GLint>(), fmt = get<GLint>();
+            const GLsizei w = get<GLsizei>(), h = get<GLsizei>(); const GLint border = get<GLint>();
+            const GLenum format = get<GLenum>(), type = get<GLenum>();
+            size_t n; const uint8_t* d = bytes(n);
+            glTexImage2D(t, level, fmt, w, h, border, format, type, d);
+            uploadBytes += n;
+        } break;
+        case Op::ReadPixels: {
+            const GLint x = get<GLint>(), y = get<GLint>(); const GLsizei w = get<GLsizei>(), h = get<GLsizei>();
+            const GLenum format = get<GLenum>(), type = get<GLenum>();
+            const bool toBuffer = get<uint8_t>() != 0;
+            void* offset = get<void*>();
+            if(!toBuffer) scratch.resize(std::max(scratch.size(), (size_t)w * (size_t)h * 16));   // any format we read
+            glReadPixels(x, y, w, h, format, type, toBuffer ? offset : scratch.data());
+        } break;
+        case Op::MapBufferRange: {
+            const GLenum t = get<GLenum>(); const GLintptr off = get<GLintptr>();
+            const GLsizeiptr len = get<GLsizeiptr>(); const GLbitfield access = get<GLbitfield>();
+            if(void* ptr = glMapBufferRange(t, off, len, access)) maps.push_back({t, ptr});
+        } break;
+        case Op::UnmapBuffer: {
+            const GLenum t = get<GLenum>();
+            size_t n; const uint8_t* d = bytes(n);
+            for(size_t i=0;i<maps.size();++i){
+                if(maps[i].target != t) continue;
+                if(d) std::memcpy(maps[i].ptr, d, n);
+                maps.erase(maps.begin() + (std::ptrdiff_t)i);
+                break;
+            }
+            glUnmapBuffer(t);
+            uploadBytes += n;
+        } break;
+        default:
+            std::fprintf(stderr, "Unknown command %u in recording\n", (unsigned)op);
+            error = true;
+        }
+        if(error){ p = end; return Op::Count; }
+        return op;
+    }
+};
+
+// ------------------------------------------------------------
+// Main
+// ------------------------------------------------------------
+int main(int argc, char** argv){
+    ReplayOptions opts;
+    if(!parseArgs(argc, argv, opts)) return 1;
+
+    std::vector<uint8_t> data;
+    if(std::FILE* f = std::fopen(opts.file, "rb")){
+        uint8_t buf[1 << 16];
+        for(size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) data.insert(data.end(), buf, buf + n);
+        std::fclose(f);
+    } else { std::fprintf(stderr, "Failed to open %s\n", opts.file); return 1; }
+
+    glrec::FileHeader hdr{};
+    if(data.size() < sizeof(hdr)){ std::fprintf(stderr, "%s: not a GL recording\n", opts.file); return 1; }
+    std::memcpy(&hdr, data.data(), sizeof(hdr));
+    if(std::memcmp(hdr.magic, glrec::kMagic, sizeof(glrec::kMagic)) != 0 || hdr.version != glrec::kVersion){
+        std::fprintf(stderr, "%s: not a version %u GL recording\n", opts.file, glrec::kVersion); return 1; }
+    if(hdr.pointerSize != sizeof(void*)){
+        std::fprintf(stderr, "%s: recorded with %u-byte pointers, this build has %zu\n", opts.file, hdr.pointerSize, sizeof(void*)); return 1; }
+    if(hdr.frames == 0){ std::fprintf(stderr, "%s: no complete frames recorded\n", opts.file); return 1; }
+
+    HeadlessContext ctx;
+    if(!ctx.init(hdr.width, hdr.height)) return 1;
+
+    Replayer r;
+    r.defaultFramebuffer = ctx.fbo;
+    r.p = data.data() + sizeof(hdr);
+    r.end = data.data() + data.size();
+
+    // Setup prefix: everything before the first recorded frame
+    const double setupStart = nowSeconds();
+    Op op;
+    while((op = r.step()) != Op::Frame && op != Op::Count) {}
+    if(op != Op::Frame){ std::fprintf(stderr, "%s: truncated before the first frame\n", opts.file); return 1; }
+    glFinish();
+    const long setupCalls = r.calls;
+    std::printf("replay: %s, %dx%d, %u frame(s); setup %ld calls in %.2f ms\n", opts.file, hdr.width, hdr.height,
+                hdr.frames, setupCalls, (nowSeconds() - setupStart) * 1000.0);
+    const uint8_t* body = r.p - sizeof(uint16_t) - sizeof(uint32_t);    // back to the first Frame command
+
+    GpuTimer gpu; gpu.init(8);
+    LatencyHistogram submitMs, frameMs;
+    long frames = 0, bodyCalls = 0;
+    uint64_t bodyUpload = 0;
+    double measuredStart = 0;
+    for(int loop=0; loop < opts.warmup + opts.loops; ++loop){
+        const bool measured = loop >= opts.warmup;
+        if(loop == opts.warmup){ glFinish(); measuredStart = nowSeconds(); }
+        const long calls0 = r.calls; const uint64_t upload0 = r.uploadBytes;
+        r.p = body;
+        double frameStart = -1, submitEnd = 0;
+        auto endFrame = [&](){
+            if(frameStart < 0) return;
+            submitEnd = nowSeconds();
+            gpu.mark("frame");
+            gpu.endFrame();
+            if(opts.sync) glFinish();
+            if(measured){
+                submitMs.record((submitEnd - frameStart) * 1000.0);
+                frameMs.record((nowSeconds() - frameStart) * 1000.0);
+                ++frames;
+            }
+        };
+        for(;;){
+            const Op o = r.step();
+            if(o == Op::Count) break;
+            if(o != Op::Frame) continue;
+            endFrame();
+            frameStart = nowSeconds();
+            gpu.beginFrame();
+        }
+        endFrame();
+        if(r.error){ std::fprintf(stderr, "%s: truncated or corrupt recording\n", opts.file); return 1; }
+        if(measured){ bodyCalls += r.calls - calls0; bodyUpload += r.uploadBytes - upload0; }
+    }
+    glFinish();
+    const double wall = nowSeconds() - measuredStart;
+
+    const double n = (double)std::max(frames, 1L);
+    std::printf("  %ld frames replayed in %.3f s: %.3f ms/frame, %.0f calls/frame, %.1f KB uploaded/frame%s\n",
+                frames, wall, wall * 1000.0 / n, (double)bodyCalls / n, (double)bodyUpload / n / 1024.0,
+                opts.sync ? " (synchronous)" : "");
+    std::printf("  ms          p50      p90      p99      max     mean\n");
+    auto row = [](const char* name, const LatencyHistogram& h){
+        std::printf("  %-8s %7.3f  %7.3f  %7.3f  %7.3f  %7.3f\n", name, h.percentile(0.5), h.percentile(0.9),
+                    h.percentile(0.99), h.maxMs(), h.meanMs());
+    };
+    row("submit", submitMs);
+    row("frame", frameMs);
+    for(const GpuTimer::Pass& pass : gpu.averages())
+        std::printf("  gpu      %.3f ms/frame avg (timestamp queries, warm-up included)\n", pass.ms);
+
+    if(opts.screenshot){
+        glBindFramebuffer(GL_FRAMEBUFFER, ctx.fbo);
+        if(writeFramebufferPPM(opts.screenshot, hdr.width, hdr.height)) std::printf("Saved %s\n", opts.screenshot);
+    }
+    gpu.destroy();
+    ctx.destroy();
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include "skeleton.h"
+#include "profiler.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+// ------------------------------------------------------------
+// Bones / Skeleton
+// ------------------------------------------------------------
+int Skeleton::addBone(int parent, glm::vec3 bindOffset, float length){
+    Bone b{}; b.parent = parent; b.bindOffset = bindOffset; b.eulerDeg = glm::vec3(0); b.length = length; b.global = glm::mat4(1);
+    bones.push_back(b);
+    return (int)bones.size()-1;
+}
+
+glm::mat4 Skeleton::rotXYZ(const glm::vec3& deg){
+    glm::vec3 r = glm::radians(deg);
+    glm::mat4 Rx = glm::rotate(glm::mat4(1), r.x, {1,0,0});
+    glm::mat4 Ry = glm::rotate(glm::mat4(1), r.y, {0,1,0});
+    glm::mat4 Rz = glm::rotate(glm::mat4(1), r.z, {0,0,1});
+    return Rz * Ry * Rx; // XYZ intrinsic
+}
+
+void Skeleton::updateGlobals(){
+    for(size_t i=0;i<bones.size();++i){
+        const int p = bones[i].parent;
+        glm::mat4 T = glm::translate(glm::mat4(1), bones[i].bindOffset);
+        glm::mat4 R = rotXYZ(bones[i].eulerDeg);
+        glm::mat4 local = T * R;
+        bones[i].global = (p >= 0) ? bones[p].global * local : local;
+    }
+}
+
+Skeleton makeHuman() {
+    Skeleton s;
+    // Reference scale ~1.8 m tall stick figure, Y is up.
+    const float pelvisH = 1.0f;     // baseline hip height
+    const float spineLen = 0.4f;    // spine
+    const float neckLen  = 0.1f;
+    const float headLen  = 0.22f;
+
+    const float upperLeg = 0.45f, lowerLeg = 0.45f, footLen = 0.18f;
+    const float upperArm = 0.30f, lowerArm = 0.30f, handLen = 0.12f;
+    const float hipWidth = 0.18f, shoulderWidth = 0.28f;
+
+    // ------------------------------------------------------------
+    // Root pelvis center — raised high so "middle line" starts above hips
+    // ------------------------------------------------------------
+    int root = s.addBone(-1, {0, pelvisH + 0.30f, 0}, 0.0f);   // pelvis center (much higher)
+    int spine = s.addBone(root, {0, 0.0f, 0}, spineLen);
+    int neck  = s.addBone(spine, {0, spineLen, 0}, neckLen);
+    int head  = s.addBone(neck,  {0, neckLen, 0}, headLen);
+
+    // ------------------------------------------------------------
+    // Legs — attach far below pelvis so torso line clearly above them
+    // ------------------------------------------------------------
+    int hipL = s.addBone(root, {+hipWidth * 0.5f, -0.30f, 0}, upperLeg);
+    int kneeL = s.addBone(hipL, {0, -upperLeg, 0}, lowerLeg);
+    int ankleL = s.addBone(kneeL, {0, -lowerLeg, 0}, footLen);
+
+    int hipR = s.addBone(root, {-hipWidth * 0.5f, -0.30f, 0}, upperLeg);
+    int kneeR = s.addBone(hipR, {0, -upperLeg, 0}, lowerLeg);
+    int ankleR = s.addBone(kneeR, {0, -lowerLeg, 0}, footLen);
+
+    // ------------------------------------------------------------
+    // Arms — attach at shoulder level
+    // ------------------------------------------------------------
+    int shoulderL = s.addBone(spine, {+shoulderWidth * 0.5f, spineLen, 0}, upperArm);
+    int elbowL = s.addBone(shoulderL, {0, -upperArm, 0}, lowerArm);
+    int wristL = s.addBone(elbowL, {0, -lowerArm, 0}, handLen);
+
+    int shoulderR = s.addBone(spine, {-shoulderWidth * 0.5f, spineLen, 0}, upperArm);
+    int elbowR = s.addBone(shoulderR, {0, -upperArm, 0}, lowerArm);
+    int wristR = s.addBone(elbowR, {0, -lowerArm, 0}, handLen);
+
+    (void)ankleL; (void)wristL; (void)wristR;
+    return s;
+}
+
+// ------------------------------------------------------------
+// Geometry helpers
+// ------------------------------------------------------------
+glm::vec3 jointPos(const Bone& b){ return glm::vec3(b.global[3]); }
+glm::vec3 endpointPos(const Bone& b){
+    glm::vec4 p = b.global * glm::vec4(0, -b.length, 0, 1);
+    return glm::vec3(p);
+}
+
+void appendLine(std::vector<LineVertex>& v, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c){
+    v.push_back({a,c}); v.push_back({b,c});
+}
+
+// Ground grid (XZ)
+void appendGroundGrid(std::vector<LineVertex>& v){
+    const float G = 2.0f; int N = 20;
+    for(int i=-N;i<=N;++i){
+        float t = (i%5==0)? 0.2f:0.08f;
+        glm::vec3 c(t,t,t);
+        appendLine(v, { (float)i*0.1f, 0, -G }, {(float)i*0.1f, 0, +G}, c);
+        appendLine(v, { -G, 0, (float)i*0.1f }, { +G, 0, (float)i*0.1f }, c);
+    }
+}
+
+void appendBoneLines(const Skeleton& s, std::vector<LineVertex>& v){
+    const glm::vec3 boneColor(1.0f, 0.9f, 0.4f);
+
+    for (size_t i = 0; i < s.bones.size(); ++i) {
+        const auto& b = s.bones[i];
+        // skip invisible or placeholder bones
+        if (b.length <= 0.001f) continue; // pelvis root
+        if (i == 0) continue;             // explicitly skip root bone
+        if (i == 3) continue;             // skip head bone (sphere)
+        glm::vec3 a = jointPos(b);
+        glm::vec3 e = endpointPos(b);
+        appendLine(v, a, e, boneColor);
+    }
+}
+
+std::vector<LineVertex> buildSkeletonLines(const Skeleton& s){
+    PROFILE_ZONE("buildSkeletonLines");
+    std::vector<LineVertex> v; v.reserve(s.bones.size()*2 + 200);
+    appendBoneLines(s, v);
+    appendGroundGrid(v);
+    return v;
+}
+
+std::vector<TriVertex> buildHeadSphereTris(const Skeleton& s, int stacks, int slices){
+    PROFILE_ZONE("buildHeadSphereTris");
+    std::vector<TriVertex> tris;
+    if (s.bones.size() <= (size_t)kHeadBone) return tris;
+    const glm::vec3 headColor(0.95f, 0.75f, 0.25f);
+
+    const Bone& head = s.bones[(size_t)kHeadBone];
+
+    // Neck joint = base of the head
+    glm::vec3 neckBase = jointPos(head);
+
+    // Sphere radius proportional to head bone length
+    float radius = head.length * 0.6f;
+
+    // "Up" direction of the head in world space (its +Y axis)
+    glm::vec3 up = glm::normalize(glm::vec3(head.global * glm::vec4(0,1,0,0)));
+
+    // Place the sphere so its bottom touches the neck base:
+    // center = neckBase + up * radius
+    glm::vec3 center = neckBase + up * radius;
+
+    // UV-sphere triangulation
+    std::vector<glm::vec3> ring((size_t)(slices+1));
+    std::vector<glm::vec3> prev;
+    for(int i=0;i<=stacks;i++){
+        float v = (float)i / (float)stacks;         // [0,1]
+        float phi = v * glm::pi<float>();           // [0,pi]
+        float sy = std::cos(phi);                   // y on unit sphere
+        float sr = std::sin(phi);                   // ring radius
+        for(int j=0;j<=slices;j++){
+            float u = (float)j / (float)slices;     // [0,1]
+            float theta = u * glm::two_pi<float>(); // [0,2pi]
+            float sx = sr * std::cos(theta);
+            float sz = sr * std::sin(theta);
+            // Build in the head's local axes: use head.global's basis
+            glm::vec3 X = glm::normalize(glm::vec3(head.global * glm::vec4(1,0,0,0)));
+            glm::vec3 Y = up; // already normalized
+            glm::vec3 Z = glm::normalize(glm::vec3(head.global * glm::vec4(0,0,1,0)));
+            ring[(size_t)j] = center + radius*(sx*X + sy*Y + sz*Z);
+        }
+        if(i==0){ prev = ring; continue; }
+        for(int j=0;j<slices;j++){
+            glm::vec3 p00 = prev[(size_t)j];
+            glm::vec3 p01 = prev[(size_t)(j+1)];
+            glm::vec3 p10 = ring[(size_t)j];
+            glm::vec3 p11 = ring[(size_t)(j+1)];
+
+            tris.push_back({p00, headColor});
+            tris.push_back({p10, headColor});
+            tris.push_back({p11, headColor});
+
+            tris.push_back({p00, headColor});
+            tris.push_back({p11, headColor});
+            tris.push_back({p01, headColor});
+        }
+        prev = ring;
+    }
+    return tris;
+}
+
+// ------------------------------------------------------------
+// Animation
+// ------------------------------------------------------------
+void poseWalk(Skeleton& s, float t){
+    float walkSpeed = 1.6f; // steps per second
+    float phase = t * walkSpeed * glm::two_pi<float>();
+
+    auto setR = [&](int idx, float rx, float ry, float rz){ s.bones[idx].eulerDeg = {rx, ry, rz}; };
+
+    const int root=0, spine=1, neck=2, head=3;
+    int hipL=4, kneeL=5, ankleL=6; int hipR=7, kneeR=8, ankleR=9;
+    int shoulderL=10, elbowL=11, wristL=12; int shoulderR=13, elbowR=14, wristR=15;
+
+    setR(root, 0.0f, 0.0f, 3.0f * std::sin(phase*0.5f));
+
+    setR(spine, 5.0f*std::sin(phase*0.5f), 0.0f, 0.0f);
+    setR(neck, -3.0f*std::sin(phase*0.5f), 0.0f, 0.0f);
+    setR(head, 2.0f*std::sin(phase*0.5f), 0.0f, 0.0f);
+
+    float hipSwing = 30.0f * std::sin(phase);
+    float kneeFlex = 25.0f * std::max(0.0f, std::sin(phase));
+
+    setR(hipL,  hipSwing,  0, 0);
+    setR(kneeL, -kneeFlex, 0, 0);
+    setR(ankleL, 5.0f*std::sin(phase+0.4f), 0, 0);
+
+    setR(hipR, -hipSwing,  0, 0);
+    setR(kneeR, -25.0f * std::max(0.0f, std::sin(phase+glm::pi<float>())), 0, 0);
+    setR(ankleR, 5.0f*std::sin(phase+glm::pi<float>()+0.4f), 0, 0);
+
+    float armSwing = 35.0f * std::sin(phase + glm::pi<float>());
+    float elbowFlex = 10.0f * std::max(0.0f, std::sin(phase + glm::pi<float>()));
+
+    setR(shoulderL,  armSwing, 0, 0);
+    setR(elbowL,    -elbowFlex,0,0);
+    setR(wristL,     5.0f*std::sin(phase+1.0f),0,0);
+
+    setR(shoulderR, -armSwing, 0, 0);
+    setR(elbowR,    -10.0f * std::max(0.0f, std::sin(phase)), 0, 0);
+    setR(wristR,     5.0f*std::sin(phase+glm::pi<float>()+1.0f),0,0);
+}
+
+void animateWalk(Skeleton& s, float t){
+    poseWalk(s, t);
+    s.updateGlobals();
+}
@@ -0,0 +1,61 @@
+// Skeleton hierarchy, walk animation and CPU geometry builders.
+// No OpenGL here: everything in this module only needs GLM.
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// ------------------------------------------------------------
+// Bones / Skeleton
+// ------------------------------------------------------------
+struct Bone {
+    int parent;                 // -1 for root
+    glm::vec3 bindOffset;       // from parent to this joint in bind pose
+    glm::vec3 eulerDeg;         // current local rotation (XYZ degrees)
+    float length;               // bone visual length (for child end)
+    glm::mat4 global;           // world-space transform of this joint
+};
+
+struct Skeleton {
+    std::vector<Bone> bones;
+
+    int addBone(int parent, glm::vec3 bindOffset, float length);
+    static glm::mat4 rotXYZ(const glm::vec3& deg);
+    void updateGlobals();
+};
+
+// Index of the head bone in makeHuman(); drawn as a sphere, not a line
+constexpr int kHeadBone = 3;
+
+// Build a very small human-like hierarchy
+Skeleton makeHuman();
+
+// ------------------------------------------------------------
+// Geometry helpers
+// ------------------------------------------------------------
+struct LineVertex{ glm::vec3 pos; glm::vec3 col; };
+struct TriVertex { glm::vec3 pos; glm::vec3 col; };
+
+glm::vec3 jointPos(const Bone& b);
+glm::vec3 endpointPos(const Bone& b);
+
+void appendLine(std::vector<LineVertex>& v, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+void appendGroundGrid(std::vector<LineVertex>& v);
+
+// One line per visible bone (no grid)
+void appendBoneLines(const Skeleton& s, std::vector<LineVertex>& v);
+
+// Build all skeleton lines (skip zero-length bones like pelvis) plus the ground grid
+std::vector<LineVertex> buildSkeletonLines(const Skeleton& s);
+
+// Build a UV-sphere (triangles) centered at the head center
+std::vector<TriVertex> buildHeadSphereTris(const Skeleton& s, int stacks=16, int slices=24);
+
+// ------------------------------------------------------------
+// Animation
+// ------------------------------------------------------------
+// Sets the walk-cycle local rotations at time t (globals are left stale)
+void poseWalk(Skeleton& s, float t);
+// poseWalk followed by updateGlobals
+void animateWalk(Skeleton& s, float t);
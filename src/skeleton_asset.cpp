@@ -0,0 +1,357 @@
+#include "skeleton_asset.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ------------------------------------------------------------
+// Checksum
+// ------------------------------------------------------------
+// Four independent multiply-rotate lanes over 8-byte words, so it runs at
+// memory speed rather than one dependent multiply per byte; fed in pieces
+// by the writer (which re-reads the file) and in one go by the reader.
+namespace {
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull, kPrime2 = 0xC2B2AE3D27D4EB4Full;
+inline uint64_t rotl(uint64_t v, int r){ return (v << r) | (v >> (64 - r)); }
+
+struct Checksum {
+    uint64_t lane[4];
+    unsigned char tail[32];
+    size_t tailSize = 0;
+    uint64_t total = 0;
+
+    explicit Checksum(uint64_t seed) : lane{seed + kPrime1, seed ^ kPrime2, seed - kPrime1, ~seed} {}
+
+    void block(const unsigned char* p){
+        for(int l=0;l<4;++l){
+            uint64_t w; std::memcpy(&w, p + 8*l, 8);
+            lane[l] = rotl(lane[l] ^ (w * kPrime2), 31) * kPrime1;
+        }
+    }
+    void update(const unsigned char* p, size_t n){
+        total += n;
+        if(tailSize){
+            const size_t take = std::min(n, sizeof(tail) - tailSize);
+            std::memcpy(tail + tailSize, p, take);
+            tailSize += take; p += take; n -= take;
+            if(tailSize < sizeof(tail)) return;
+            block(tail); tailSize = 0;
+        }
+        for(; n >= 32; p += 32, n -= 32) block(p);
+        std::memcpy(tail, p, n); tailSize = n;
+    }
+    uint64_t digest() const {
+        uint64_t h = rotl(lane[0], 1) + rotl(lane[1], 7) + rotl(lane[2], 12) + rotl(lane[3], 18) + total;
+        for(size_t i=0;i<tailSize;++i) h = (h ^ tail[i]) * 0x100000001B3ull;
+        h ^= h >> 33; h *= kPrime2; h ^= h >> 29;
+        return h;
+    }
+};
+}
+
+uint64_t assetChecksum(const unsigned char* data, size_t size, uint64_t seed){
+    Checksum c(seed);
+    c.update(data, size);
+    return c.digest();
+}
+
+// ------------------------------------------------------------
+// Views
+// ------------------------------------------------------------
+Skeleton SkeletonView::toSkeleton() const {
+    Skeleton s;
+    s.bones.reserve(boneCount);
+    for(uint32_t i=0;i<boneCount;++i)
+        s.addBone(parents[i], glm::vec3(bindOffsets[3*i], bindOffsets[3*i + 1], bindOffsets[3*i + 2]), lengths[i]);
+    return s;
+}
+
+void ClipView::apply(Skeleton& s, float t) const {
+    float ft = std::fmod(t * frameRate, (float)frameCount);
+    if(ft < 0) ft += (float)frameCount;
+    const uint32_t f0 = std::min((uint32_t)ft, frameCount - 1), f1 = (f0 + 1) % frameCount;
+    const float a = ft - (float)f0;
+    const float* r0 = rotations + (size_t)f0 * boneCount * 3;
+    const float* r1 = rotations + (size_t)f1 * boneCount * 3;
+    const size_t n = std::min<size_t>(boneCount, s.bones.size());
+    for(size_t b=0;b<n;++b){
+        for(int k=0;k<3;++k){
+            float d = r1[3*b + k] - r0[3*b + k];            // the short way round
+            d -= 360.0f * std::floor((d + 180.0f) / 360.0f);
+            s.bones[b].eulerDeg[k] = r0[3*b + k] + d * a;
+        }
+    }
+    if(rootPositions && n > 0){
+        const float* p0 = rootPositions + (size_t)f0 * 3;
+        const float* p1 = rootPositions + (size_t)f1 * 3;
+        s.bones[0].bindOffset = glm::mix(glm::vec3(p0[0], p0[1], p0[2]), glm::vec3(p1[0], p1[1], p1[2]), a);
+    }
+}
+
+// ------------------------------------------------------------
+// Reading
+// ------------------------------------------------------------
+bool AssetFile::init(const char* path, bool verifyChecksum){
+    destroy();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE){ std::fprintf(stderr, "Failed to open %s\n", path); return false; }
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(file, &fileSize);
+    size = (size_t)fileSize.QuadPart;
+    HANDLE map = size ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if(map) data = (const unsigned char*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if(!data){
+        if(map) CloseHandle(map);
+        std::fprintf(stderr, "%s: cannot be mapped\n", path); size = 0; return false; }
+    mapping = map;
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if(fd < 0){ std::fprintf(stderr, "Failed to open %s\n", path); return false; }
+    struct stat st{};
+    if(fstat(fd, &st) != 0 || st.st_size <= 0){
+        ::close(fd); std::fprintf(stderr, "%s: empty or unreadable\n", path); return false; }
+    size = (size_t)st.st_size;
+    void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);                                        // the mapping keeps the file
+    if(p == MAP_FAILED){ std::fprintf(stderr, "%s: cannot be mapped\n", path); size = 0; return false; }
+    data = (const unsigned char*)p;
+#endif
+    if(!validate(path, verifyChecksum)){ destroy(); return false; }
+    return true;
+}
+
+void AssetFile::destroy(){
+    if(!data) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mapping);
+#else
+    munmap(const_cast<unsigned char*>(data), size);
+#endif
+    data = nullptr; size = 0; mapping = nullptr;
+}
+
+// Array of n1 * n2 elements of elemSize bytes at off lies inside [0, fileSize), aligned
+static bool arrayOk(uint64_t off, uint64_t n1, uint64_t n2, uint64_t elemSize, uint64_t fileSize){
+    if(off % kAssetAlign != 0 || off > fileSize) return false;
+    const uint64_t room = (fileSize - off) / elemSize;
+    if(n2 && n1 > room / n2) return false;
+    return true;
+}
+
+bool AssetFile::validate(const char* path, bool verifyChecksum) const {
+    auto bad = [&](const char* what){ std::fprintf(stderr, "%s: %s\n", path, what); return false; };
+    if(size < sizeof(AssetHeader)) return bad("not a skeleton asset");
+    const AssetHeader& h = header();
+    if(std::memcmp(h.magic, kAssetMagic, sizeof(kAssetMagic)) != 0) return bad("not a skeleton asset");
+    if(h.version != kAssetVersion){
+        std::fprintf(stderr, "%s: asset version %u, this build reads %u\n", path, h.version, kAssetVersion); return false; }
+    if(h.byteOrder != kAssetByteOrder) return bad("written with a different byte order");
+    if(h.fileSize != size) return bad("truncated (size does not match the header)");
+    if(!arrayOk(h.strings, h.stringsSize, 1, 1, size) || h.stringsSize == 0 || data[h.strings + h.stringsSize - 1] != 0)
+        return bad("corrupt string table");
+    if(!arrayOk(h.skeletonTable, h.skeletonCount, 1, sizeof(AssetSkeletonRecord), size) ||
+       !arrayOk(h.clipTable, h.clipCount, 1, sizeof(AssetClipRecord), size))
+        return bad("corrupt record tables");
+    if(verifyChecksum && assetChecksum(data + sizeof(AssetHeader), size - sizeof(AssetHeader)) != h.checksum)
+        return bad("checksum mismatch");
+
+    const AssetSkeletonRecord* skels = reinterpret_cast<const AssetSkeletonRecord*>(data + h.skeletonTable);
+    for(uint32_t i=0;i<h.skeletonCount;++i){
+        const AssetSkeletonRecord& r = skels[i];
+        if(r.name >= h.stringsSize || r.boneCount == 0 ||
+           !arrayOk(r.parents, r.boneCount, 1, sizeof(int32_t), size) ||
+           !arrayOk(r.bindOffsets, r.boneCount, 3, sizeof(float), size) ||
+           !arrayOk(r.lengths, r.boneCount, 1, sizeof(float), size) ||
+           !arrayOk(r.boneNames, r.boneCount, 1, sizeof(uint32_t), size))
+            return bad("corrupt skeleton record");
+        // Parents before children is what lets updateGlobals run in one pass
+        const int32_t* parents = reinterpret_cast<const int32_t*>(data + r.parents);
+        const uint32_t* names = reinterpret_cast<const uint32_t*>(data + r.boneNames);
+        for(uint32_t b=0;b<r.boneCount;++b)
+            if(parents[b] < -1 || parents[b] >= (int32_t)b || names[b] >= h.stringsSize)
+                return bad("corrupt skeleton hierarchy");
+    }
+    const AssetClipRecord* clips = reinterpret_cast<const AssetClipRecord*>(data + h.clipTable);
+    for(uint32_t i=0;i<h.clipCount;++i){
+        const AssetClipRecord& r = clips[i];
+        if(r.name >= h.stringsSize || r.skeleton >= h.skeletonCount || r.frameCount == 0 ||
+           !(r.frameRate > 0 && std::isfinite(r.frameRate)))
+            return bad("corrupt clip record");
+        const uint64_t bones = skels[r.skeleton].boneCount;
+        if(!arrayOk(r.rotations, r.frameCount, bones * 3, sizeof(float), size) ||
+           (r.rootPositions && !arrayOk(r.rootPositions, r.frameCount, 3, sizeof(float), size)))
+            return bad("corrupt clip tracks");
+    }
+    return true;
+}
+
+SkeletonView AssetFile::skeleton(uint32_t i) const {
+    const AssetHeader& h = header();
+    const AssetSkeletonRecord& r = reinterpret_cast<const AssetSkeletonRecord*>(data + h.skeletonTable)[i];
+    const char* strings = reinterpret_cast<const char*>(data + h.strings);
+    return {strings + r.name, r.boneCount,
+            reinterpret_cast<const int32_t*>(data + r.parents),
+            reinterpret_cast<const float*>(data + r.bindOffsets),
+            reinterpret_cast<const float*>(data + r.lengths),
+            reinterpret_cast<const uint32_t*>(data + r.boneNames), strings};
+}
+
+ClipView AssetFile::clip(uint32_t i) const {
+    const AssetHeader& h = header();
+    const AssetClipRecord& r = reinterpret_cast<const AssetClipRecord*>(data + h.clipTable)[i];
+    return {reinterpret_cast<const char*>(data + h.strings) + r.name, r.skeleton, skeleton(r.skeleton).boneCount,
+            r.frameCount, r.frameRate,
+            reinterpret_cast<const float*>(data + r.rotations),
+            r.rootPositions ? reinterpret_cast<const float*>(data + r.rootPositions) : nullptr};
+}
+
+int AssetFile::findSkeleton(const char* name) const {
+    for(uint32_t i=0;i<skeletonCount();++i) if(std::strcmp(skeleton(i).name, name) == 0) return (int)i;
+    return -1;
+}
+
+int AssetFile::findClip(const char* name) const {
+    for(uint32_t i=0;i<clipCount();++i) if(std::strcmp(clip(i).name, name) == 0) return (int)i;
+    return -1;
+}
+
+// ------------------------------------------------------------
+// Writing
+// ------------------------------------------------------------
+bool AssetWriter::init(const char* p){
+    path = p;
+    f = std::fopen(p, "w+b");
+    if(!f){ std::fprintf(stderr, "Failed to open %s for writing\n", p); return false; }
+    const AssetHeader placeholder{};
+    write(&placeholder, sizeof(placeholder));
+    addString("");                                      // offset 0: the empty name
+    return ok;
+}
+
+void AssetWriter::write(const void* p, size_t n){
+    if(n && std::fwrite(p, 1, n, f) != n) ok = false;
+    offset += n;
+}
+
+uint64_t AssetWriter::alignTo(size_t a){
+    static const unsigned char zeros[kAssetAlign] = {};
+    const size_t pad = (size_t)((a - offset % a) % a);
+    write(zeros, pad);
+    return offset;
+}
+
+uint32_t AssetWriter::addString(const char* s){
+    const uint32_t at = (uint32_t)strings.size();
+    strings.append(s);
+    strings.push_back('\0');
+    return at;
+}
+
+uint32_t AssetWriter::addSkeleton(const char* name, const Skeleton& s, const std::vector<std::string>* boneNames){
+    AssetSkeletonRecord r{};
+    r.name = addString(name);
+    r.boneCount = (uint32_t)s.bones.size();
+    r.parents = alignTo(kAssetAlign);
+    for(const Bone& b : s.bones){ const int32_t p = b.parent; write(&p, sizeof(p)); }
+    r.bindOffsets = alignTo(kAssetAlign);
+    for(const Bone& b : s.bones) write(&b.bindOffset[0], 3 * sizeof(float));
+    r.lengths = alignTo(kAssetAlign);
+    for(const Bone& b : s.bones) write(&b.length, sizeof(float));
+    r.boneNames = alignTo(kAssetAlign);
+    for(uint32_t i=0;i<r.boneCount;++i){
+        char fallback[32];
+        std::snprintf(fallback, sizeof(fallback), "bone%u", i);
+        const uint32_t at = addString(boneNames && i < boneNames->size() ? (*boneNames)[i].c_str() : fallback);
+        write(&at, sizeof(at));
+    }
+    skeletons.push_back(r);
+    return (uint32_t)skeletons.size() - 1;
+}
+
+void AssetWriter::beginClip(const char* name, uint32_t skeleton, float frameRate, bool hasRootPositions){
+    AssetClipRecord r{};
+    r.name = addString(name);
+    r.skeleton = skeleton;
+    r.frameRate = frameRate;
+    r.rotations = alignTo(kAssetAlign);
+    clips.push_back(r);
+    inClip = true;
+    if(hasRootPositions && !(rootTmp = std::tmpfile())) ok = false;
+}
+
+void AssetWriter::addFrame(const float* eulerDeg, const float* rootPosition){
+    AssetClipRecord& r = clips.back();
+    write(eulerDeg, (size_t)skeletons[r.skeleton].boneCount * 3 * sizeof(float));
+    if(rootTmp){
+        const float zero[3] = {};
+        if(std::fwrite(rootPosition ? rootPosition : zero, sizeof(float), 3, rootTmp) != 3) ok = false;
+    }
+    ++r.frameCount;
+}
+
+void AssetWriter::endClip(){
+    if(!inClip) return;
+    inClip = false;
+    if(!rootTmp) return;
+    clips.back().rootPositions = alignTo(kAssetAlign);
+    std::rewind(rootTmp);
+    unsigned char buf[1 << 16];
+    for(size_t n; (n = std::fread(buf, 1, sizeof(buf), rootTmp)) > 0;) write(buf, n);
+    std::fclose(rootTmp);
+    rootTmp = nullptr;
+}
+
+bool AssetWriter::finish(){
+    if(!f) return false;
+    endClip();
+    AssetHeader h{};
+    std::memcpy(h.magic, kAssetMagic, sizeof(h.magic));
+    h.version = kAssetVersion;
+    h.byteOrder = kAssetByteOrder;
+    h.skeletonCount = (uint32_t)skeletons.size();
+    h.clipCount = (uint32_t)clips.size();
+    h.skeletonTable = alignTo(kAssetAlign);
+    write(skeletons.data(), skeletons.size() * sizeof(AssetSkeletonRecord));
+    h.clipTable = alignTo(kAssetAlign);
+    write(clips.data(), clips.size() * sizeof(AssetClipRecord));
+    h.strings = alignTo(kAssetAlign);
+    h.stringsSize = strings.size();
+    write(strings.data(), strings.size());
+    h.fileSize = offset;
+
+    // Checksum what was streamed out, re-reading it in pieces
+    Checksum c(0);
+    if(std::fflush(f) != 0 || std::fseek(f, (long)sizeof(AssetHeader), SEEK_SET) != 0) ok = false;
+    unsigned char buf[1 << 16];
+    for(size_t n; ok && (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) c.update(buf, n);
+    if(c.total != h.fileSize - sizeof(AssetHeader)) ok = false;
+    h.checksum = c.digest();
+    if(std::fseek(f, 0, SEEK_SET) != 0 || std::fwrite(&h, sizeof(h), 1, f) != 1) ok = false;
+    if(std::fclose(f) != 0) ok = false;
+    f = nullptr;
+    if(!ok){ std::fprintf(stderr, "Failed to write %s\n", path.c_str()); std::remove(path.c_str()); }
+    return ok;
+}
+
+void AssetWriter::abandon(){
+    if(rootTmp){ std::fclose(rootTmp); rootTmp = nullptr; }
+    inClip = false;
+    if(!f) return;
+    std::fclose(f);
+    f = nullptr;
+    std::remove(path.c_str());
+}
@@ -0,0 +1,164 @@
+// Memory-mappable binary assets: skeletons and animation clips.
+//
+// A file is mapped read-only and used in place: AssetFile::init() checks the
+// header, bounds-checks every table entry and array (and, by default, the
+// checksum), and then hands out views that point straight into the mapping.
+// Nothing is parsed or allocated per element, and processes that map the
+// same file share its pages.
+//
+// Layout (little-endian as written, all arrays 16-byte aligned):
+//   AssetHeader                         magic "SKASSET1", version, sizes, offsets
+//   arrays                              parents, bind offsets, bone lengths and
+//                                       bone name offsets per skeleton; Euler
+//                                       rotations and root positions per clip
+//   AssetSkeletonRecord[skeletonCount]  offsets of each skeleton's arrays
+//   AssetClipRecord[clipCount]          offsets of each clip's tracks
+//   strings                             NUL-terminated names, by byte offset
+// Clip tracks are frame-major: frame f holds boneCount XYZ Euler angles in
+// degrees (Bone::eulerDeg) and, optionally, the root's position, so sampling
+// reads two adjacent frames. The checksum covers every byte after the header.
+//
+// AssetWriter streams: skeletons and clip frames go to the file as they are
+// added and only the tables and names wait for finish(), so writing an hour
+// of capture needs one frame of memory.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "skeleton.h"
+
+constexpr char kAssetMagic[8] = {'S','K','A','S','S','E','T','1'};
+constexpr uint32_t kAssetVersion = 1;
+constexpr uint32_t kAssetByteOrder = 0x01020304u;
+constexpr size_t kAssetAlign = 16;
+
+struct AssetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;                 // kAssetByteOrder as the writer saw it
+    uint64_t fileSize;
+    uint64_t checksum;                  // assetChecksum() of bytes [sizeof(AssetHeader), fileSize)
+    uint32_t skeletonCount, clipCount;
+    uint64_t skeletonTable, clipTable;  // byte offsets
+    uint64_t strings, stringsSize;
+};
+static_assert(sizeof(AssetHeader) == 72, "AssetHeader layout");
+
+struct AssetSkeletonRecord {
+    uint32_t name;                      // string offset
+    uint32_t boneCount;
+    uint64_t parents;                   // int32[boneCount], parent < index, root -1
+    uint64_t bindOffsets;               // float[boneCount * 3]
+    uint64_t lengths;                   // float[boneCount]
+    uint64_t boneNames;                 // uint32[boneCount] string offsets
+    uint64_t reserved;
+};
+static_assert(sizeof(AssetSkeletonRecord) == 48, "AssetSkeletonRecord layout");
+
+struct AssetClipRecord {
+    uint32_t name;
+    uint32_t skeleton;                  // index into the skeleton table
+    uint32_t frameCount;
+    float frameRate;                    // frames per second
+    uint64_t rotations;                 // float[frameCount * boneCount * 3]
+    uint64_t rootPositions;             // float[frameCount * 3], 0 if none
+    uint64_t reserved[2];
+};
+static_assert(sizeof(AssetClipRecord) == 48, "AssetClipRecord layout");
+
+uint64_t assetChecksum(const unsigned char* data, size_t size, uint64_t seed = 0);
+
+// ------------------------------------------------------------
+// Reading
+// ------------------------------------------------------------
+// Views into a mapped file; valid until the AssetFile is destroyed
+struct SkeletonView {
+    const char* name;
+    uint32_t boneCount;
+    const int32_t* parents;
+    const float* bindOffsets;
+    const float* lengths;
+    const uint32_t* boneNames;
+    const char* strings;
+
+    const char* boneName(uint32_t bone) const { return strings + boneNames[bone]; }
+    Skeleton toSkeleton() const;        // an animatable copy
+};
+
+struct ClipView {
+    const char* name;
+    uint32_t skeleton;
+    uint32_t boneCount;
+    uint32_t frameCount;
+    float frameRate;
+    const float* rotations;
+    const float* rootPositions;         // null if the clip has none
+
+    float duration() const { return frameRate > 0 ? (float)frameCount / frameRate : 0.0f; }
+    // Sets s's local rotations (and root offset) at time t, looping; globals are left stale
+    void apply(Skeleton& s, float t) const;
+};
+
+struct AssetFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    // Maps and validates path; false (with a message) if it is not a usable asset
+    bool init(const char* path, bool verifyChecksum = true);
+    void destroy();
+
+    const AssetHeader& header() const { return *reinterpret_cast<const AssetHeader*>(data); }
+    uint32_t skeletonCount() const { return header().skeletonCount; }
+    uint32_t clipCount() const { return header().clipCount; }
+    SkeletonView skeleton(uint32_t i) const;
+    ClipView clip(uint32_t i) const;
+    int findSkeleton(const char* name) const;   // -1 if absent
+    int findClip(const char* name) const;
+
+private:
+    void* mapping = nullptr;            // platform handle, see skeleton_asset.cpp
+    bool validate(const char* path, bool verifyChecksum) const;
+};
+
+// ------------------------------------------------------------
+// Writing
+// ------------------------------------------------------------
+struct AssetWriter {
+    // Returns false if path cannot be created
+    bool init(const char* path);
+    // Returns the skeleton's index; boneNames may be null or hold one name per bone
+    uint32_t addSkeleton(const char* name, const Skeleton& s, const std::vector<std::string>* boneNames = nullptr);
+    // Clip frames follow one by one; rootPosition may be null if the clip has none
+    void beginClip(const char* name, uint32_t skeleton, float frameRate, bool hasRootPositions);
+    void addFrame(const float* eulerDeg, const float* rootPosition);
+    void endClip();
+    // Writes tables, names and header; false on any I/O error so far, in
+    // which case the file is removed
+    bool finish();
+    // Closes and removes the file without a header, so that a partial write
+    // (a failed import, say) never looks like a complete asset
+    void abandon();
+
+    uint64_t bytesWritten() const { return offset; }
+
+private:
+    std::FILE* f = nullptr;
+    std::string path;
+    uint64_t offset = 0;
+    bool ok = true;
+    std::vector<AssetSkeletonRecord> skeletons;
+    std::vector<AssetClipRecord> clips;
+    std::string strings;
+    // Open clip: frames append to one of two streams, rotations here,
+    // root positions in a temporary file appended at endClip()
+    bool inClip = false;
+    std::FILE* rootTmp = nullptr;
+
+    uint32_t addString(const char* s);
+    uint64_t alignTo(size_t a);
+    void write(const void* p, size_t n);
+};
@@ -0,0 +1,353 @@
+#include "soft_raster.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFT_RASTER_SSE2 1
+#else
+#define SOFT_RASTER_SSE2 0
+#endif
+
+static double msSince(std::chrono::steady_clock::time_point t0){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ------------------------------------------------------------
+// Four lanes of float; lane i is pixel x + i
+// ------------------------------------------------------------
+namespace {
+#if SOFT_RASTER_SSE2
+struct F4 { __m128 v; };
+inline F4 splat(float s){ return {_mm_set1_ps(s)}; }
+inline F4 ramp(float base, float step){ return {_mm_add_ps(_mm_set1_ps(base), _mm_mul_ps(_mm_set1_ps(step), _mm_set_ps(3, 2, 1, 0)))}; }
+inline F4 operator+(F4 a, F4 b){ return {_mm_add_ps(a.v, b.v)}; }
+inline F4 load(const float* p){ return {_mm_loadu_ps(p)}; }
+inline void store(float* p, F4 a){ _mm_storeu_ps(p, a.v); }
+inline int gtMask(F4 a, F4 b){ return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)); }
+inline int ltMask(F4 a, F4 b){ return _mm_movemask_ps(_mm_cmplt_ps(a.v, b.v)); }
+#else
+struct F4 { float v[4]; };
+inline F4 splat(float s){ return {{s, s, s, s}}; }
+inline F4 ramp(float base, float step){ return {{base, base + step, base + 2*step, base + 3*step}}; }
+inline F4 operator+(F4 a, F4 b){ for(int i=0;i<4;++i) a.v[i] += b.v[i]; return a; }
+inline F4 load(const float* p){ return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float* p, F4 a){ std::memcpy(p, a.v, sizeof(a.v)); }
+inline int gtMask(F4 a, F4 b){ int m = 0; for(int i=0;i<4;++i) m |= (a.v[i] > b.v[i]) << i; return m; }
+inline int ltMask(F4 a, F4 b){ int m = 0; for(int i=0;i<4;++i) m |= (a.v[i] < b.v[i]) << i; return m; }
+#endif
+} // namespace
+
+// Screen-space triangle after setup. Edge function i, divided by the signed
+// area, is the barycentric weight of vertex i: e_i(x, y) = a*x + b*y + c.
+struct SoftRasterizer::Tri {
+    float a[3], b[3], c[3];
+    float thr[3];               // e_i > thr: 0, or just below 0 on top-left edges
+    float za, zb, zc;           // window z plane
+    float invW[3];
+    glm::vec3 col[3];
+    int minX, minY, maxX, maxY; // pixel bounds, inclusive, on screen
+};
+
+// ------------------------------------------------------------
+// Worker pool: finish() hands out tiles through an atomic counter
+// ------------------------------------------------------------
+struct SoftRasterizer::Pool {
+    SoftRasterizer* owner = nullptr;
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable wake, done;
+    unsigned generation = 0;
+    int busy = 0;
+    bool quit = false;
+    std::atomic<int> next{0};
+    int tileCount = 0;
+
+    void run(){
+        for(int t; (t = next.fetch_add(1, std::memory_order_relaxed)) < tileCount; ) owner->rasterTile(t);
+    }
+    void worker(){
+        unsigned seen = 0;
+        for(;;){
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake.wait(lock, [&]{ return quit || generation != seen; });
+                if(quit) return;
+                seen = generation;
+            }
+            run();
+            std::lock_guard<std::mutex> lock(m);
+            if(--busy == 0) done.notify_one();
+        }
+    }
+};
+
+SoftRasterizer::SoftRasterizer() = default;
+SoftRasterizer::~SoftRasterizer(){ destroy(); }
+
+bool SoftRasterizer::init(int w, int h, int threadCount){
+    if(w <= 0 || h <= 0){ std::fprintf(stderr, "Soft rasterizer: bad size %dx%d\n", w, h); return false; }
+    destroy();
+    width = w; height = h;
+    tilesX = (w + kTileSize - 1) / kTileSize;
+    tilesY = (h + kTileSize - 1) / kTileSize;
+    depthStride = (w + 3) & ~3;
+    color.assign((size_t)w * (size_t)h * 4, 0);
+    depth.assign((size_t)depthStride * (size_t)h, 1.0f);
+    bins.assign((size_t)tilesX * (size_t)tilesY, {});
+
+    threads = threadCount > 0 ? threadCount : (int)std::max(1u, std::thread::hardware_concurrency());
+    pool = std::make_unique<Pool>();
+    pool->owner = this;
+    for(int i=1;i<threads;++i) pool->workers.emplace_back([p = pool.get()]{ p->worker(); });
+    return true;
+}
+
+void SoftRasterizer::destroy(){
+    if(pool){
+        { std::lock_guard<std::mutex> lock(pool->m); pool->quit = true; }
+        pool->wake.notify_all();
+        for(auto& t : pool->workers) t.join();
+        pool.reset();
+    }
+    tris.clear(); bins.clear();
+}
+
+void SoftRasterizer::clear(const glm::vec3& c, float z){
+    auto b = [](float v){ return (uint32_t)(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    const uint8_t rgba[4] = {(uint8_t)b(c.x), (uint8_t)b(c.y), (uint8_t)b(c.z), 255};
+    std::memcpy(&clearColor, rgba, 4);
+    clearDepth = z;
+    clearPending = true;                // done per tile in finish()
+    tris.clear();
+    for(auto& bin : bins) bin.clear();
+    stats = SoftRasterStats{};
+}
+
+// ------------------------------------------------------------
+// Setup and binning
+// ------------------------------------------------------------
+// Does any pixel centre of the tile at (x0, y0) pass all three edges?
+// Conservative: evaluates each edge at the tile corner it favours most.
+static bool tileOverlaps(const SoftRasterizer::Tri& t, int x0, int y0){
+    const float lo[2] = {(float)x0 + 0.5f, (float)y0 + 0.5f};
+    const float hi[2] = {lo[0] + (SoftRasterizer::kTileSize - 1), lo[1] + (SoftRasterizer::kTileSize - 1)};
+    for(int i=0;i<3;++i){
+        const float e = t.a[i] * (t.a[i] > 0.0f ? hi[0] : lo[0]) + t.b[i] * (t.b[i] > 0.0f ? hi[1] : lo[1]) + t.c[i];
+        if(!(e > t.thr[i])) return false;
+    }
+    return true;
+}
+
+void SoftRasterizer::setup(const glm::vec4 clip[3], const glm::vec3 col[3]){
+    float x[3], y[3];
+    Tri t;
+    for(int i=0;i<3;++i){
+        t.invW[i] = 1.0f / clip[i].w;
+        x[i] = (clip[i].x * t.invW[i] * 0.5f + 0.5f) * (float)width;
+        y[i] = (0.5f - clip[i].y * t.invW[i] * 0.5f) * (float)height;     // top row first
+        t.col[i] = col[i];
+    }
+    const float area = (x[1]-x[0])*(y[2]-y[0]) - (y[1]-y[0])*(x[2]-x[0]);
+    if(!(std::abs(area) > 1e-8f)) return;
+
+    float minx = std::min({x[0], x[1], x[2]}), maxx = std::max({x[0], x[1], x[2]});
+    float miny = std::min({y[0], y[1], y[2]}), maxy = std::max({y[0], y[1], y[2]});
+    // Pixel centres inside the bounds, clamped to the screen
+    t.minX = std::max(0, (int)std::ceil(std::max(minx, -1.0f) - 0.5f));
+    t.maxX = std::min(width - 1, (int)std::floor(std::min(maxx, (float)width + 1.0f) - 0.5f));
+    t.minY = std::max(0, (int)std::ceil(std::max(miny, -1.0f) - 0.5f));
+    t.maxY = std::min(height - 1, (int)std::floor(std::min(maxy, (float)height + 1.0f) - 0.5f));
+    if(t.minX > t.maxX || t.minY > t.maxY) return;
+
+    const float inv = 1.0f / area;
+    for(int i=0;i<3;++i){
+        const int j = (i+1)%3, k = (i+2)%3;          // edge j -> k is opposite vertex i
+        t.a[i] = -(y[k]-y[j]) * inv;
+        t.b[i] =  (x[k]-x[j]) * inv;
+        t.c[i] = ((y[k]-y[j])*x[j] - (x[k]-x[j])*y[j]) * inv;
+        // The normalized gradient points inside: a "left" edge has it pointing
+        // right, a "top" edge (y down) pointing down
+        const bool topLeft = t.a[i] > 0.0f || (t.a[i] == 0.0f && t.b[i] > 0.0f);
+        t.thr[i] = topLeft ? -std::numeric_limits<float>::denorm_min() : 0.0f;
+    }
+    float z[3];
+    for(int i=0;i<3;++i) z[i] = clip[i].z * t.invW[i] * 0.5f + 0.5f;
+    t.za = t.a[0]*z[0] + t.a[1]*z[1] + t.a[2]*z[2];
+    t.zb = t.b[0]*z[0] + t.b[1]*z[1] + t.b[2]*z[2];
+    t.zc = t.c[0]*z[0] + t.c[1]*z[1] + t.c[2]*z[2];
+
+    const uint32_t index = (uint32_t)tris.size();
+    tris.push_back(t);
+    ++stats.triangles;
+    const bool small = t.minX / kTileSize == t.maxX / kTileSize && t.minY / kTileSize == t.maxY / kTileSize;
+    for(int ty = t.minY / kTileSize; ty <= t.maxY / kTileSize; ++ty)
+        for(int tx = t.minX / kTileSize; tx <= t.maxX / kTileSize; ++tx){
+            // Skip tiles entirely outside one edge (long thin lines cross
+            // many tiles of their bounding box without touching them)
+            if(!small && !tileOverlaps(t, tx * kTileSize, ty * kTileSize)) continue;
+            bins[(size_t)(ty * tilesX + tx)].push_back(index);
+            ++stats.binEntries;
+        }
+}
+
+// Clip against the near plane (z > -w); the other planes are handled by
+// clamping to the screen and by the depth test
+void SoftRasterizer::clipAndSetup(const glm::vec4 clip[3], const glm::vec3 col[3]){
+    float d[3]; int inside = 0;
+    for(int i=0;i<3;++i){ d[i] = clip[i].z + clip[i].w; inside += d[i] > 0.0f; }
+    if(inside == 3){ setup(clip, col); return; }
+    if(inside == 0) return;
+
+    glm::vec4 pc[4]; glm::vec3 cc[4]; int n = 0;
+    for(int i=0;i<3;++i){
+        const int j = (i+1)%3;
+        if(d[i] > 0.0f){ pc[n] = clip[i]; cc[n] = col[i]; ++n; }
+        if((d[i] > 0.0f) != (d[j] > 0.0f)){
+            const float s = d[i] / (d[i] - d[j]);
+            pc[n] = glm::mix(clip[i], clip[j], s); cc[n] = glm::mix(col[i], col[j], s); ++n;
+        }
+    }
+    for(int i=1;i+1<n;++i){
+        const glm::vec4 p[3] = {pc[0], pc[i], pc[i+1]};
+        const glm::vec3 c[3] = {cc[0], cc[i], cc[i+1]};
+        setup(p, c);
+    }
+}
+
+void SoftRasterizer::drawTriangles(const TriVertex* v, size_t vertexCount, const glm::mat4& mvp){
+    auto t0 = std::chrono::steady_clock::now();
+    for(size_t i=0;i+2<vertexCount;i+=3){
+        const glm::vec4 clip[3] = {mvp * glm::vec4(v[i].pos, 1.0f), mvp * glm::vec4(v[i+1].pos, 1.0f), mvp * glm::vec4(v[i+2].pos, 1.0f)};
+        const glm::vec3 col[3] = {v[i].col, v[i+1].col, v[i+2].col};
+        clipAndSetup(clip, col);
+    }
+    stats.setupMs += msSince(t0);
+}
+
+// Lines become screen-aligned quads one pixel wide
+void SoftRasterizer::drawLines(const LineVertex* v, size_t vertexCount, const glm::mat4& mvp){
+    auto t0 = std::chrono::steady_clock::now();
+    for(size_t i=0;i+1<vertexCount;i+=2){
+        glm::vec4 p0 = mvp * glm::vec4(v[i].pos, 1.0f), p1 = mvp * glm::vec4(v[i+1].pos, 1.0f);
+        glm::vec3 c0 = v[i].col, c1 = v[i+1].col;
+        const float d0 = p0.z + p0.w, d1 = p1.z + p1.w;
+        if(d0 <= 0.0f && d1 <= 0.0f) continue;
+        if(d0 <= 0.0f){ const float s = d0 / (d0 - d1); p0 = glm::mix(p0, p1, s); c0 = glm::mix(c0, c1, s); }
+        if(d1 <= 0.0f){ const float s = d1 / (d1 - d0); p1 = glm::mix(p1, p0, s); c1 = glm::mix(c1, c0, s); }
+
+        const glm::vec2 s0(p0.x / p0.w * width, p0.y / p0.w * height);
+        const glm::vec2 s1(p1.x / p1.w * width, p1.y / p1.w * height);
+        glm::vec2 dir = s1 - s0;
+        const float len = glm::length(dir);
+        if(len < 1e-6f) continue;
+        dir /= len;
+        // Half a pixel either side: one pixel is 2 / size in NDC, scaled by w back to clip space
+        const glm::vec2 n(-dir.y / (float)width, dir.x / (float)height);
+        const glm::vec4 o0(n * p0.w, 0.0f, 0.0f), o1(n * p1.w, 0.0f, 0.0f);
+        const glm::vec4 q[4] = {p0 - o0, p0 + o0, p1 - o1, p1 + o1};
+        const glm::vec3 a[3] = {c0, c0, c1}, b[3] = {c0, c1, c1};
+        const glm::vec4 t0q[3] = {q[0], q[1], q[2]}, t1q[3] = {q[1], q[3], q[2]};
+        setup(t0q, a);
+        setup(t1q, b);
+    }
+    stats.setupMs += msSince(t0);
+}
+
+// ------------------------------------------------------------
+// Rasterization
+// ------------------------------------------------------------
+void SoftRasterizer::rasterTile(int tile){
+    const int tx0 = (tile % tilesX) * kTileSize, ty0 = (tile / tilesX) * kTileSize;
+    const int tx1 = std::min(tx0 + kTileSize, width) - 1, ty1 = std::min(ty0 + kTileSize, height) - 1;
+
+    if(clearPending)
+        for(int y=ty0;y<=ty1;++y){
+            std::fill(depth.begin() + (std::ptrdiff_t)y*depthStride + tx0, depth.begin() + (std::ptrdiff_t)y*depthStride + tx1 + 1, clearDepth);
+            uint8_t* row = color.data() + ((size_t)y*width + tx0) * 4;
+            for(int x=tx0;x<=tx1;++x, row += 4) std::memcpy(row, &clearColor, 4);
+        }
+
+    for(uint32_t index : bins[(size_t)tile]){
+        const Tri& t = tris[index];
+        const int x0 = std::max(t.minX, tx0), x1 = std::min(t.maxX, tx1);
+        const int y0 = std::max(t.minY, ty0), y1 = std::min(t.maxY, ty1);
+        const F4 thr0 = splat(t.thr[0]), thr1 = splat(t.thr[1]), thr2 = splat(t.thr[2]);
+        const F4 step0 = splat(4*t.a[0]), step1 = splat(4*t.a[1]), step2 = splat(4*t.a[2]), stepZ = splat(4*t.za);
+
+        for(int y=y0;y<=y1;++y){
+            // Span of this row inside all three edges, one pixel of slack;
+            // the per-pixel masks below do the exact test
+            const float py = (float)y + 0.5f;
+            float lo = (float)x0, hi = (float)x1;
+            for(int i=0;i<3;++i){
+                const float k = t.b[i]*py + t.c[i];
+                if(t.a[i] > 0.0f) lo = std::max(lo, -k / t.a[i] - 1.5f);
+                else if(t.a[i] < 0.0f) hi = std::min(hi, -k / t.a[i] + 0.5f);
+                else if(!(k > t.thr[i])) hi = -1.0f;
+            }
+            if(lo > hi) continue;
+            const int xs = (int)lo & ~3, xe = (int)hi;
+            const float px = (float)xs + 0.5f;
+            F4 e0 = ramp(t.a[0]*px + t.b[0]*py + t.c[0], t.a[0]);
+            F4 e1 = ramp(t.a[1]*px + t.b[1]*py + t.c[1], t.a[1]);
+            F4 e2 = ramp(t.a[2]*px + t.b[2]*py + t.c[2], t.a[2]);
+            F4 z  = ramp(t.za*px + t.zb*py + t.zc, t.za);
+            float* drow = depth.data() + (size_t)y*depthStride;
+            uint8_t* crow = color.data() + (size_t)y*width*4;
+
+            for(int x=xs;x<=xe;x+=4, e0 = e0 + step0, e1 = e1 + step1, e2 = e2 + step2, z = z + stepZ){
+                int m = gtMask(e0, thr0) & gtMask(e1, thr1) & gtMask(e2, thr2);
+                if(!m) continue;
+                m &= ltMask(z, load(drow + x));
+                m &= (0xF << std::max(0, x0 - x)) & (0xF >> std::max(0, x + 3 - x1));
+                if(!m) continue;
+
+                float b0[4], b1[4], b2[4], zz[4];
+                store(b0, e0); store(b1, e1); store(b2, e2); store(zz, z);
+                for(int l=0;l<4;++l){
+                    if(!(m & (1 << l))) continue;
+                    drow[x+l] = zz[l];
+                    const float q0 = b0[l]*t.invW[0], q1 = b1[l]*t.invW[1], q2 = b2[l]*t.invW[2];
+                    const glm::vec3 c = (q0*t.col[0] + q1*t.col[1] + q2*t.col[2]) / (q0 + q1 + q2);
+                    uint8_t* p = crow + (size_t)(x+l)*4;
+                    p[0] = (uint8_t)(glm::clamp(c.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+                    p[1] = (uint8_t)(glm::clamp(c.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+                    p[2] = (uint8_t)(glm::clamp(c.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+                    p[3] = 255;
+                }
+            }
+        }
+    }
+}
+
+void SoftRasterizer::finish(){
+    if(!pool) return;
+    auto t0 = std::chrono::steady_clock::now();
+    pool->tileCount = tilesX * tilesY;
+    pool->next.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(pool->m);
+        pool->busy = (int)pool->workers.size();
+        ++pool->generation;
+    }
+    pool->wake.notify_all();
+    pool->run();
+    {
+        std::unique_lock<std::mutex> lock(pool->m);
+        pool->done.wait(lock, [&]{ return pool->busy == 0; });
+    }
+    clearPending = false;
+    tris.clear();
+    for(auto& bin : bins) bin.clear();
+    stats.rasterMs += msSince(t0);
+}
@@ -0,0 +1,69 @@
+// Tile-based software rasterizer for the LineVertex/TriVertex streams.
+//
+// No OpenGL: draw*() transforms, near-clips and sets up primitives on the
+// calling thread and bins them into kTileSize x kTileSize screen tiles.
+// finish() then rasterizes all tiles in parallel on a small worker pool; each
+// tile walks its bin in submission order, so the image is deterministic and
+// overlaps resolve like GL. Edge functions and the depth test are evaluated
+// four pixels at a time (SSE2 where available, scalar otherwise).
+//
+// Conventions follow the GL path: depth test GL_LESS on window z in [0, 1],
+// no face culling, perspective-correct colors, 1 px wide lines, pixel
+// centers at +0.5 with a top-left fill rule. The color buffer is RGBA8 with
+// the top row first.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "skeleton.h"
+
+struct SoftRasterStats {
+    size_t triangles = 0;       // after clipping, lines count as two
+    size_t binEntries = 0;      // triangle/tile pairs
+    double setupMs = 0;         // transform, clip, bin (draw* calls)
+    double rasterMs = 0;        // finish()
+};
+
+struct SoftRasterizer {
+    static constexpr int kTileSize = 64;
+
+    int width = 0, height = 0;
+    int threads = 0;
+    std::vector<uint8_t> color;         // width * height * 4
+    SoftRasterStats stats;              // since the last clear()
+
+    SoftRasterizer();
+    ~SoftRasterizer();                  // calls destroy()
+    SoftRasterizer(const SoftRasterizer&) = delete;
+    SoftRasterizer& operator=(const SoftRasterizer&) = delete;
+
+    // threads = 0 uses every hardware thread
+    bool init(int w, int h, int threadCount = 0);
+    void clear(const glm::vec3& c, float depth = 1.0f);
+    void drawTriangles(const TriVertex* v, size_t vertexCount, const glm::mat4& mvp);
+    void drawLines(const LineVertex* v, size_t vertexCount, const glm::mat4& mvp);
+    void finish();
+    void destroy();
+
+    struct Tri;
+    struct Pool;
+
+private:
+    int tilesX = 0, tilesY = 0, depthStride = 0;
+    std::vector<float> depth;           // rows padded to a multiple of 4
+    std::vector<Tri> tris;
+    std::vector<std::vector<uint32_t>> bins;
+    std::unique_ptr<Pool> pool;
+    uint32_t clearColor = 0;
+    float clearDepth = 1.0f;
+    bool clearPending = false;
+
+    void setup(const glm::vec4 clip[3], const glm::vec3 col[3]);
+    void clipAndSetup(const glm::vec4 clip[3], const glm::vec3 col[3]);
+    void rasterTile(int tile);
+};
@@ -0,0 +1,30 @@
+#include "startup_profile.h"
+
+static double msBetween(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b){
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+void StartupProfile::begin(){
+    start = last = std::chrono::steady_clock::now();
+    phases.clear();
+}
+
+void StartupProfile::phase(const char* name){
+    const auto now = std::chrono::steady_clock::now();
+    phases.push_back({name, msBetween(last, now), false});
+    last = now;
+}
+
+void StartupProfile::overlapped(const char* name, double ms){
+    phases.push_back({name, ms, true});
+}
+
+double StartupProfile::elapsedMs() const { return msBetween(start, std::chrono::steady_clock::now()); }
+
+void StartupProfile::report(std::FILE* out) const {
+    double total = 0;
+    for(const Phase& p : phases) if(!p.overlapped) total += p.ms;
+    std::fprintf(out, "startup: %.1f ms to first frame |", total);
+    for(const Phase& p : phases) std::fprintf(out, " %s%s %.2f", p.overlapped ? "(async) " : "", p.name, p.ms);
+    std::fprintf(out, " ms\n");
+}
@@ -0,0 +1,27 @@
+// Startup timeline: wall time of each setup phase, from the start of main()
+// to the first presented frame.
+//
+// phase(name) closes the phase that ran since the previous mark. Work done on
+// another thread (the --fast-start asset loader) is added with its own
+// duration and flagged as overlapped, so the breakdown still sums to the
+// critical path.
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+struct StartupProfile {
+    struct Phase { const char* name; double ms; bool overlapped; };
+
+    void begin();
+    void phase(const char* name);
+    void overlapped(const char* name, double ms);
+    double elapsedMs() const;
+    void report(std::FILE* out) const;
+
+    std::vector<Phase> phases;
+
+private:
+    std::chrono::steady_clock::time_point start, last;
+};
@@ -0,0 +1,376 @@
+// GL buffer streaming microbenchmark (headless, EGL)
+// ------------------------------------------------------------
+// Streams a payload into a vertex buffer every frame and draws points from
+// the region just written (rasterizer discard), so the GPU reads the buffer
+// and every strategy meets the usual hazards, using each of:
+//   subdata      glBufferSubData into one buffer, as main() does now
+//   orphan       glBufferData(NULL) to orphan, then glBufferSubData
+//   map          glMapBufferRange with GL_MAP_INVALIDATE_BUFFER_BIT
+//   ring         --segments regions of one buffer, unsynchronized
+//                glMapBufferRange, a fence per region waited on before reuse
+//   persistent   the same ring in glBufferStorage memory mapped once
+//                (persistent + coherent), if GL_ARB_buffer_storage is exposed
+// for every payload size. Per strategy and size it reports throughput over
+// the whole timed run (draws and the final glFinish included), CPU time per
+// upload and the part of it spent blocked inside GL: the upload entry points
+// and fence waits, without our own memcpy into mapped memory. A plain memcpy
+// of each payload is timed first as the floor.
+// The driver is named in the header line; run once per driver to compare.
+//
+// Options:
+//   --sizes LIST         payload sizes, K/M suffixes (default 4K,64K,1M,8M,32M)
+//   --frames N           timed frames per strategy and size (default 200)
+//   --max-mb N           cap on MB streamed per strategy and size (default 2048)
+//   --warmup N           untimed frames first (default 10)
+//   --segments N         ring regions (default 3)
+//   --draw-verts N       points drawn per frame, 0 = the whole payload
+//                        (default 4096; software drivers shade every point)
+//   --strategy TEXT      only strategies whose name contains TEXT
+//   --json FILE          write per-frame samples (skeleton_bench format, so
+//                        skeleton_perfcmp can compare runs)
+// ------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+
+#include "headless.h"
+#include "frame_stats.h"
+#include "gl_util.h"
+
+// GL 4.4 / ARB_buffer_storage; the GLAD loader is generated for 3.3 core
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRY *BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+struct StreamOptions {
+    std::vector<size_t> sizes;
+    int frames = 200;
+    long maxMB = 2048;
+    int warmup = 10;
+    int segments = 3;
+    int drawVerts = 4096;
+    const char* strategy = nullptr;
+    const char* json = nullptr;
+};
+
+// "4K,64K,1M" -> bytes; false on anything else
+static bool parseSizes(const char* s, std::vector<size_t>& out){
+    out.clear();
+    while(*s){
+        char* end = nullptr;
+        double v = std::strtod(s, &end);
+        if(end == s || v <= 0) return false;
+        if(*end == 'K' || *end == 'k'){ v *= 1024.0; ++end; }
+        else if(*end == 'M' || *end == 'm'){ v *= 1024.0 * 1024.0; ++end; }
+        out.push_back(std::max<size_t>(16, (size_t)v / 16 * 16));    // whole vec4 vertices
+        if(*end == ',') ++end;
+        else if(*end) return false;
+        s = end;
+    }
+    return !out.empty();
+}
+
+static bool parseArgs(int argc, char** argv, StreamOptions& o){
+    parseSizes("4K,64K,1M,8M,32M", o.sizes);
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        const char* next = (i+1 < argc) ? argv[i+1] : nullptr;
+        if(std::strcmp(a, "--sizes") == 0 && next){
+            if(!parseSizes(next, o.sizes)){ std::fprintf(stderr, "Bad --sizes '%s'\n", next); return false; }
+            ++i;
+        }
+        else if(std::strcmp(a, "--frames") == 0 && next){ o.frames = std::max(1, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--max-mb") == 0 && next){ o.maxMB = std::max(1L, std::atol(next)); ++i; }
+        else if(std::strcmp(a, "--warmup") == 0 && next){ o.warmup = std::max(0, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--segments") == 0 && next){ o.segments = std::max(2, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--draw-verts") == 0 && next){ o.drawVerts = std::max(0, std::atoi(next)); ++i; }
+        else if(std::strcmp(a, "--strategy") == 0 && next){ o.strategy = next; ++i; }
+        else if(std::strcmp(a, "--json") == 0 && next){ o.json = next; ++i; }
+        else { std::fprintf(stderr, "Unknown argument '%s'\n", a); return false; }
+    }
+    return true;
+}
+
+static double nowSeconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string sizeLabel(size_t bytes){
+    char s[32];
+    if(bytes >= 1024 * 1024 && bytes % (1024 * 1024) == 0) std::snprintf(s, sizeof(s), "%zuM", bytes / (1024 * 1024));
+    else if(bytes >= 1024 && bytes % 1024 == 0) std::snprintf(s, sizeof(s), "%zuK", bytes / 1024);
+    else std::snprintf(s, sizeof(s), "%zuB", bytes);
+    return s;
+}
+
+// ------------------------------------------------------------
+// Strategies
+// ------------------------------------------------------------
+enum class Strategy { SubData, Orphan, Map, Ring, Persistent, Count };
+static const char* const kStrategyNames[(int)Strategy::Count] = { "subdata", "orphan", "map", "ring", "persistent" };
+
+struct Streamer {
+    Strategy strategy;
+    size_t size = 0;                    // payload bytes
+    int segments = 1;
+    GLuint vao = 0, vbo = 0;
+    std::vector<GLsync> fences;
+    unsigned char* persistent = nullptr;
+    int segment = 0;
+    double glSeconds = 0;               // blocked in GL during the last upload()
+
+    bool init(Strategy s, size_t bytes, int ringSegments, BufferStorageProc bufferStorage){
+        strategy = s; size = bytes;
+        segments = (s == Strategy::Ring || s == Strategy::Persistent) ? ringSegments : 1;
+        fences.assign((size_t)segments, nullptr);
+        const GLsizeiptr total = (GLsizeiptr)(size * (size_t)segments);
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if(s == Strategy::Persistent){
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags);
+            persistent = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags);
+            if(!persistent){ std::fprintf(stderr, "persistent: glMapBufferRange failed (0x%x)\n", glGetError()); return false; }
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        }
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 16, (void*)0);
+        return glGetError() == GL_NO_ERROR;
+    }
+
+    // Waits until the GPU is done with the region about to be overwritten
+    void waitSegment(){
+        GLsync& f = fences[(size_t)segment];
+        if(!f) return;
+        GLenum r;
+        while((r = glClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull)) == GL_TIMEOUT_EXPIRED) {}
+        if(r == GL_WAIT_FAILED) std::fprintf(stderr, "glClientWaitSync failed (0x%x)\n", glGetError());
+        glDeleteSync(f);
+        f = nullptr;
+    }
+
+    // Copies src (size bytes) into the buffer; returns the first vertex to draw
+    GLint upload(const unsigned char* src){
+        glSeconds = 0;
+        auto timed = [&](auto&& call){ const double t0 = nowSeconds(); call(); glSeconds += nowSeconds() - t0; };
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        const GLintptr offset = (GLintptr)(size * (size_t)segment);
+        switch(strategy){
+        case Strategy::SubData:
+            timed([&]{ glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)size, src); });
+            break;
+        case Strategy::Orphan:
+            timed([&]{
+                glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_DRAW);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)size, src);
+            });
+            break;
+        case Strategy::Map:
+        case Strategy::Ring: {
+            void* dst = nullptr;
+            const GLbitfield access = strategy == Strategy::Map
+                ? GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+                : GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+            timed([&]{ if(strategy == Strategy::Ring) waitSegment(); dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, (GLsizeiptr)size, access); });
+            if(dst) std::memcpy(dst, src, size);
+            else std::fprintf(stderr, "%s: glMapBufferRange failed (0x%x)\n", kStrategyNames[(int)strategy], glGetError());
+            timed([&]{ glUnmapBuffer(GL_ARRAY_BUFFER); });
+            break;
+        }
+        case Strategy::Persistent:
+            timed([&]{ waitSegment(); });
+            std::memcpy(persistent + offset, src, size);
+            break;
+        case Strategy::Count: break;
+        }
+        return (GLint)((size_t)offset / 16);
+    }
+
+    // After the draw that reads the region just written
+    void fence(){
+        if(segments > 1){
+            fences[(size_t)segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            segment = (segment + 1) % segments;
+        }
+    }
+
+    void destroy(){
+        for(GLsync& f : fences) if(f){ glDeleteSync(f); f = nullptr; }
+        if(persistent){ glBindBuffer(GL_ARRAY_BUFFER, vbo); glUnmapBuffer(GL_ARRAY_BUFFER); persistent = nullptr; }
+        if(vbo) glDeleteBuffers(1, &vbo);
+        if(vao) glDeleteVertexArrays(1, &vao);
+        vbo = vao = 0;
+    }
+};
+
+// ------------------------------------------------------------
+// Measurement
+// ------------------------------------------------------------
+struct StreamResult {
+    std::string name;                   // "strategy/size"
+    size_t bytes;
+    int frames;
+    double mbPerS;
+    LatencyHistogram frameMs, glMs;
+    std::vector<double> samplesNs;      // CPU time per upload
+};
+
+static const char* kVertexSrc = R"(#version 330 core
+layout(location=0) in vec4 aData;
+void main(){ gl_Position = aData; gl_PointSize = 1.0; }
+)";
+static const char* kFragmentSrc = R"(#version 330 core
+out vec4 color;
+void main(){ color = vec4(1.0); }
+)";
+
+static int framesFor(const StreamOptions& o, size_t bytes){
+    const long cap = (long)((double)o.maxMB * 1024.0 * 1024.0 / (double)bytes);
+    return (int)std::max(8L, std::min((long)o.frames, cap));
+}
+
+static StreamResult memcpyFloor(const StreamOptions& o, size_t bytes, const std::vector<unsigned char>& src){
+    StreamResult r{"memcpy/" + sizeLabel(bytes), bytes, framesFor(o, bytes), 0, {}, {}, {}};
+    std::vector<unsigned char> dst(bytes);
+    for(int i=0;i<o.warmup;++i) std::memcpy(dst.data(), src.data(), bytes);
+    const double start = nowSeconds();
+    for(int i=0;i<r.frames;++i){
+        const double t0 = nowSeconds();
+        std::memcpy(dst.data(), src.data(), bytes);
+        const double dt = nowSeconds() - t0;
+        r.frameMs.record(dt * 1000.0);
+        r.samplesNs.push_back(dt * 1e9);
+    }
+    r.mbPerS = (double)bytes * r.frames / (nowSeconds() - start) / (1024.0 * 1024.0);
+    volatile unsigned char sink = dst[bytes / 2]; (void)sink;
+    return r;
+}
+
+static bool runStrategy(const StreamOptions& o, Strategy s, size_t bytes, std::vector<unsigned char>& src,
+                        BufferStorageProc bufferStorage, StreamResult& r){
+    Streamer st;
+    if(!st.init(s, bytes, o.segments, bufferStorage)){ st.destroy(); return false; }
+    r = StreamResult{std::string(kStrategyNames[(int)s]) + "/" + sizeLabel(bytes), bytes, framesFor(o, bytes), 0, {}, {}, {}};
+    r.samplesNs.reserve((size_t)r.frames);
+    const GLsizei verts = (GLsizei)(o.drawVerts > 0 ? std::min(bytes / 16, (size_t)o.drawVerts) : bytes / 16);
+    double start = 0;
+    for(int i=0;i<o.warmup + r.frames;++i){
+        if(i == o.warmup){ glFinish(); start = nowSeconds(); }
+        std::memcpy(src.data(), &i, sizeof(i));         // the payload changes every frame
+        const double t0 = nowSeconds();
+        const GLint first = st.upload(src.data());
+        const double dt = nowSeconds() - t0;
+        glDrawArrays(GL_POINTS, first, verts);
+        st.fence();
+        if(i >= o.warmup){
+            r.frameMs.record(dt * 1000.0);
+            r.glMs.record(st.glSeconds * 1000.0);
+            r.samplesNs.push_back(dt * 1e9);
+        }
+    }
+    glFinish();
+    r.mbPerS = (double)bytes * r.frames / (nowSeconds() - start) / (1024.0 * 1024.0);
+    const GLenum err = glGetError();
+    st.destroy();
+    if(err != GL_NO_ERROR){ std::fprintf(stderr, "%s: GL error 0x%x\n", r.name.c_str(), err); return false; }
+    return true;
+}
+
+static void printResult(const StreamResult& r, bool hasGl){
+    std::printf("%-20s %6d %10.1f %9.3f %9.3f", r.name.c_str(), r.frames, r.mbPerS, r.frameMs.percentile(0.5), r.frameMs.percentile(0.99));
+    if(hasGl) std::printf(" %9.3f %9.3f %9.3f\n", r.glMs.percentile(0.5), r.glMs.percentile(0.99), r.glMs.meanMs());
+    else std::printf(" %9s %9s %9s\n", "-", "-", "-");
+}
+
+static bool writeJson(const char* path, const StreamOptions& o, const char* renderer, const std::vector<StreamResult>& results){
+    std::FILE* f = std::fopen(path, "w");
+    if(!f){ std::fprintf(stderr, "Failed to open %s for writing\n", path); return false; }
+    std::fprintf(f, "{\n  \"tool\": \"skeleton_streambench\",\n  \"renderer\": \"");
+    for(const char* c = renderer; *c; ++c) if(*c != '"' && *c != '\\') std::fputc(*c, f);
+    std::fprintf(f, "\",\n  \"warmup\": %d,\n  \"segments\": %d,\n  \"benchmarks\": [\n", o.warmup, o.segments);
+    for(size_t i=0;i<results.size();++i){
+        const StreamResult& r = results[i];
+        std::vector<double> sorted = r.samplesNs;
+        std::sort(sorted.begin(), sorted.end());
+        const size_t n = sorted.size();
+        const double median = n % 2 ? sorted[n/2] : 0.5 * (sorted[n/2 - 1] + sorted[n/2]);
+        std::fprintf(f, "    {\"name\": \"%s\", \"unit\": \"byte\", \"units_per_op\": %zu, \"iterations_per_sample\": 1,\n"
+                        "     \"median_ns\": %.1f, \"min_ns\": %.1f, \"max_ns\": %.1f, \"mb_per_s\": %.2f, \"gl_mean_ns\": %.1f,\n"
+                        "     \"samples_ns\": [",
+                     r.name.c_str(), r.bytes, median, sorted.front(), sorted.back(), r.mbPerS, r.glMs.meanMs() * 1e6);
+        for(size_t k=0;k<n;++k) std::fprintf(f, "%s%.1f", k ? ", " : "", r.samplesNs[k]);
+        std::fprintf(f, "]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    const bool ok = std::fclose(f) == 0;
+    if(!ok) std::fprintf(stderr, "Failed to write %s\n", path);
+    return ok;
+}
+
+static bool hasExtension(const char* name){
+    GLint n = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+    for(GLint i=0;i<n;++i)
+        if(std::strcmp((const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i), name) == 0) return true;
+    return false;
+}
+
+// ------------------------------------------------------------
+// Main
+// ------------------------------------------------------------
+int main(int argc, char** argv){
+    StreamOptions opts;
+    if(!parseArgs(argc, argv, opts)) return 1;
+
+    HeadlessContext ctx;
+    if(!ctx.init(64, 64)) return 1;
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+
+    BufferStorageProc bufferStorage = nullptr;
+    if(hasExtension("GL_ARB_buffer_storage")) bufferStorage = (BufferStorageProc)eglGetProcAddress("glBufferStorage");
+    if(!bufferStorage) std::printf("GL_ARB_buffer_storage not available: persistent mapping skipped\n");
+
+    GLuint prog = makeProgram(kVertexSrc, kFragmentSrc);
+    if(!prog){ ctx.destroy(); return 1; }
+    glUseProgram(prog);
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    std::printf("%-20s %6s %10s %9s %9s %9s %9s %9s\n", "strategy/size", "frames", "MB/s",
+                "cpu p50", "cpu p99", "gl p50", "gl p99", "gl mean");
+    std::vector<StreamResult> results;
+    bool ok = true;
+    for(size_t bytes : opts.sizes){
+        std::vector<unsigned char> src(bytes);
+        for(size_t i=0;i<bytes;++i) src[i] = (unsigned char)(i * 131u + 7u);
+        results.push_back(memcpyFloor(opts, bytes, src));
+        printResult(results.back(), false);
+        for(int s=0;s<(int)Strategy::Count;++s){
+            if(opts.strategy && !std::strstr(kStrategyNames[s], opts.strategy)) continue;
+            if((Strategy)s == Strategy::Persistent && !bufferStorage) continue;
+            StreamResult r;
+            if(!runStrategy(opts, (Strategy)s, bytes, src, bufferStorage, r)){ ok = false; continue; }
+            results.push_back(std::move(r));
+            printResult(results.back(), true);
+        }
+    }
+    std::printf("(ms per frame; cpu = the whole upload, gl = the part blocked in GL upload calls and fence waits)\n");
+
+    if(opts.json && !writeJson(opts.json, opts, renderer, results)) ok = false;
+    glDeleteProgram(prog);
+    ctx.destroy();
+    return ok ? 0 : 1;
+}
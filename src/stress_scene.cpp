@@ -0,0 +1,184 @@
+#include "stress_scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frame_stats.h"
+#include "hud.h"
+#include "pose_check.h"
+#include "profiler.h"
+#include "upload_stats.h"
+
+// ------------------------------------------------------------
+// Scene generation
+// ------------------------------------------------------------
+// PCG32: small, and unlike <random> distributions identical on every platform
+struct Pcg32 {
+    uint64_t state;
+    explicit Pcg32(uint64_t seed) : state(seed * 6364136223846793005ULL + 1442695040888963407ULL) {}
+    uint32_t next(){
+        const uint64_t old = state;
+        state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        const uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+    float uniform(){ return (float)(next() >> 8) * (1.0f / 16777216.0f); }   // [0, 1)
+};
+
+bool StressScene::parse(const char* spec){
+    static const struct { const char* name; int walkers; } kPresets[] = {
+        {"single", 1}, {"small", 100}, {"large", 10000}, {"huge", 100000},
+    };
+    name = spec;
+    const char* dash = std::strchr(spec, '-');
+    const std::string count(spec, dash ? (size_t)(dash - spec) : std::strlen(spec));
+    walkers = 0;
+    for(const auto& p : kPresets) if(count == p.name) walkers = p.walkers;
+    if(walkers == 0){
+        char* end = nullptr;
+        const double n = std::strtod(count.c_str(), &end);
+        const double scale = (*end == 'k' || *end == 'K') ? 1e3 : (*end == 'm' || *end == 'M') ? 1e6 : 1.0;
+        if(end == count.c_str() || (scale != 1.0 && end[1] != '\0') || (scale == 1.0 && *end != '\0')){
+            std::fprintf(stderr, "Bad scene '%s' (expected e.g. 100, 10k, 100k-random or single/small/large/huge)\n", spec);
+            return false;
+        }
+        // Checked as a double: the cast below is only defined for values an int holds
+        if(!(n * scale >= 1.0 && n * scale <= (double)kMaxWalkers)){
+            std::fprintf(stderr, "Bad scene '%s': walker count must be 1 to %d\n", spec, kMaxWalkers);
+            return false;
+        }
+        walkers = (int)(n * scale);
+    }
+    layout = SceneLayout::Grid; randomPhase = false;
+    if(dash){
+        if(std::strcmp(dash + 1, "random") == 0){ layout = SceneLayout::Random; randomPhase = true; }
+        else if(std::strcmp(dash + 1, "grid") != 0){
+            std::fprintf(stderr, "Bad scene layout '%s' (grid or random)\n", dash + 1);
+            return false;
+        }
+    }
+    return true;
+}
+
+float StressScene::extent() const {
+    const int side = (int)std::ceil(std::sqrt((double)walkers));
+    return 0.5f * (float)(side - 1) * spacing;
+}
+
+void StressScene::generate(std::vector<glm::vec3>& offsets, std::vector<float>& phases) const {
+    offsets.resize((size_t)walkers);
+    phases.resize((size_t)walkers);
+    const int side = (int)std::ceil(std::sqrt((double)walkers));
+    const float half = extent();
+    const float period = 1.0f / 1.6f;   // one walk cycle in animateWalk
+    Pcg32 rng(seed);
+    for(int i=0;i<walkers;++i){
+        if(layout == SceneLayout::Grid)
+            offsets[(size_t)i] = glm::vec3((i % side) * spacing - half, 0.0f, (i / side) * spacing - half);
+        else
+            offsets[(size_t)i] = glm::vec3((rng.uniform() * 2.0f - 1.0f) * half, 0.0f, (rng.uniform() * 2.0f - 1.0f) * half);
+        float f = randomPhase ? rng.uniform() : (float)i * 0.6180339887f;
+        phases[(size_t)i] = (f - std::floor(f)) * period;
+    }
+}
+
+glm::mat4 StressScene::view(float t, float& farPlane) const {
+    // One orbit every 10 s, bobbing in pitch and breathing in distance
+    const float half = extent();
+    const float radius = std::max(3.0f, half * 1.8f + 2.0f) * (1.0f + 0.15f * std::sin(0.3f * t));
+    const float yaw = glm::radians(30.0f + 36.0f * t);
+    const float pitch = glm::radians(-20.0f - 10.0f * std::sin(0.5f * t));
+    const glm::vec3 target(0, 1.0f, 0);
+    const glm::vec3 dir(std::cos(yaw)*std::cos(pitch), std::sin(pitch), std::sin(yaw)*std::cos(pitch));
+    farPlane = std::max(50.0f, radius * 1.2f + half * 2.0f);
+    return glm::lookAt(target - dir * radius, target, {0,1,0});
+}
+
+// ------------------------------------------------------------
+// Report
+// ------------------------------------------------------------
+void SceneReport::addFrame(const HudFrame& f){
+    for(int i=0;i<f.stageCount;++i){
+        const HudFrame::Stage& s = f.stages[i];
+        auto it = std::find_if(stages.begin(), stages.end(), [&](const Stage& x){ return std::strcmp(x.name, s.name) == 0; });
+        if(it == stages.end()){ stages.push_back(Stage{s.name}); it = stages.end() - 1; }
+        if(s.cpuMs >= 0){ it->cpuMs += s.cpuMs; ++it->cpuCount; }
+        if(s.gpuMs >= 0){ it->gpuMs += s.gpuMs; ++it->gpuCount; }
+    }
+}
+
+// Writes s as a JSON string body: quotes, backslashes and control characters escaped
+static void writeJsonString(std::FILE* f, const char* s){
+    for(; *s; ++s){
+        if(*s == '"' || *s == '\\') std::fprintf(f, "\\%c", *s);
+        else if((unsigned char)*s < 0x20) std::fprintf(f, "\\u%04x", (unsigned)(unsigned char)*s);
+        else std::fputc(*s, f);
+    }
+}
+
+// Resident and peak resident set size in bytes, -1 where unavailable
+static void processMemory(long long& rss, long long& peak){
+    rss = peak = -1;
+#ifdef __linux__
+    if(std::FILE* f = std::fopen("/proc/self/status", "r")){
+        char line[256];
+        while(std::fgets(line, sizeof(line), f)){
+            long long kb = 0;
+            if(std::sscanf(line, "VmRSS: %lld kB", &kb) == 1) rss = kb * 1024;
+            else if(std::sscanf(line, "VmHWM: %lld kB", &kb) == 1) peak = kb * 1024;
+        }
+        std::fclose(f);
+    }
+#endif
+}
+
+bool SceneReport::write(const char* path, const StressScene& scene, const FrameStats& stats,
+                        int width, int height, double wallSeconds) const {
+    std::FILE* f = path ? std::fopen(path, "w") : stdout;
+    if(!f){ std::fprintf(stderr, "Failed to open %s for writing\n", path); return false; }
+
+    std::fprintf(f, "{\n  \"scene\": {\"name\": \"");
+    writeJsonString(f, scene.name.c_str());
+    std::fprintf(f, "\", \"walkers\": %d, \"requested_walkers\": %d, \"layout\": \"%s\", \"seed\": %u, "
+                    "\"width\": %d, \"height\": %d, \"frames\": %ld},\n  \"wall_seconds\": %.4f,\n",
+                 walkers, scene.walkers, scene.layout == SceneLayout::Grid ? "grid" : "random", scene.seed,
+                 width, height, stats.totalFrames, wallSeconds);
+    // Instrumentation compiled into the run, which the stage times include
+    std::fprintf(f, "  \"build\": {\"profiler\": %s, \"pose_shadow\": %s},\n  \"frame_ms\": {",
+                 SKEL_PROFILE ? "true" : "false", SKEL_POSE_SHADOW ? "true" : "false");
+    bool first = true;
+    for(int m=0;m<FrameStats::kMetricCount;++m){
+        const LatencyHistogram& h = stats.run[m];
+        if(h.total == 0) continue;
+        std::fprintf(f, "%s\n    \"%s\": {\"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"p99.9\": %.4f, \"max\": %.4f, \"mean\": %.4f}",
+                     first ? "" : ",", FrameStats::metricName(m), h.percentile(0.50), h.percentile(0.90),
+                     h.percentile(0.99), h.percentile(0.999), h.maxMs(), h.meanMs());
+        first = false;
+    }
+    std::fprintf(f, "\n  },\n  \"stages_ms\": [");
+    for(size_t i=0;i<stages.size();++i){
+        const Stage& s = stages[i];
+        std::fprintf(f, "%s\n    {\"name\": \"%s\", \"cpu\": ", i ? "," : "", s.name);
+        if(s.cpuCount) std::fprintf(f, "%.4f", s.cpuMs / (double)s.cpuCount); else std::fprintf(f, "null");
+        std::fprintf(f, ", \"gpu\": ");
+        if(s.gpuCount) std::fprintf(f, "%.4f", s.gpuMs / (double)s.gpuCount); else std::fprintf(f, "null");
+        std::fprintf(f, "}");
+    }
+    const UploadReport& up = uploadRun();
+    const double frames = (double)std::max(up.frames, 1L);
+    long long rss, peak; processMemory(rss, peak);
+    std::fprintf(f, "\n  ],\n  \"uploads\": {\"bytes_per_frame\": %.1f, \"mb_per_s\": %.3f, \"peak_frame_bytes\": %llu, \"startup_bytes\": %llu},\n",
+                 (double)up.total() / frames, up.seconds > 0 ? (double)up.total() / up.seconds * 1e-6 : 0.0,
+                 (unsigned long long)up.peakTotalBytes, (unsigned long long)startupUploadBytes());
+    std::fprintf(f, "  \"memory\": {\"rss_bytes\": %lld, \"peak_rss_bytes\": %lld, \"scene_cpu_bytes\": %zu, \"scene_gpu_bytes\": %zu}\n}\n",
+                 rss, peak, cpuBytes, gpuBytes);
+    if(f == stdout) return true;
+    const bool ok = std::fclose(f) == 0;
+    if(!ok) std::fprintf(stderr, "Failed to write %s\n", path);
+    return ok;
+}
@@ -0,0 +1,56 @@
+// Built-in benchmark scenes and their JSON reports.
+//
+// A scene is N walkers of the crowd path laid out on a grid or scattered at
+// random, with golden-ratio or random walk phases, watched by a scripted
+// orbit camera. Everything derives from the seed and the simulated time, so
+// two runs of the same spec render the same frames. Specs look like
+// "100", "10k", "1k-grid" or "100k-random" (random placement also randomizes
+// the phases); the named presets are single (1), small (100), large (10k) and
+// huge (100k).
+//
+// SceneReport accumulates per-stage CPU/GPU times from the HudFrames of a run
+// and writes them with the frame-time percentiles, upload volume and memory
+// use as one JSON object. "walkers" is the number actually drawn, which the
+// texture buffer limit can hold below "requested_walkers".
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct HudFrame;
+struct FrameStats;
+
+enum class SceneLayout { Grid, Random };
+
+struct StressScene {
+    static constexpr int kMaxWalkers = 10000000;
+
+    std::string name;
+    int walkers = 1;
+    SceneLayout layout = SceneLayout::Grid;
+    bool randomPhase = false;
+    uint32_t seed = 1;
+    float spacing = 1.2f;
+
+    bool parse(const char* spec);
+    // Per-walker world offsets and phase offsets (seconds)
+    void generate(std::vector<glm::vec3>& offsets, std::vector<float>& phases) const;
+    // Scripted camera at simulated time t; farPlane is sized to the scene
+    glm::mat4 view(float t, float& farPlane) const;
+    float extent() const;               // half width of the populated square
+};
+
+struct SceneReport {
+    struct Stage { const char* name; double cpuMs = 0, gpuMs = 0; long cpuCount = 0, gpuCount = 0; };
+    std::vector<Stage> stages;          // first-seen order
+    size_t cpuBytes = 0, gpuBytes = 0;  // scene data held by the crowd
+    int walkers = 0;                    // drawn, after the crowd's texture buffer limit
+
+    void addFrame(const HudFrame& f);
+    bool write(const char* path, const StressScene& scene, const FrameStats& stats,
+               int width, int height, double wallSeconds) const;   // path null = stdout
+};
@@ -0,0 +1,172 @@
+#include "text_renderer.h"
+
+#include <cstddef>
+#include <string>
+
+#include "gl_util.h"
+#include "camera_block.h"
+#include "font.h"
+#include "upload_stats.h"
+
+// ------------------------------------------------------------
+// Shader sources
+// ------------------------------------------------------------
+static const char* kTextVSHead = R"GLSL(
+#version 330 core
+layout (location = 0) in vec4 aAnchor;
+layout (location = 1) in vec2 aOffset;
+layout (location = 2) in int  aGlyph;
+layout (location = 3) in vec4 aColor;
+
+uniform vec2 uViewport;
+uniform float uScale;
+uniform ivec2 uAtlasGrid;       // columns, rows
+
+out vec2 vUV;
+out vec4 vColor;
+)GLSL";
+
+static const char* kTextVSMain = R"GLSL(
+void main(){
+    int eye = eyeIndex();
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);     // strip: (0,0) (1,0) (0,1) (1,1)
+    vec2 cell = vec2(6.0, 8.0);
+    vec2 px = aOffset + corner * cell * uScale;                 // pixels, y down
+
+    vec4 clip;
+    if(aAnchor.w > 0.5){
+        clip = eyeClip(aAnchor.xyz, eye);
+        float sx = uEyeCount == 2 ? 0.5 : 1.0;                  // each eye is half as wide
+        clip.xy += vec2(px.x * sx, -px.y) * 2.0 / uViewport * clip.w;
+    } else {
+        vec2 p = aAnchor.xy + px;
+        clip = vec4(p.x / uViewport.x * 2.0 - 1.0, 1.0 - p.y / uViewport.y * 2.0, 0.0, 1.0);
+        gl_ClipDistance[0] = eye == 0 ? 1.0 : -1.0;             // HUD once, not per eye
+    }
+    gl_Position = clip;
+
+    vec2 slot = vec2(aGlyph % uAtlasGrid.x, aGlyph / uAtlasGrid.x);
+    vUV = (slot + corner) / vec2(uAtlasGrid);
+    vColor = aColor;
+}
+)GLSL";
+
+static const char* kTextFS = R"GLSL(
+#version 330 core
+in vec2 vUV;
+in vec4 vColor;
+uniform sampler2D uFont;
+out vec4 FragColor;
+void main(){
+    float a = texture(uFont, vUV).r * vColor.a;
+    if(a < 0.01) discard;
+    FragColor = vec4(vColor.rgb, a);
+}
+)GLSL";
+
+// ------------------------------------------------------------
+// Layout
+// ------------------------------------------------------------
+int layoutText(const char* s, const glm::vec4& anchor, glm::vec2 offset, GLuint color, float scale,
+               GlyphInstance* out, int maxGlyphs){
+    int n = 0;
+    const float x0 = offset.x;
+    for(; *s && n < maxGlyphs; ++s){
+        if(*s == '\n'){ offset.x = x0; offset.y += kCellH * scale; continue; }
+        if(*s != ' ') out[n++] = {anchor, offset, (GLuint)glyphIndex(*s), color};
+        offset.x += kCellW * scale;
+    }
+    return n;
+}
+
+// ------------------------------------------------------------
+// TextRenderer
+// ------------------------------------------------------------
+void TextRenderer::init(){
+    std::string vs = std::string(kTextVSHead) + kCameraBlockGLSL + kTextVSMain;
+    prog = makeProgram(vs.c_str(), kTextFS);
+    bindCameraBlock(prog);
+    uViewport = glGetUniformLocation(prog, "uViewport");
+    uScale = glGetUniformLocation(prog, "uScale");
+    uFont = glGetUniformLocation(prog, "uFont");
+    uAtlasGrid = glGetUniformLocation(prog, "uAtlasGrid");
+
+    int aw = 0, ah = 0;
+    std::vector<uint8_t> px = bakeFontAtlas(aw, ah);
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, aw, ah, 0, GL_RED, GL_UNSIGNED_BYTE, px.data());
+    countUpload(UploadCategory::Texture, px.size());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    capacity = 4096;
+    glGenVertexArrays(1, &vao); glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(capacity*sizeof(GlyphInstance)), nullptr, GL_STREAM_DRAW);
+    const GLsizei stride = sizeof(GlyphInstance);
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(1); glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GlyphInstance, offset));
+    glEnableVertexAttribArray(2); glVertexAttribIPointer(2, 1, GL_INT, stride, (void*)offsetof(GlyphInstance, glyph));
+    glEnableVertexAttribArray(3); glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(GlyphInstance, color));
+    for(GLuint a=0;a<4;++a) glVertexAttribDivisor(a, 1);
+    glBindVertexArray(0);
+}
+
+void TextRenderer::upload(const GlyphInstance* glyphs, size_t count){
+    uploaded = count;
+    if(count == 0) return;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if(count > capacity){
+        while(capacity < count) capacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(capacity*sizeof(GlyphInstance)), nullptr, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(count*sizeof(GlyphInstance)), glyphs);
+    countUpload(UploadCategory::Vertex, count*sizeof(GlyphInstance));
+}
+
+void TextRenderer::draw(const GlyphInstance* glyphs, size_t count, int eyeCount, int viewportW, int viewportH){
+    upload(glyphs, count);
+    drawUploaded(eyeCount, viewportW, viewportH);
+}
+
+void TextRenderer::drawUploaded(int eyeCount, int viewportW, int viewportH){
+    if(uploaded == 0) return;
+
+    glUseProgram(prog);
+    glUniform2f(uViewport, (float)viewportW, (float)viewportH);
+    glUniform1f(uScale, scale);
+    glUniform1i(uFont, 0);
+    glUniform2i(uAtlasGrid, kAtlasCols, kAtlasRows);
+    countUpload(UploadCategory::Uniform, 3*sizeof(float) + 3*sizeof(GLint));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+
+    glBindVertexArray(vao);
+    if(eyeCount != instanceDivisor){
+        for(GLuint a=0;a<4;++a) glVertexAttribDivisor(a, (GLuint)eyeCount);
+        instanceDivisor = eyeCount;
+    }
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)uploaded * eyeCount);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextRenderer::destroy(){
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteTextures(1, &atlas);
+    glDeleteProgram(prog);
+}
@@ -0,0 +1,48 @@
+// Instanced bitmap text: one quad instance per glyph, one draw per batch.
+//
+// A glyph is anchored either at a world position (projected per eye, then
+// offset in pixels) or directly at a pixel position from the top-left of the
+// viewport. Screen-anchored glyphs are only emitted for eye 0, so a stereo
+// HUD stays a single full-width overlay.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+struct GlyphInstance {
+    glm::vec4 anchor;       // xyz world (w = 1) or xy pixels (w = 0)
+    glm::vec2 offset;       // pixels right/down from the anchor
+    GLuint glyph;           // atlas slot, see glyphIndex()
+    GLuint color;           // RGBA8, packRGBA()
+};
+
+inline GLuint packRGBA(const glm::vec3& c, float a = 1.0f){
+    auto b = [](float v){ return (GLuint)(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return b(c.x) | (b(c.y) << 8) | (b(c.z) << 16) | (b(a) << 24);
+}
+
+// Lay out s starting at anchor + offset; '\n' starts a new line. Writes at
+// most maxGlyphs instances (spaces are skipped) and returns how many.
+int layoutText(const char* s, const glm::vec4& anchor, glm::vec2 offset, GLuint color, float scale,
+               GlyphInstance* out, int maxGlyphs);
+
+struct TextRenderer {
+    float scale = 2.0f;             // atlas pixels -> screen pixels
+
+    GLuint prog = 0;
+    GLint uViewport = -1, uScale = -1, uFont = -1, uAtlasGrid = -1;
+    GLuint vao = 0, vbo = 0, atlas = 0;
+    size_t capacity = 0;            // glyphs the VBO can hold
+    size_t uploaded = 0;            // glyphs currently in the VBO
+    int instanceDivisor = 1;
+
+    void init();
+    // upload() + drawUploaded(); text that rarely changes can upload once and redraw
+    void draw(const GlyphInstance* glyphs, size_t count, int eyeCount, int viewportW, int viewportH);
+    void upload(const GlyphInstance* glyphs, size_t count);
+    void drawUploaded(int eyeCount, int viewportW, int viewportH);
+    void destroy();
+};
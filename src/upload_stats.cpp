@@ -0,0 +1,68 @@
+#include "upload_stats.h"
+
+#include <algorithm>
+
+static uint64_t g_frame[kUploadCategories];
+static uint64_t g_startup = 0;
+static bool g_started = false;
+static UploadReport g_window, g_run;
+
+static const char* const kCategoryNames[kUploadCategories] = { "vertex", "uniform", "texture", "mapped" };
+
+void countUpload(UploadCategory c, size_t bytes){ g_frame[(int)c] += bytes; }
+
+uint64_t uploadFrameBytes(){
+    uint64_t sum = 0;
+    for(uint64_t b : g_frame) sum += b;
+    return sum;
+}
+
+static void fold(UploadReport& r, double seconds){
+    const uint64_t frameTotal = uploadFrameBytes();
+    for(int c=0;c<kUploadCategories;++c){
+        r.bytes[c] += g_frame[c];
+        r.peakFrameBytes[c] = std::max(r.peakFrameBytes[c], g_frame[c]);
+    }
+    r.peakTotalBytes = std::max(r.peakTotalBytes, frameTotal);
+    if(seconds > 0) r.peakMBps = std::max(r.peakMBps, (double)frameTotal / seconds * 1e-6);
+    ++r.frames;
+    r.seconds += seconds;
+}
+
+void endUploadFrame(double frameSeconds){
+    if(!g_started){
+        // Everything before the first frame closes is startup data
+        g_startup = uploadFrameBytes();
+        g_started = true;
+    } else {
+        fold(g_window, frameSeconds);
+        fold(g_run, frameSeconds);
+    }
+    std::fill(g_frame, g_frame + kUploadCategories, 0);
+}
+
+uint64_t startupUploadBytes(){ return g_startup; }
+const UploadReport& uploadWindow(){ return g_window; }
+const UploadReport& uploadRun(){ return g_run; }
+void restartUploadWindow(){ g_window = UploadReport{}; }
+
+uint64_t UploadReport::total() const {
+    uint64_t sum = 0;
+    for(uint64_t b : bytes) sum += b;
+    return sum;
+}
+
+void UploadReport::print(std::FILE* out, const char* label) const {
+    if(frames == 0) return;
+    const double n = (double)frames;
+    const double rate = seconds > 0 ? 1e-6 / seconds : 0.0;
+    std::fprintf(out, "%s: %.1f KB/frame, %.2f MB/s (peak frame %.1f KB, %.2f MB/s)",
+                 label, (double)total() / n / 1024.0, (double)total() * rate,
+                 (double)peakTotalBytes / 1024.0, peakMBps);
+    for(int c=0;c<kUploadCategories;++c){
+        if(peakFrameBytes[c] == 0) continue;
+        std::fprintf(out, " | %s %.1f KB/frame %.2f MB/s peak %.1f KB", kCategoryNames[c],
+                     (double)bytes[c] / n / 1024.0, (double)bytes[c] * rate, (double)peakFrameBytes[c] / 1024.0);
+    }
+    std::fprintf(out, "\n");
+}
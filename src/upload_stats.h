@@ -0,0 +1,38 @@
+// Per-frame accounting of bytes sent to the GPU.
+//
+// Every upload site calls countUpload() next to its glBufferSubData /
+// glBufferData / glTex*Image / mapped write, tagged with a category. The app
+// closes each frame with endUploadFrame(), which folds the frame into a
+// periodic window and the whole-run totals (bytes, per-frame peaks, MB/s).
+// Uploads made before the first endUploadFrame() are startup data and are kept
+// apart. GL thread only: the counters are plain integers.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+enum class UploadCategory { Vertex, Uniform, Texture, Mapped, Count };
+constexpr int kUploadCategories = (int)UploadCategory::Count;
+
+struct UploadReport {
+    long frames = 0;
+    double seconds = 0;
+    uint64_t bytes[kUploadCategories] = {};
+    uint64_t peakFrameBytes[kUploadCategories] = {};
+    uint64_t peakTotalBytes = 0;        // largest single frame, all categories
+    double peakMBps = 0;                // largest single-frame rate
+
+    uint64_t total() const;
+    void print(std::FILE* out, const char* label) const;
+};
+
+void countUpload(UploadCategory c, size_t bytes);
+// Bytes counted so far in the open frame, all categories
+uint64_t uploadFrameBytes();
+void endUploadFrame(double frameSeconds);
+uint64_t startupUploadBytes();
+
+const UploadReport& uploadWindow();
+const UploadReport& uploadRun();
+void restartUploadWindow();